@@ -6,6 +6,16 @@
 #include "hardware/i2c.h"
 #include "hardware/timer.h"
 #include "inc/ssd1306.h"
+#include "inc/eventos.h"
+#include "inc/servico_display.h"
+#include "inc/fases.h"
+#include "inc/roda_tempo.h"
+#include "inc/cruzamento.h"
+#include "inc/rastro.h"
+#include "inc/log.h"
+#include "inc/energia.h"
+#include "inc/botoes.h"
+#include "inc/buzzer.h"
 
 // Definição dos pinos utilizados no projeto
 #define LED_VERMELHO 13 // LED representando o sinal vermelho
@@ -19,267 +29,217 @@
 const uint I2C_SDA = 14;
 const uint I2C_SCL = 15;
 
-// Definição dos tempos de controle do semáforo e travessia
-#define TEMPO_VERMELHO     10000 // 10s no vermelho
-#define TEMPO_VERDE        10000 // 10s no verde
-#define TEMPO_AMARELO      3000  // 3s no amarelo
-#define TEMPO_TRAVESSIA    5000  // 5s de travessia para pedestre
-#define INTERVALO_CONTAGEM 1000  // 1s entre cada decremento da contagem
-#define TEMPO_BUZZER       200   // Buzzer ativo por 200ms
-
-// Enumeração dos estados possíveis do semáforo
-typedef enum { 
-    ESTADO_VERMELHO, 
-    ESTADO_VERDE, 
-    ESTADO_AMARELO, 
-    ESTADO_PEDESTRE_A, 
-    ESTADO_PEDESTRE_B 
-} estado_t;
-
-// Variáveis de controle de estado e lógica
-volatile estado_t estado_atual = ESTADO_VERMELHO;
-volatile bool pedido_A = false;
-volatile bool pedido_B = false;
-volatile int contagem_regressiva = 0;
-volatile bool aguardando_fim_contagem = false;
-volatile bool usar_buzzer_a = true;
-volatile uint current_buzzer_gpio = BUZZER_A;
-
-// Instâncias dos temporizadores
-repeating_timer_t timer;
-repeating_timer_t contagem_timer;
-repeating_timer_t buzzer_timer;
-
-// Prototipação das funções utilizadas
-bool timer_callback(repeating_timer_t *rt);
-bool contagem_callback(repeating_timer_t *rt);
-void atualizar_display(const char* status, int contagem);
-
-// Callback dos botões de pedestre com prioridade para Botão A (Centro)
-void botao_callback(uint gpio, uint32_t events) {
-    if (gpio == BOTAO_A) {
-        pedido_A = true;
-        pedido_B = false; // Se A foi pressionado, B é ignorado
-        printf("Botao A (Centro) acionado\n");
-        atualizar_display("Botao A\nCentro", 0); // Exibe mensagem no display OLED
-    } else if (gpio == BOTAO_B && !pedido_A) {
-        pedido_B = true;
-        printf("Botao B (Bairro) acionado\n");
-        atualizar_display("Botao B\nBairro", 0); // Exibe mensagem no display OLED
-    }
-}
+// Cruzamentos controlados por esta placa; os tempos das fases ficam na tabela de transições
+// (inc/fases.h). Para mais cruzamentos, acrescente linhas com seus pinos e defasagens.
+static const cruzamento_config_t configuracoes[] = {
+    { LED_VERMELHO, LED_VERDE, BOTAO_A, BOTAO_B, BUZZER_A, BUZZER_B, 0, true },
+};
 
-// Callback para desligar o buzzer após o tempo configurado
-bool buzzer_off_callback(repeating_timer_t *rt) {
-    gpio_put(current_buzzer_gpio, 0); // Desliga o buzzer atual
-    return false;
-}
+#define N_CRUZAMENTOS count_of(configuracoes)
+static_assert(N_CRUZAMENTOS <= cruzamentos_max, "cruzamentos demais");
 
-// Função para emitir pulso sonoro alternando entre dois buzzers
-void buzzer_pulse() {
-    current_buzzer_gpio = usar_buzzer_a ? BUZZER_A : BUZZER_B;
-    usar_buzzer_a = !usar_buzzer_a;
-    gpio_put(current_buzzer_gpio, 1); // Liga o buzzer
-    add_repeating_timer_ms(-TEMPO_BUZZER, buzzer_off_callback, NULL, &buzzer_timer); // Desliga após 200ms
-}
+cruzamento_t cruzamentos[N_CRUZAMENTOS];
 
-// Atualiza o display OLED com a mensagem de status e contagem regressiva, se houver
-void atualizar_display(const char* status, int contagem) {
-    struct render_area area = {
-        .start_column = 0,
-        .end_column = ssd1306_width - 1,
-        .start_page = 0,
-        .end_page = ssd1306_n_pages - 1
-    };
-
-    calculate_render_area_buffer_length(&area);
-    uint8_t buffer[ssd1306_buffer_length];
-    memset(buffer, 0, ssd1306_buffer_length); // Limpa o buffer antes de desenhar
-
-    ssd1306_draw_string(buffer, 0, 0, (char*)status); // Exibe o status na primeira linha
-
-    if (contagem > 0) {
-        char countdown_str[16];
-        sprintf(countdown_str, "Tempo: %d", contagem);
-        ssd1306_draw_string(buffer, 0, 16, countdown_str); // Exibe a contagem na segunda linha
-    }
+// Instante (desde o reset) em que todos os cruzamentos estavam no vermelho
+static uint32_t vermelho_us;
 
-    render_on_display(buffer, &area); // Renderiza no display OLED
-    printf("%s\n", status); // Também imprime no Monitor Serial
-}
-// Atualiza os LEDs e o display conforme o estado atual do semaforo
-void atualiza_semaforo(estado_t estado) {
-    const char* display_status = "";
-
-    switch (estado) {
-        case ESTADO_VERMELHO:
-            gpio_put(LED_VERMELHO, 1);
-            gpio_put(LED_VERDE, 0);
-            display_status = "Sinal:\nVermelho";
-            break;
-        case ESTADO_VERDE:
-            gpio_put(LED_VERMELHO, 0);
-            gpio_put(LED_VERDE, 1);
-            display_status = "Sinal:\nVerde";
-            break;
-        case ESTADO_AMARELO:
-            gpio_put(LED_VERMELHO, 1);
-            gpio_put(LED_VERDE, 1); // Amarelo é a combinação de vermelho + verde
-            display_status = "Sinal:\nAmarelo";
-            break;
-        case ESTADO_PEDESTRE_A:
-            gpio_put(LED_VERMELHO, 1);
-            gpio_put(LED_VERDE, 0);
-            display_status = "Travessia\nCentro";
-            break;
-        case ESTADO_PEDESTRE_B:
-            gpio_put(LED_VERMELHO, 1);
-            gpio_put(LED_VERDE, 0);
-            display_status = "Travessia\nBairro";
-            break;
-    }
+// As interrupções apenas postam eventos; todo o trabalho (LEDs, display e rearme dos
+// temporizadores) é feito no laço principal, e as mensagens saem pelo log diferido
 
-    atualizar_display(display_status, contagem_regressiva);
+// Callback dos botões de pedestre sem máquina de estados da PIO (cada repique é uma borda;
+// os repiques mais próximos que cruzamento_repique_ms são ignorados pelo cruzamento)
+void botao_callback(uint gpio, uint32_t events) {
+    rastro_registrar(RASTRO_IRQ_ENTRADA, RASTRO_FONTE_GPIO << 8 | gpio);
+    log_depuracao("IRQ do botao: gpio %u", gpio);
+    eventos_postar(EVENTO_BOTAO, gpio);
+    rastro_registrar(RASTRO_IRQ_SAIDA, RASTRO_FONTE_GPIO << 8 | gpio);
 }
 
-// Callback para a contagem regressiva de travessia do pedestre
-bool contagem_callback(repeating_timer_t *rt) {
-    if (contagem_regressiva > 0) {
-        printf("Contagem Regressiva: %d\n", contagem_regressiva);
-        buzzer_pulse(); // Emite aviso sonoro a cada segundo
-
-        atualizar_display(
-            (estado_atual == ESTADO_PEDESTRE_A) ? "Travessia\nCentro" : "Travessia\nBairro", 
-            contagem_regressiva
-        );
-        contagem_regressiva--;
-        return true; // Continua a contagem
-    } else {
-        aguardando_fim_contagem = false;
-        add_repeating_timer_ms(-1, timer_callback, NULL, &timer); // Retorna ao ciclo normal
-        return false;
+// Encaminha o botão pressionado ao cruzamento que o possui
+void processar_botao(uint gpio) {
+    for (size_t i = 0; i < N_CRUZAMENTOS; i++) {
+        if (configuracoes[i].botao_a == gpio) {
+            cruzamento_pedir(&cruzamentos[i], PEDIDO_A);
+        } else if (configuracoes[i].botao_b == gpio) {
+            cruzamento_pedir(&cruzamentos[i], PEDIDO_B);
+        }
     }
 }
 
-// Callback principal que controla todo o fluxo do semaforo
-bool timer_callback(repeating_timer_t *rt) {
-    static bool em_travessia = false;
-
-    if (aguardando_fim_contagem) return false;
-
-    if (!em_travessia && (pedido_A || pedido_B)) {
-        // Tratamento dos pedidos de travessia, priorizando o Botao A
-        if (pedido_A) {
-            estado_atual = ESTADO_AMARELO;
-            atualiza_semaforo(ESTADO_AMARELO);
-            em_travessia = true;
-            pedido_A = false;
-            estado_atual = ESTADO_PEDESTRE_A;
-        } else if (pedido_B) {
-            estado_atual = ESTADO_AMARELO;
-            atualiza_semaforo(ESTADO_AMARELO);
-            em_travessia = true;
-            pedido_B = false;
-            estado_atual = ESTADO_PEDESTRE_B;
-        }
-        add_repeating_timer_ms(-TEMPO_AMARELO, timer_callback, NULL, &timer);
-    } 
-    else if (em_travessia) {
-        atualiza_semaforo(estado_atual);
-        add_repeating_timer_ms(-TEMPO_TRAVESSIA, timer_callback, NULL, &timer);
-
-        contagem_regressiva = TEMPO_TRAVESSIA / 1000;
-        aguardando_fim_contagem = true;
-        usar_buzzer_a = true;
-        add_repeating_timer_ms(-INTERVALO_CONTAGEM, contagem_callback, NULL, &contagem_timer);
-
-        em_travessia = false;
-    } 
-    else {
-        // Ciclo normal do semaforo
-        switch (estado_atual) {
-            case ESTADO_VERMELHO:
-                estado_atual = ESTADO_VERDE;
-                atualiza_semaforo(ESTADO_VERDE);
-                add_repeating_timer_ms(-TEMPO_VERDE, timer_callback, NULL, &timer);
-                break;
-            case ESTADO_VERDE:
-                estado_atual = ESTADO_AMARELO;
-                atualiza_semaforo(ESTADO_AMARELO);
-                add_repeating_timer_ms(-TEMPO_AMARELO, timer_callback, NULL, &timer);
-                break;
-            default:
-                estado_atual = ESTADO_VERMELHO;
-                atualiza_semaforo(ESTADO_VERMELHO);
-                add_repeating_timer_ms(-TEMPO_VERMELHO, timer_callback, NULL, &timer);
-                break;
+// Imprime a latência entre a interrupção e o tratamento de cada tipo de evento
+void imprimir_latencias() {
+    static const char *nomes[EVENTO_N_TIPOS] = { "Botao", "Fim de fase", "Contagem" };
+
+    for (int tipo = 0; tipo < EVENTO_N_TIPOS; tipo++) {
+        eventos_estatisticas_t e;
+        eventos_obter_estatisticas(tipo, &e);
+        if (e.despachados > 0) {
+            log_info("Latencia %s: %lu eventos, min %lu us, media %lu us, max %lu us", (uintptr_t)nomes[tipo],
+                (unsigned long)e.despachados, (unsigned long)e.latencia_min_us,
+                (unsigned long)(e.latencia_total_us / e.despachados), (unsigned long)e.latencia_max_us);
         }
     }
+    log_info("Eventos descartados: %lu", (unsigned long)eventos_descartados());
+
+    botoes_estatisticas_t botoes;
+    botoes_obter_estatisticas(&botoes);
+    log_info("Botoes (PIO): %lu apertos, %lu interrupcoes, %lu repiques filtrados",
+        (unsigned long)botoes.apertos, (unsigned long)botoes.interrupcoes, (unsigned long)botoes.repiques);
+
+    roda_estatisticas_t roda;
+    roda_obter_estatisticas(&roda);
+    if (roda.disparos > 0) {
+        log_info("Roda: %lu interrupcoes, %lu disparos, atraso medio %lu us, max %lu us, %lu ms em interrupcao",
+            (unsigned long)roda.interrupcoes, (unsigned long)roda.disparos,
+            (unsigned long)(roda.atraso_total_us / roda.disparos), (unsigned long)roda.atraso_max_us,
+            (unsigned long)(roda.ocupado_us / 1000));
+    }
+    if (roda.despertares > 0) {
+        log_info("Despertar (alarme ate interrupcao): media %lu us, max %lu us",
+            (unsigned long)(roda.despertar_total_us / roda.despertares), (unsigned long)roda.despertar_max_us);
+    }
+
+    energia_estatisticas_t energia;
+    energia_obter_estatisticas(&energia);
+    uint32_t corrente_ua = energia_corrente_media_ua(&energia);
+    log_info("Energia (%s): ativo %lu ms, wfi %lu ms, profundo %lu ms, %lu sonos",
+        (uintptr_t)energia_nome_modo(), (unsigned long)(energia.ativo_us / 1000),
+        (unsigned long)(energia.wfi_us / 1000), (unsigned long)(energia.profundo_us / 1000),
+        (unsigned long)energia.sonos);
+    log_info("Corrente media: %lu.%02lu mA, estimativa (nao calibrada)", (unsigned long)(corrente_ua / 1000),
+        (unsigned long)(corrente_ua % 1000 / 10));
+
+    cruzamento_imprimir_atrasos(&cruzamentos[0]);
+    cruzamento_imprimir_esperas(&cruzamentos[0]);
+
+    servico_display_estatisticas_t display;
+    servico_display_obter_estatisticas(&display);
+    log_info("Display (core1): %lu pedidos, %lu quadros, desenho max %lu us, pedido ate fim max %lu us",
+        (unsigned long)display.pedidos, (unsigned long)display.renderizados,
+        (unsigned long)display.render_max_us, (unsigned long)display.pedido_ate_fim_max_us);
+    if (display.renderizados > 0) {
+        log_info("Display (widgets): %lu bytes sujos, por quadro min %lu, media %lu, max %lu",
+            (unsigned long)display.bytes_sujos, (unsigned long)display.bytes_sujos_min,
+            (unsigned long)(display.bytes_sujos / display.renderizados), (unsigned long)display.bytes_sujos_max);
+    }
 
-    return false;
+    log_estatisticas_t log;
+    log_obter_estatisticas(&log);
+    log_info("Log: %lu mensagens, %lu descartadas, ocupacao max %lu de %d",
+        (unsigned long)(log.gravados[LOG_ERRO] + log.gravados[LOG_AVISO] + log.gravados[LOG_INFO] + log.gravados[LOG_DEPURACAO]),
+        (unsigned long)log.descartados, (unsigned long)log.maior_ocupacao, log_capacidade);
 }
 
-// Configuracao inicial do display OLED via I2C
-void setup_display() {
-    i2c_init(i2c1, ssd1306_i2c_clock * 1000);
-    gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
-    gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
-    gpio_pull_up(I2C_SDA);
-    gpio_pull_up(I2C_SCL);
-
-    ssd1306_init();
-
-    struct render_area area = {
-        .start_column = 0,
-        .end_column = ssd1306_width - 1,
-        .start_page = 0,
-        .end_page = ssd1306_n_pages - 1
-    };
-
-    calculate_render_area_buffer_length(&area);
-    uint8_t buffer[ssd1306_buffer_length];
-    memset(buffer, 0, ssd1306_buffer_length);
-    render_on_display(buffer, &area); // Limpa o display na inicializacao
+// Mostra a economia da renderização por diferença e as latências ao fim de uma travessia
+void imprimir_estatisticas() {
+    ssd1306_t *ssd = servico_display_ssd();
+    ssd1306_diff_stats_t stats;
+    ssd1306_get_diff_stats(ssd, &stats);
+    log_info("Display: %lu bytes enviados, %lu evitados",
+        (unsigned long)stats.data_bytes_sent, (unsigned long)stats.data_bytes_skipped);
+
+    ssd1306_bus_stats_t bus;
+    ssd1306_get_transport_stats(ssd, &bus);
+    log_info("%s: %lu transacoes, %lu bytes, ~%lu us de barramento", (uintptr_t)ssd->transport->name,
+        (unsigned long)bus.transactions, (unsigned long)bus.bytes, (unsigned long)ssd1306_transport_time_us(ssd, &bus));
+    log_info("%s a %lu kHz: %lu erros, %lu prazos esgotados, %lu liberacoes, %lu degraus perdidos",
+        (uintptr_t)ssd->transport->name, (unsigned long)ssd->clock_khz, (unsigned long)bus.errors,
+        (unsigned long)bus.timeouts, (unsigned long)bus.recoveries, (unsigned long)bus.clock_drops);
+
+    imprimir_latencias();
 }
 
-// Configuracao inicial dos GPIOs e interrupcoes dos botoes
-void setup_gpio() {
-    gpio_init(LED_VERMELHO);
-    gpio_set_dir(LED_VERMELHO, GPIO_OUT);
+// Relata uma vez, quando o primeiro quadro chega ao display, quanto tempo após o reset cada
+// etapa da partida levou
+void relatar_boot() {
+    static bool relatado;
+    if (relatado) {
+        return;
+    }
 
-    gpio_init(LED_VERDE);
-    gpio_set_dir(LED_VERDE, GPIO_OUT);
+    servico_display_estatisticas_t display;
+    servico_display_obter_estatisticas(&display);
+    if (display.primeiro_quadro_us == 0) {
+        return;
+    }
+    relatado = true;
+    log_info("Boot: vermelho em %lu us, display em %lu us apos %lu tentativas, primeiro quadro em %lu us",
+        (unsigned long)vermelho_us, (unsigned long)display.display_pronto_us,
+        (unsigned long)display.tentativas_display, (unsigned long)display.primeiro_quadro_us);
+}
 
-    gpio_init(BOTAO_A);
-    gpio_set_dir(BOTAO_A, GPIO_IN);
-    gpio_pull_up(BOTAO_A);
+// Encaminha cada evento retirado da fila ao seu tratador; os eventos de temporização levam
+// o índice do cruzamento
+void tratar_evento(const evento_t *evento) {
+    if (evento->tipo == EVENTO_BOTAO) {
+        processar_botao(evento->arg);
+        return;
+    }
 
-    gpio_init(BOTAO_B);
-    gpio_set_dir(BOTAO_B, GPIO_IN);
-    gpio_pull_up(BOTAO_B);
+    cruzamento_t *c = &cruzamentos[evento->arg];
+    if (cruzamento_tratar_evento(c, evento) && c->config->principal) {
+        imprimir_estatisticas();
+    }
+}
 
-    gpio_init(BUZZER_A);
-    gpio_set_dir(BUZZER_A, GPIO_OUT);
-    gpio_put(BUZZER_A, 0);
+// Entrega o botao a uma maquina de estados da PIO (filtro de repique); sem maquina livre,
+// usa a interrupcao de borda do GPIO
+void configurar_botao(uint gpio) {
+    if (gpio == cruzamento_sem_pino) {
+        return;
+    }
+    if (!botoes_adicionar(gpio, botoes_aperto_min_us, botoes_soltura_us)) {
+        gpio_set_irq_enabled_with_callback(gpio, GPIO_IRQ_EDGE_FALL, true, &botao_callback);
+    }
+}
 
-    gpio_init(BUZZER_B);
-    gpio_set_dir(BUZZER_B, GPIO_OUT);
-    gpio_put(BUZZER_B, 0);
+// A PIO anda no clk_sys: filtro dos botoes e tons dos buzzers reajustam seus divisores
+void ajustar_clock_pio() {
+    botoes_ajustar_clock();
+    buzzer_ajustar_clock();
+}
 
-    gpio_set_irq_enabled_with_callback(BOTAO_A, GPIO_IRQ_EDGE_FALL, true, &botao_callback);
-    gpio_set_irq_enabled(BOTAO_B, GPIO_IRQ_EDGE_FALL, true);
+// Configuracao inicial dos GPIOs e dos botoes
+void setup_gpio() {
+    for (size_t i = 0; i < N_CRUZAMENTOS; i++) {
+        const cruzamento_config_t *config = &configuracoes[i];
+        cruzamento_configurar_pinos(config);
+        configurar_botao(config->botao_a);
+        configurar_botao(config->botao_b);
+    }
+    energia_registrar_clock_callback(ajustar_clock_pio);
 }
 
-// Funcao principal onde tudo comeca
+// Funcao principal onde tudo comeca. A ordem prioriza a luz: vermelho antes de qualquer
+// periferico, semaforo rodando antes do display, e a USB (a mais lenta) por ultimo
 int main() {
-    stdio_init_all(); // Inicializa a comunicacao serial
-    setup_gpio();     // Configura GPIOs
-    setup_display();  // Configura display
+    for (size_t i = 0; i < N_CRUZAMENTOS; i++) {
+        cruzamento_estado_seguro(&configuracoes[i]); // Vermelho aceso microssegundos apos o reset
+    }
+    vermelho_us = time_us_32();
 
-    atualiza_semaforo(ESTADO_VERMELHO); // Inicia com o semaforo em vermelho
-    add_repeating_timer_ms(-TEMPO_VERMELHO, timer_callback, NULL, &timer); // Inicia o ciclo
+    energia_iniciar(); // Antes dos perifericos: no modo profundo, clk_peri deixa de depender do clk_sys
+    setup_gpio();     // Configura buzzers e botoes
+
+    roda_iniciar(); // Um único alarme de hardware para todos os temporizadores
+    for (size_t i = 0; i < N_CRUZAMENTOS; i++) {
+        // A época comum é a base da roda: prazos em ms inteiros caem exatamente nos ticks
+        cruzamento_iniciar(&cruzamentos[i], i, &configuracoes[i], roda_base_us());
+    }
+
+    servico_display_iniciar(I2C_SDA, I2C_SCL); // Core1 configura o display em segundo plano
+    stdio_init_all(); // Inicializa a comunicacao serial
+    rastro_iniciar(); // 'R' no monitor serial despeja o rastro (com SEMAFORO_RASTRO=1)
 
     while (true) {
-        tight_loop_contents(); // Mantem a CPU em espera; tudo é controlado via interrupcoes e timers
+        evento_t evento;
+        while (eventos_retirar(&evento)) {
+            tratar_evento(&evento); // Executa a maquina de estados e o display fora das interrupcoes
+        }
+        rastro_atender();
+        relatar_boot();
+        if (log_drenar() == 0) { // Formata e envia as mensagens pendentes fora das interrupcoes
+            energia_ocioso();     // Dorme ate a proxima interrupcao (modo em ENERGIA_MODO)
+        }
     }
-}
\ No newline at end of file
+}
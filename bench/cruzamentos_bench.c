@@ -0,0 +1,163 @@
+// Benchmark da roda de temporização: roda 1, 2, 4, 8 e 16 cruzamentos virtuais (sem pinos),
+// com pedidos de pedestre pseudoaleatórios, e mede a carga de CPU e o atraso dos temporizadores
+//
+// Na placa a carga é medida pelo relógio do RP2040. No simulador de host o relógio é virtual e
+// não avança durante o código, então a coluna cpu_host_us traz o tempo de CPU do host gasto
+// por segundo simulado, útil para comparar o crescimento com a quantidade de cruzamentos.
+// A coluna listas_busca é o custo da busca do próximo tick armado: quantas listas de posição,
+// em média, cada busca percorreu (o mapa de ocupadas pula as vazias sem visitá-las).
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+#include "eventos.h"
+#include "fases.h"
+#include "roda_tempo.h"
+#include "cruzamento.h"
+
+#ifdef SEMAFORO_SIM
+#include <time.h>
+#endif
+
+#ifndef BENCH_DURACAO_S
+#define BENCH_DURACAO_S 60 // Duração de cada rodada
+#endif
+
+#define BENCH_PEDESTRE_MIN_MS 5000  // Intervalo mínimo entre pedidos em um cruzamento
+#define BENCH_PEDESTRE_MAX_MS 60000 // Intervalo máximo entre pedidos em um cruzamento
+#define BENCH_DEFASAGEM_MS    1500  // Defasagem entre cruzamentos vizinhos
+
+static const uint8_t quantidades[] = { 1, 2, 4, 8, 16 };
+
+static cruzamento_config_t configuracoes[cruzamentos_max];
+static cruzamento_t cruzamentos[cruzamentos_max];
+static roda_temporizador_t pedestres[cruzamentos_max];
+static uint32_t semente = 12345;
+
+// Gerador congruente linear (chamado só na interrupção do alarme e antes de cada rodada)
+static uint32_t aleatorio() {
+    semente = semente * 1664525u + 1013904223u;
+    return semente >> 8;
+}
+
+static uint64_t intervalo_pedestre_us() {
+    return (BENCH_PEDESTRE_MIN_MS + aleatorio() % (BENCH_PEDESTRE_MAX_MS - BENCH_PEDESTRE_MIN_MS)) * 1000ull;
+}
+
+// Pedestre virtual: posta um pedido (cruzamento nos bits 0..7, pedido nos bits 8..15) e se rearma
+static void pedestre_callback(roda_temporizador_t *t) {
+    uint32_t indice = (uint32_t)(uintptr_t)t->dados;
+    pedido_t pedido = (aleatorio() & 1) ? PEDIDO_A : PEDIDO_B;
+    eventos_postar(EVENTO_BOTAO, indice | (pedido << 8));
+    roda_armar(t, t->prazo_us + intervalo_pedestre_us(), pedestre_callback, t->dados);
+}
+
+#ifdef SEMAFORO_SIM
+static uint64_t cpu_host_us() {
+    return (uint64_t)clock() * 1000000u / CLOCKS_PER_SEC;
+}
+#endif
+
+// Executa uma rodada com n cruzamentos e imprime uma linha da tabela
+static void rodar(uint n) {
+    // Época no próximo tick da roda, para os prazos caírem exatamente nos ticks
+    uint64_t ticks = (time_us_64() - roda_base_us()) / roda_tick_us + 2;
+    uint64_t epoca_us = roda_base_us() + ticks * roda_tick_us;
+    uint64_t fim_us = epoca_us + BENCH_DURACAO_S * 1000000ull;
+
+    roda_zerar_estatisticas();
+    eventos_zerar_estatisticas();
+    uint32_t descartados_inicio = eventos_descartados();
+    for (uint i = 0; i < n; i++) {
+        configuracoes[i] = (cruzamento_config_t){
+            cruzamento_sem_pino, cruzamento_sem_pino, cruzamento_sem_pino,
+            cruzamento_sem_pino, cruzamento_sem_pino, cruzamento_sem_pino,
+            i * BENCH_DEFASAGEM_MS, false,
+        };
+        cruzamento_iniciar(&cruzamentos[i], i, &configuracoes[i], epoca_us);
+        roda_armar(&pedestres[i], epoca_us + intervalo_pedestre_us(), pedestre_callback, (void *)(uintptr_t)i);
+    }
+
+#ifdef SEMAFORO_SIM
+    uint64_t cpu_inicio = cpu_host_us();
+#endif
+    uint64_t ocupado_laco_us = 0;
+
+    while (time_us_64() < fim_us) {
+        evento_t evento;
+        while (eventos_retirar(&evento)) {
+            uint64_t inicio = time_us_64();
+            if (evento.tipo == EVENTO_BOTAO) {
+                cruzamento_pedir(&cruzamentos[evento.arg & 0xFF], (pedido_t)(evento.arg >> 8));
+            } else {
+                cruzamento_tratar_evento(&cruzamentos[evento.arg], &evento);
+            }
+            ocupado_laco_us += time_us_64() - inicio;
+        }
+        tight_loop_contents();
+    }
+
+#ifdef SEMAFORO_SIM
+    uint64_t cpu_us = cpu_host_us() - cpu_inicio;
+#endif
+
+    // Maior e médio atraso das transições de fase somando todos os cruzamentos
+    uint32_t transicoes = 0, transicao_max_us = 0;
+    uint64_t transicao_total_us = 0;
+    for (uint i = 0; i < n; i++) {
+        roda_cancelar(&pedestres[i]);
+        cruzamento_parar(&cruzamentos[i]);
+        for (int f = 0; f < FASE_N; f++) {
+            const cruzamento_atraso_t *a = &cruzamentos[i].atrasos[f];
+            transicoes += a->transicoes;
+            transicao_total_us += a->atraso_total_us;
+            if (a->atraso_max_us > transicao_max_us) transicao_max_us = a->atraso_max_us;
+        }
+    }
+
+    roda_estatisticas_t roda;
+    roda_obter_estatisticas(&roda);
+    uint64_t duracao_us = BENCH_DURACAO_S * 1000000ull;
+    uint32_t carga_milesimos = (uint32_t)((roda.ocupado_us + ocupado_laco_us) * 1000 / duracao_us);
+
+    uint64_t listas_centesimos = roda.buscas ? roda.listas_visitadas * 100 / roda.buscas : 0;
+    printf("%11u %9lu %13lu %13lu %13lu %16lu %9llu %9llu %6lu.%lu %11lu %9llu.%02llu",
+        n, (unsigned long)roda.disparos,
+        (unsigned long)(roda.disparos ? roda.atraso_total_us / roda.disparos : 0), (unsigned long)roda.atraso_max_us,
+        (unsigned long)(transicoes ? transicao_total_us / transicoes : 0), (unsigned long)transicao_max_us,
+        (unsigned long long)roda.ocupado_us, (unsigned long long)ocupado_laco_us,
+        (unsigned long)(carga_milesimos / 10), (unsigned long)(carga_milesimos % 10),
+        (unsigned long)(eventos_descartados() - descartados_inicio),
+        (unsigned long long)(listas_centesimos / 100), (unsigned long long)(listas_centesimos % 100));
+#ifdef SEMAFORO_SIM
+    printf(" %11llu", (unsigned long long)(cpu_us / BENCH_DURACAO_S));
+#endif
+    printf("\n");
+}
+
+int main() {
+    stdio_init_all();
+    sleep_ms(2000); // Tempo para o monitor serial conectar
+
+    roda_iniciar();
+
+    printf("Benchmark da roda de temporizacao: %d s por rodada, tick de %d us\n", BENCH_DURACAO_S, roda_tick_us);
+    printf("cruzamentos  disparos atraso_med_us atraso_max_us transicao_med transicao_max_us    irq_us   laco_us carga_%% descartados listas_busca");
+#ifdef SEMAFORO_SIM
+    printf(" cpu_host_us");
+#endif
+    printf("\n");
+
+    for (size_t i = 0; i < count_of(quantidades); i++) {
+        rodar(quantidades[i]);
+    }
+
+    printf("Fim do benchmark\n");
+#ifdef SEMAFORO_SIM
+    return 0;
+#else
+    while (true) {
+        tight_loop_contents();
+    }
+#endif
+}
@@ -0,0 +1,288 @@
+// Benchmark das primitivas de desenho do SSD1306: cada operação roda pelo caminho por pixel
+// (ssd1306_set_pixel, como o desenho era feito) e pela primitiva por bytes/palavras, que
+// precisa deixar o framebuffer idêntico
+//
+// Na placa o custo sai em ciclos de clk_sys por operação. No simulador de host o relógio é
+// virtual, então as colunas trazem nanossegundos de CPU do host por operação; a razão entre os
+// dois caminhos é o número comparável entre as duas plataformas.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "ssd1306.h"
+
+#ifdef SEMAFORO_SIM
+#include <time.h>
+#endif
+
+#ifndef BENCH_REPETICOES
+#define BENCH_REPETICOES 2000 // Repetições de cada operação por medida
+#endif
+
+// Como no ssd1306_t, os framebuffers começam um byte depois do alinhamento (o byte de controle
+// vem antes), então as primitivas passam pelos bytes avulsos antes das palavras
+static uint8_t memoria_pixel[ssd1306_buffer_length + 1] __attribute__((aligned(4)));
+static uint8_t memoria_rapido[ssd1306_buffer_length + 1] __attribute__((aligned(4)));
+static uint8_t *const quadro_pixel = memoria_pixel + 1;
+static uint8_t *const quadro_rapido = memoria_rapido + 1;
+static uint8_t quadro_inicial[ssd1306_buffer_length];
+
+// Display sobre o transporte simulado, para conferir ssd1306_blit e ssd1306_draw_bitmap_region
+static ssd1306_t display_mock;
+static ssd1306_mock_t mock;
+
+// Resultado descartável que impede o compilador de eliminar as repetições
+static volatile uint8_t sumidouro;
+
+#ifdef SEMAFORO_SIM
+static uint64_t agora() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+// Nanossegundos do host por operação
+static uint32_t custo(uint64_t inicio, uint64_t fim) {
+    return (uint32_t)((fim - inicio) / BENCH_REPETICOES);
+}
+#else
+static uint64_t agora() {
+    return time_us_64();
+}
+
+// Ciclos de clk_sys por operação
+static uint32_t custo(uint64_t inicio, uint64_t fim) {
+    return (uint32_t)((fim - inicio) * (clock_get_hz(clk_sys) / 1000000) / BENCH_REPETICOES);
+}
+#endif
+
+static bool ler_pixel(const uint8_t *ssd, int x, int y) {
+    return (ssd[(y / 8) * ssd1306_width + x] >> (y % 8)) & 1;
+}
+
+// Caminho por pixel de referência, recortado à tela como as primitivas
+static void pixel(uint8_t *ssd, int x, int y, bool set) {
+    if (x >= 0 && x < ssd1306_width && y >= 0 && y < ssd1306_height) {
+        ssd1306_set_pixel(ssd, x, y, set);
+    }
+}
+
+static void pixel_retangulo(uint8_t *ssd, int x, int y, int w, int h, bool set) {
+    for (int j = y; j < y + h; j++) {
+        for (int i = x; i < x + w; i++) {
+            pixel(ssd, i, j, set);
+        }
+    }
+}
+
+// Bresenham chamando ssd1306_set_pixel a cada passo, como ssd1306_draw_line fazia
+static void pixel_linha(uint8_t *ssd, int x_0, int y_0, int x_1, int y_1, bool set) {
+    int dx = abs(x_1 - x_0), dy = -abs(y_1 - y_0);
+    int sx = x_0 < x_1 ? 1 : -1, sy = y_0 < y_1 ? 1 : -1;
+    int error = dx + dy;
+    while (true) {
+        pixel(ssd, x_0, y_0, set);
+        if (x_0 == x_1 && y_0 == y_1) {
+            break;
+        }
+        int error_2 = 2 * error;
+        if (error_2 >= dy) {
+            error += dy;
+            x_0 += sx;
+        }
+        if (error_2 <= dx) {
+            error += dx;
+            y_0 += sy;
+        }
+    }
+}
+
+// Operações medidas: os dois caminhos recebem o mesmo framebuffer inicial
+static void pixel_preencher(uint8_t *ssd) { pixel_retangulo(ssd, 0, 0, ssd1306_width, ssd1306_height, true); }
+static void rapido_preencher(uint8_t *ssd) { ssd1306_fill(ssd, true); }
+
+static void pixel_horizontal(uint8_t *ssd) { pixel_retangulo(ssd, 3, 13, 122, 1, true); }
+static void rapido_horizontal(uint8_t *ssd) { ssd1306_draw_hline(ssd, 3, 13, 122, true); }
+
+static void pixel_vertical(uint8_t *ssd) { pixel_retangulo(ssd, 70, 2, 1, 59, false); }
+static void rapido_vertical(uint8_t *ssd) { ssd1306_draw_vline(ssd, 70, 2, 59, false); }
+
+static void pixel_retangulo_cheio(uint8_t *ssd) { pixel_retangulo(ssd, 10, 5, 100, 40, true); }
+static void rapido_retangulo_cheio(uint8_t *ssd) { ssd1306_fill_rect(ssd, 10, 5, 100, 40, true); }
+
+static void pixel_recortado(uint8_t *ssd) { pixel_retangulo(ssd, -5, 61, 140, 9, true); }
+static void rapido_recortado(uint8_t *ssd) { ssd1306_fill_rect(ssd, -5, 61, 140, 9, true); }
+
+static void pixel_contorno(uint8_t *ssd) {
+    pixel_retangulo(ssd, 5, 3, 118, 1, true);
+    pixel_retangulo(ssd, 5, 60, 118, 1, true);
+    pixel_retangulo(ssd, 5, 4, 1, 56, true);
+    pixel_retangulo(ssd, 122, 4, 1, 56, true);
+}
+static void rapido_contorno(uint8_t *ssd) { ssd1306_draw_rect(ssd, 5, 3, 118, 58, true); }
+
+static void pixel_inverter(uint8_t *ssd) {
+    for (int y = 10; y < 40; y++) {
+        for (int x = 20; x < 84; x++) {
+            pixel(ssd, x, y, !ler_pixel(ssd, x, y));
+        }
+    }
+}
+static void rapido_inverter(uint8_t *ssd) { ssd1306_invert_rect(ssd, 20, 10, 64, 30); }
+
+static void pixel_progresso(uint8_t *ssd) {
+    const int x = 4, y = 40, w = 120, h = 12, preenchido = 37 * (w - 2) / 100;
+    pixel_retangulo(ssd, x, y, w, 1, true);
+    pixel_retangulo(ssd, x, y + h - 1, w, 1, true);
+    pixel_retangulo(ssd, x, y + 1, 1, h - 2, true);
+    pixel_retangulo(ssd, x + w - 1, y + 1, 1, h - 2, true);
+    pixel_retangulo(ssd, x + 1, y + 1, preenchido, h - 2, true);
+    pixel_retangulo(ssd, x + 1 + preenchido, y + 1, w - 2 - preenchido, h - 2, false);
+}
+static void rapido_progresso(uint8_t *ssd) { ssd1306_draw_progress(ssd, 4, 40, 120, 12, 37, 100); }
+
+static void pixel_linha_horizontal(uint8_t *ssd) { pixel_linha(ssd, 120, 33, 2, 33, true); }
+static void rapido_linha_horizontal(uint8_t *ssd) { ssd1306_draw_line(ssd, 120, 33, 2, 33, true); }
+
+static void pixel_linha_diagonal(uint8_t *ssd) { pixel_linha(ssd, 0, 0, 127, 63, true); }
+static void rapido_linha_diagonal(uint8_t *ssd) { ssd1306_draw_line(ssd, 0, 0, 127, 63, true); }
+
+typedef struct {
+    const char *nome;
+    void (*pixel)(uint8_t *ssd);
+    void (*rapido)(uint8_t *ssd);
+} operacao_t;
+
+// Bitmaps copiados por ssd1306_draw_bitmap_region: y fora do múltiplo de 8 (byte dividido entre
+// duas páginas), y negativo, última página parcial e recortes nas bordas
+typedef struct {
+    const char *nome;
+    int x, y, w, h;
+} recorte_t;
+
+static const recorte_t recortes[] = {
+    { "alinhado", 16, 8, 24, 16 },
+    { "y_impar", 10, 3, 13, 11 },
+    { "y_negativo", 30, -5, 20, 12 },
+    { "canto_sup", -4, -3, 12, 9 },
+    { "canto_inf", 120, 58, 16, 16 },
+    { "fim_parcial", 40, 61, 9, 9 },
+    { "uma_linha", -3, 20, 7, 1 },
+    { "acima", 50, -10, 8, 5 },
+    { "abaixo", 50, 64, 8, 5 },
+};
+
+// Referência por pixel: cada bit do bitmap (bitmap[página * w + coluna], bit 0 no alto) vira
+// um ssd1306_set_pixel, recortado à tela
+static void pixel_bitmap(uint8_t *ssd, const uint8_t *bitmap, int x, int y, int w, int h) {
+    for (int linha = 0; linha < h; linha++) {
+        for (int coluna = 0; coluna < w; coluna++) {
+            pixel(ssd, x + coluna, y + linha, (bitmap[(linha / 8) * w + coluna] >> (linha % 8)) & 1);
+        }
+    }
+}
+
+// Copia o bitmap pelo driver e confere o framebuffer contra a referência por pixel e a memória
+// do display simulado contra o framebuffer; fora da tela nada pode ir ao barramento
+static bool conferir_recorte(const recorte_t *r, uint32_t *semente) {
+    uint8_t bitmap[ssd1306_buffer_length];
+    for (int i = 0; i < (r->h + 7) / 8 * r->w; i++) {
+        *semente = *semente * 1664525u + 1013904223u;
+        bitmap[i] = (uint8_t)(*semente >> 24);
+    }
+
+    memcpy(quadro_pixel, quadro_inicial, ssd1306_buffer_length);
+    pixel_bitmap(quadro_pixel, bitmap, r->x, r->y, r->w, r->h);
+
+    memcpy(display_mock.ram_buffer + 1, quadro_inicial, ssd1306_buffer_length);
+    ssd1306_send_data(&display_mock);
+    uint32_t transacoes = mock.transactions;
+    ssd1306_draw_bitmap_region(&display_mock, bitmap, r->x, r->y, r->w, r->h);
+
+    const bool fora = r->y + r->h <= 0 || r->y >= ssd1306_height || r->x + r->w <= 0 || r->x >= ssd1306_width;
+    return memcmp(quadro_pixel, display_mock.ram_buffer + 1, ssd1306_buffer_length) == 0 &&
+           memcmp(mock.gddram, display_mock.ram_buffer + 1, ssd1306_buffer_length) == 0 &&
+           (!fora || mock.transactions == transacoes);
+}
+
+static const operacao_t operacoes[] = {
+    { "preencher", pixel_preencher, rapido_preencher },
+    { "linha_h", pixel_horizontal, rapido_horizontal },
+    { "linha_v", pixel_vertical, rapido_vertical },
+    { "retangulo", pixel_retangulo_cheio, rapido_retangulo_cheio },
+    { "recortado", pixel_recortado, rapido_recortado },
+    { "contorno", pixel_contorno, rapido_contorno },
+    { "inverter", pixel_inverter, rapido_inverter },
+    { "progresso", pixel_progresso, rapido_progresso },
+    { "reta_horiz", pixel_linha_horizontal, rapido_linha_horizontal },
+    { "reta_diag", pixel_linha_diagonal, rapido_linha_diagonal },
+};
+
+// Custo médio de BENCH_REPETICOES execuções sobre o framebuffer
+static uint32_t medir(void (*operacao)(uint8_t *ssd), uint8_t *quadro) {
+    uint64_t inicio = agora();
+    for (int i = 0; i < BENCH_REPETICOES; i++) {
+        operacao(quadro);
+        sumidouro = quadro[i % ssd1306_buffer_length];
+    }
+    return custo(inicio, agora());
+}
+
+int main() {
+    stdio_init_all();
+    sleep_ms(2000); // Tempo para o monitor serial conectar
+
+    // Padrão inicial pseudoaleatório, para as primitivas não partirem de bytes uniformes
+    uint32_t semente = 12345;
+    for (int i = 0; i < ssd1306_buffer_length; i++) {
+        semente = semente * 1664525u + 1013904223u;
+        quadro_inicial[i] = (uint8_t)(semente >> 24);
+    }
+
+#ifdef SEMAFORO_SIM
+    const char *unidade = "ns_host";
+#else
+    const char *unidade = "ciclos";
+#endif
+    printf("Benchmark das primitivas de desenho: %d repeticoes, custo em %s por operacao\n", BENCH_REPETICOES, unidade);
+    printf("operacao    por_pixel   rapido  ganho  quadro\n");
+
+    uint32_t diferentes = 0;
+    for (size_t i = 0; i < count_of(operacoes); i++) {
+        const operacao_t *op = &operacoes[i];
+
+        // Uma execução de cada caminho sobre o mesmo quadro inicial: o resultado precisa coincidir
+        memcpy(quadro_pixel, quadro_inicial, ssd1306_buffer_length);
+        memcpy(quadro_rapido, quadro_inicial, ssd1306_buffer_length);
+        op->pixel(quadro_pixel);
+        op->rapido(quadro_rapido);
+        bool igual = memcmp(quadro_pixel, quadro_rapido, ssd1306_buffer_length) == 0;
+        diferentes += !igual;
+
+        uint32_t custo_pixel = medir(op->pixel, quadro_pixel);
+        uint32_t custo_rapido = medir(op->rapido, quadro_rapido);
+        uint32_t ganho_decimos = custo_rapido ? custo_pixel * 10 / custo_rapido : 0;
+        printf("%-10s %10lu %8lu %4lu.%lux  %s\n", op->nome, (unsigned long)custo_pixel, (unsigned long)custo_rapido,
+            (unsigned long)(ganho_decimos / 10), (unsigned long)(ganho_decimos % 10), igual ? "igual" : "DIFERENTE");
+    }
+
+    ssd1306_init_mock(&display_mock, ssd1306_width, ssd1306_height, &mock);
+    printf("Bitmaps por ssd1306_draw_bitmap_region\n");
+    printf("recorte        x    y    w    h  quadro\n");
+    for (size_t i = 0; i < count_of(recortes); i++) {
+        const recorte_t *r = &recortes[i];
+        bool igual = conferir_recorte(r, &semente);
+        diferentes += !igual;
+        printf("%-11s %4d %4d %4d %4d  %s\n", r->nome, r->x, r->y, r->w, r->h, igual ? "igual" : "DIFERENTE");
+    }
+
+    printf("Fim do benchmark: %lu operacoes com quadro diferente\n", (unsigned long)diferentes);
+#ifdef SEMAFORO_SIM
+    return 0;
+#else
+    while (true) {
+        tight_loop_contents();
+    }
+#endif
+}
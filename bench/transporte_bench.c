@@ -0,0 +1,293 @@
+// Benchmark dos transportes do SSD1306: as mesmas cargas de desenho enviadas pelo I2C (a
+// ssd1306_i2c_clock) e pelo SPI (a ssd1306_spi_clock), bloqueando e por DMA, e pelo transporte
+// simulado, que mede só o custo do driver e confere o que chegaria à memória do display
+//
+// Na placa os tempos são reais: o I2C precisa do display ligado, o SPI (sem confirmação) roda
+// mesmo sem painel. No simulador de host o relógio é virtual e conta só o barramento; o custo
+// do transporte simulado sai em nanossegundos de CPU do host (ciclos de clk_sys na placa).
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "ssd1306.h"
+
+#ifdef SEMAFORO_SIM
+#include <time.h>
+#include "sim.h"
+#endif
+
+#ifndef BENCH_QUADROS
+#define BENCH_QUADROS 60 // Quadros enviados por carga e modo
+#endif
+
+// Pinos da BitDogLab para o I2C; o SPI usa o spi0 nos pinos livres do conector de expansão
+#define I2C_SDA 14
+#define I2C_SCL 15
+#define SPI_SCK 18
+#define SPI_MOSI 19
+#define SPI_CS 17
+#define SPI_DC 20
+
+// Segundo display no mesmo barramento I2C, para os quadros encadeados
+#define I2C_ADDRESS_B 0x3D
+
+static ssd1306_t display_i2c, display_i2c_b, display_spi, display_mock;
+static ssd1306_mock_t mock;
+
+#ifdef SEMAFORO_SIM
+static uint64_t agora_cpu() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+// Nanossegundos do host por quadro
+static uint32_t custo_cpu(uint64_t inicio, uint64_t fim) {
+    return (uint32_t)((fim - inicio) / BENCH_QUADROS);
+}
+#else
+static uint64_t agora_cpu() {
+    return time_us_64();
+}
+
+// Ciclos de clk_sys por quadro
+static uint32_t custo_cpu(uint64_t inicio, uint64_t fim) {
+    return (uint32_t)((fim - inicio) * (clock_get_hz(clk_sys) / 1000000) / BENCH_QUADROS);
+}
+#endif
+
+// Cargas: cada uma altera o framebuffer pelas primitivas de desenho e marca o que mudou
+static void carga_tela_cheia(ssd1306_t *ssd, int quadro) {
+    ssd1306_invert_rect(ssd->ram_buffer + 1, 0, 0, ssd1306_width, ssd1306_height);
+    ssd1306_mark_dirty(ssd, 0, 0, ssd1306_width, ssd1306_height);
+}
+
+static void carga_texto(ssd1306_t *ssd, int quadro) {
+    char texto[24];
+    snprintf(texto, sizeof(texto), "Quadro %d\nTravessia", quadro);
+    ssd1306_fill_rect(ssd->ram_buffer + 1, 0, 0, ssd1306_width, 16, false);
+    ssd1306_draw_string(ssd->ram_buffer + 1, 0, 0, texto);
+    ssd1306_mark_dirty(ssd, 0, 0, ssd1306_width, 16);
+}
+
+static void carga_contagem(ssd1306_t *ssd, int quadro) {
+    ssd1306_fill_rect(ssd->ram_buffer + 1, 48, 40, ssd1306_char_advance, ssd1306_line_height, false);
+    ssd1306_draw_char(ssd->ram_buffer + 1, 48, 40, '0' + quadro % 10);
+    ssd1306_mark_dirty(ssd, 48, 40, ssd1306_char_advance, ssd1306_line_height);
+}
+
+static void carga_barra(ssd1306_t *ssd, int quadro) {
+    ssd1306_draw_progress(ssd->ram_buffer + 1, 4, 52, 120, 10, quadro * 100 / (BENCH_QUADROS - 1), 100);
+    ssd1306_mark_dirty(ssd, 4, 52, 120, 10);
+}
+
+// Fora da tabela: todo byte muda a cada quadro, e nenhum quadro repete um anterior, então um
+// byte que não chega ao display sempre aparece na memória
+static void carga_padrao(ssd1306_t *ssd, int quadro) {
+    for (int i = 0; i < ssd1306_buffer_length; i++) {
+        ssd->ram_buffer[1 + i] = (uint8_t)(quadro * 29 + i);
+    }
+    ssd1306_mark_dirty(ssd, 0, 0, ssd1306_width, ssd1306_height);
+}
+
+typedef struct {
+    const char *nome;
+    void (*desenhar)(ssd1306_t *ssd, int quadro);
+} carga_t;
+
+static const carga_t cargas[] = {
+    { "tela_cheia", carga_tela_cheia },
+    { "texto", carga_texto },
+    { "contagem", carga_contagem },
+    { "barra", carga_barra },
+};
+
+// Envia BENCH_QUADROS quadros da carga, bloqueando ou por DMA; retorna os microssegundos gastos
+// e os bytes no barramento por quadro
+static uint32_t medir(ssd1306_t *ssd, const carga_t *carga, bool dma, uint32_t *bytes_por_quadro) {
+    ssd1306_bus_stats_t antes, depois;
+    ssd1306_flush_wait(ssd);
+    ssd1306_get_transport_stats(ssd, &antes);
+
+    uint64_t inicio = time_us_64();
+    for (int quadro = 0; quadro < BENCH_QUADROS; quadro++) {
+        carga->desenhar(ssd, quadro);
+        if (dma) {
+            ssd1306_flush_async(ssd);
+            ssd1306_flush_wait(ssd); // Um quadro por vez: mede a vazão do barramento
+        } else {
+            ssd1306_flush(ssd);
+        }
+    }
+    uint64_t fim = time_us_64();
+
+    ssd1306_get_transport_stats(ssd, &depois);
+    *bytes_por_quadro = (depois.bytes - antes.bytes) / BENCH_QUADROS;
+    return (uint32_t)(fim - inicio);
+}
+
+// Página do scroll no teste de regiões, a mesma do letreiro de aviso
+#define SCROLL_PAGINA 7
+
+// Desenha regiões por ssd1306_draw_bitmap_region com o scroll rolando: uma fora da faixa e uma
+// que cruza a borda dela (y ímpar). O driver precisa parar o scroll antes dos dados e religá-lo
+// depois; retorna se o scroll seguiu ativo após cada região
+static bool regioes_com_scroll(ssd1306_t *ssd) {
+    static const uint8_t seta[16] = {
+        0x18, 0x18, 0x18, 0x18, 0xFF, 0x7E, 0x3C, 0x18,
+        0x01, 0x03, 0x07, 0x0F, 0x0F, 0x07, 0x03, 0x01,
+    };
+    ssd1306_flush_wait(ssd);
+    ssd1306_scroll_start(ssd, SCROLL_PAGINA, SCROLL_PAGINA, SSD1306_SCROLL_LEFT, SSD1306_SCROLL_5_FRAMES);
+    ssd1306_flush(ssd);
+    sleep_ms(50); // Deixa a faixa girar
+    bool ativo = ssd->scroll.active;
+
+    ssd1306_draw_bitmap_region(ssd, seta, 60, 20, 8, 12);
+    ativo = ativo && ssd->scroll.active;
+    ssd1306_draw_bitmap_region(ssd, seta, 100, SCROLL_PAGINA * 8 - 3, 8, 12);
+    ativo = ativo && ssd->scroll.active;
+
+    ssd1306_scroll_stop(ssd);
+    ssd1306_flush(ssd); // Devolve a faixa deslocada ao quadro
+    return ativo;
+}
+
+// Confere se a memória do display terminou igual ao framebuffer; só o simulador a expõe, e na
+// placa o resultado é sempre true
+static bool conferir_memoria(ssd1306_t *ssd, uint bus, uint8_t endereco) {
+#ifdef SEMAFORO_SIM
+    uint8_t gddram[ssd1306_buffer_length];
+    return sim_ler_display(bus, endereco, gddram) &&
+           memcmp(gddram, ssd->ram_buffer + 1, ssd1306_buffer_length) == 0;
+#else
+    return true;
+#endif
+}
+
+// Limpa o display e inicia o canal de DMA
+static void preparar(ssd1306_t *ssd) {
+    ssd1306_config(ssd);
+    ssd1306_send_data(ssd);
+    ssd1306_init_dma(ssd);
+}
+
+int main() {
+    stdio_init_all();
+    sleep_ms(2000); // Tempo para o monitor serial conectar
+
+    i2c_init(i2c1, ssd1306_i2c_clock * 1000);
+    gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
+    gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
+    gpio_pull_up(I2C_SDA);
+    gpio_pull_up(I2C_SCL);
+    ssd1306_init_bm(&display_i2c, ssd1306_width, ssd1306_height, false, ssd1306_i2c_address, i2c1);
+    preparar(&display_i2c);
+
+    spi_init(spi0, ssd1306_spi_clock * 1000);
+    gpio_set_function(SPI_SCK, GPIO_FUNC_SPI);
+    gpio_set_function(SPI_MOSI, GPIO_FUNC_SPI);
+    ssd1306_init_spi(&display_spi, ssd1306_width, ssd1306_height, false, spi0, SPI_DC, SPI_CS);
+    preparar(&display_spi);
+
+    ssd1306_init_mock(&display_mock, ssd1306_width, ssd1306_height, &mock);
+    preparar(&display_mock);
+
+    ssd1306_init_bm(&display_i2c_b, ssd1306_width, ssd1306_height, false, I2C_ADDRESS_B, i2c1);
+    preparar(&display_i2c_b);
+
+    printf("Benchmark dos transportes do SSD1306: %d quadros por carga, I2C a %lu kHz, SPI a %lu kHz\n",
+        BENCH_QUADROS, (unsigned long)display_i2c.clock_khz, (unsigned long)display_spi.clock_khz);
+    printf("carga       transporte modo  us/quadro  quadros/s  bytes/quadro\n");
+
+    ssd1306_t *displays[] = { &display_i2c, &display_spi };
+    uint32_t tela_cheia_us[2] = { 0, 0 };
+    for (size_t i = 0; i < count_of(cargas); i++) {
+        for (size_t d = 0; d < count_of(displays); d++) {
+            for (int dma = 0; dma <= 1; dma++) {
+                uint32_t bytes;
+                uint32_t us = medir(displays[d], &cargas[i], dma, &bytes);
+                if (i == 0 && dma) {
+                    tela_cheia_us[d] = us;
+                }
+                printf("%-11s %-10s %-5s %9lu %10lu %13lu\n", cargas[i].nome, displays[d]->transport->name,
+                    dma ? "dma" : "bloq", (unsigned long)(us / BENCH_QUADROS),
+                    (unsigned long)(us ? (uint64_t)BENCH_QUADROS * 1000000 / us : 0), (unsigned long)bytes);
+            }
+        }
+    }
+
+#ifdef SEMAFORO_SIM
+    const char *unidade = "ns_host";
+#else
+    const char *unidade = "ciclos";
+#endif
+    // Sem barramento, o transporte simulado isola o custo do driver (diferença e codificação);
+    // a memória reconstruída precisa terminar igual ao framebuffer
+    printf("Transporte simulado, custo do driver em %s por quadro\n", unidade);
+    printf("carga           custo  bytes/quadro  memoria\n");
+    uint32_t diferentes = 0;
+    for (size_t i = 0; i < count_of(cargas); i++) {
+        uint32_t bytes;
+        uint64_t inicio = agora_cpu();
+        medir(&display_mock, &cargas[i], false, &bytes);
+        uint32_t custo = custo_cpu(inicio, agora_cpu());
+
+        bool igual = memcmp(mock.gddram, display_mock.ram_buffer + 1, ssd1306_buffer_length) == 0;
+        diferentes += !igual;
+        printf("%-11s %9lu %13lu  %s\n", cargas[i].nome, (unsigned long)custo, (unsigned long)bytes,
+            igual ? "igual" : "DIFERENTE");
+    }
+
+    // Regiões com o scroll ativo: no simulador de host, escritas na memória com o scroll ligado
+    // aparecem como violações no relatório de cada display
+    printf("Regioes com o scroll ativo na pagina %d\n", SCROLL_PAGINA);
+    printf("transporte scroll  memoria\n");
+    ssd1306_t *todos[] = { &display_i2c, &display_spi, &display_mock };
+    for (size_t d = 0; d < count_of(todos); d++) {
+        bool ativo = regioes_com_scroll(todos[d]);
+        bool igual = todos[d] != &display_mock ||
+                     memcmp(mock.gddram, display_mock.ram_buffer + 1, ssd1306_buffer_length) == 0;
+        diferentes += !ativo || !igual;
+        printf("%-10s %-7s %s\n", todos[d]->transport->name, ativo ? "ativo" : "PARADO", igual ? "igual" : "DIFERENTE");
+    }
+
+    // Quadros seguidos por DMA, sem esperar o fim de cada um: o do segundo display I2C fica
+    // pendente e começa no fim do fluxo do primeiro, com a FIFO do I2C recém-esvaziada. Vem por
+    // último para os três displays do simulador terminarem com o mesmo quadro
+    memcpy(display_i2c_b.ram_buffer + 1, display_i2c.ram_buffer + 1, ssd1306_buffer_length);
+    ssd1306_mark_dirty(&display_i2c_b, 0, 0, ssd1306_width, ssd1306_height);
+    ssd1306_t *encadeados[] = { &display_i2c, &display_i2c_b, &display_spi };
+    for (int quadro = 0; quadro < BENCH_QUADROS; quadro++) {
+        for (size_t d = 0; d < count_of(encadeados); d++) {
+            carga_padrao(encadeados[d], quadro);
+            ssd1306_flush_async(encadeados[d]);
+        }
+        for (size_t d = 0; d < count_of(encadeados); d++) {
+            ssd1306_flush_wait(encadeados[d]);
+        }
+    }
+    printf("Quadros encadeados por DMA sem espera: %d por display\n", BENCH_QUADROS);
+    printf("transporte endereco memoria\n");
+    for (size_t d = 0; d < count_of(encadeados); d++) {
+        ssd1306_t *ssd = encadeados[d];
+        const uint8_t endereco = ssd == &display_spi ? SPI_DC : ssd->address;
+        bool igual = conferir_memoria(ssd, ssd->bus, endereco);
+        diferentes += !igual;
+        printf("%-10s 0x%02x     %s\n", ssd->transport->name, endereco, igual ? "igual" : "DIFERENTE");
+    }
+
+    uint32_t ganho_decimos = tela_cheia_us[1] ? tela_cheia_us[0] * 10 / tela_cheia_us[1] : 0;
+    printf("SPI sobre I2C na tela cheia por DMA: %lu.%lux mais quadros por segundo\n",
+        (unsigned long)(ganho_decimos / 10), (unsigned long)(ganho_decimos % 10));
+    printf("Fim do benchmark: %lu cargas com memoria diferente no transporte simulado\n", (unsigned long)diferentes);
+#ifdef SEMAFORO_SIM
+    return 0;
+#else
+    while (true) {
+        tight_loop_contents();
+    }
+#endif
+}
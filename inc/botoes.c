@@ -0,0 +1,149 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+#include "eventos.h"
+#include "rastro.h"
+#include "log.h"
+#include "botoes.h"
+
+// Programa de cada máquina de estados, montado com os codificadores do SDK. Cada amostra leva
+// dois ciclos (jmp pin + jmp x--). Registradores:
+//   y   = amostras em nível baixo que confirmam o aperto
+//   osr = amostras em nível alto que confirmam a soltura
+//   isr = repiques vistos desde o último aperto; o PUSH o entrega junto com o aperto
+#define SOLTO            4
+#define CONFIRMA_SOLTO   6
+#define ALTO             8
+#define ESPERA           9
+#define CONFIRMA_APERTO 11
+#define REPIQUE         15
+#define REPIQUE_SOLTURA 19
+#define N_INSTRUCOES    23
+
+static uint16_t instrucoes[N_INSTRUCOES];
+static const pio_program_t programa = { instrucoes, N_INSTRUCOES, -1 };
+
+typedef struct {
+    PIO pio;
+    uint sm;
+    uint gpio;
+} botao_pio_t;
+
+static botao_pio_t botoes[botoes_max];
+static uint n_botoes = 0;
+static int posicao_programa[NUM_PIOS] = { -1, -1 };
+static botoes_estatisticas_t estatisticas;
+
+static void montar_programa() {
+    const uint16_t montado[N_INSTRUCOES] = {
+        pio_encode_mov(pio_isr, pio_null),          //  0: nenhum repique ainda
+        pio_encode_pull(false, true),               //  1: amostras do aperto
+        pio_encode_mov(pio_y, pio_osr),             //  2:
+        pio_encode_pull(false, true),               //  3: amostras da soltura (ficam no osr)
+        pio_encode_wait_pin(true, 0),               //  4 SOLTO: espera a subida
+        pio_encode_mov(pio_x, pio_osr),             //  5
+        pio_encode_jmp_pin(ALTO),                   //  6 CONFIRMA_SOLTO
+        pio_encode_jmp(REPIQUE_SOLTURA),            //  7: voltou a baixo antes de estabilizar
+        pio_encode_jmp_x_dec(CONFIRMA_SOLTO),       //  8 ALTO
+        pio_encode_wait_pin(false, 0),              //  9 ESPERA: primeira descida
+        pio_encode_mov(pio_x, pio_y),               // 10
+        pio_encode_jmp_pin(REPIQUE),                // 11 CONFIRMA_APERTO: subiu antes do mínimo
+        pio_encode_jmp_x_dec(CONFIRMA_APERTO),      // 12
+        pio_encode_push(false, false),              // 13: aperto confirmado, isr = repiques
+        pio_encode_jmp(SOLTO),                      // 14
+        pio_encode_mov_not(pio_x, pio_isr),         // 15 REPIQUE: isr++ via ~(~isr - 1)
+        pio_encode_jmp_x_dec(REPIQUE + 2),          // 16
+        pio_encode_mov_not(pio_isr, pio_x),         // 17
+        pio_encode_jmp(ESPERA),                     // 18
+        pio_encode_mov_not(pio_x, pio_isr),         // 19 REPIQUE_SOLTURA: isr++
+        pio_encode_jmp_x_dec(REPIQUE_SOLTURA + 2),  // 20
+        pio_encode_mov_not(pio_isr, pio_x),         // 21
+        pio_encode_jmp(SOLTO),                      // 22
+    };
+    memcpy(instrucoes, montado, sizeof(instrucoes));
+}
+
+// RX FIFO não vazio: cada palavra é um aperto já filtrado (com os repiques que o precederam)
+static void botoes_irq() {
+    estatisticas.interrupcoes++;
+    for (uint i = 0; i < n_botoes; i++) {
+        const botao_pio_t *b = &botoes[i];
+        while (!pio_sm_is_rx_fifo_empty(b->pio, b->sm)) {
+            rastro_registrar(RASTRO_IRQ_ENTRADA, RASTRO_FONTE_PIO << 8 | b->gpio);
+            uint32_t repiques = pio_sm_get(b->pio, b->sm);
+            estatisticas.apertos++;
+            estatisticas.repiques += repiques;
+            log_depuracao("Aperto na PIO: gpio %u, %lu repiques", b->gpio, (unsigned long)repiques);
+            eventos_postar(EVENTO_BOTAO, b->gpio);
+            rastro_registrar(RASTRO_IRQ_SAIDA, RASTRO_FONTE_PIO << 8 | b->gpio);
+        }
+    }
+}
+
+// Divisor que mantém as máquinas em botoes_frequencia_hz no clk_sys atual
+static float divisor_clock() {
+    return (float)clock_get_hz(clk_sys) / botoes_frequencia_hz;
+}
+
+// Reserva uma máquina de estados (na pio0 ou na pio1) que passa a filtrar o botão; retorna false
+// se não houver máquina livre ou espaço para o programa
+bool botoes_adicionar(uint gpio, uint32_t aperto_min_us, uint32_t soltura_us) {
+    static const PIO pios[NUM_PIOS] = { pio0, pio1 };
+
+    if (n_botoes == botoes_max) {
+        return false;
+    }
+    if (n_botoes == 0) {
+        montar_programa();
+    }
+
+    for (uint p = 0; p < NUM_PIOS; p++) {
+        PIO pio = pios[p];
+        if (posicao_programa[p] < 0 && pio_can_add_program(pio, &programa)) {
+            posicao_programa[p] = pio_add_program(pio, &programa);
+            irq_set_exclusive_handler(pio_get_irq_num(pio, 0), botoes_irq);
+            irq_set_enabled(pio_get_irq_num(pio, 0), true);
+        }
+        if (posicao_programa[p] < 0) {
+            continue;
+        }
+        int sm = pio_claim_unused_sm(pio, false);
+        if (sm < 0) {
+            continue;
+        }
+
+        uint offset = (uint)posicao_programa[p];
+        pio_sm_config c = pio_get_default_sm_config();
+        sm_config_set_wrap(&c, offset, offset + N_INSTRUCOES - 1);
+        sm_config_set_in_pins(&c, gpio);
+        sm_config_set_jmp_pin(&c, gpio);
+        sm_config_set_clkdiv(&c, divisor_clock());
+        pio_sm_init(pio, (uint)sm, offset, &c);
+
+        // x = n faz n + 1 amostras de 2 ciclos
+        uint32_t amostra_us = 2 * 1000000 / botoes_frequencia_hz;
+        pio_sm_put_blocking(pio, (uint)sm, aperto_min_us > amostra_us ? aperto_min_us / amostra_us - 1 : 0);
+        pio_sm_put_blocking(pio, (uint)sm, soltura_us > amostra_us ? soltura_us / amostra_us - 1 : 0);
+        pio_set_irq0_source_enabled(pio, (enum pio_interrupt_source)(pis_sm0_rx_fifo_not_empty + sm), true);
+        pio_sm_set_enabled(pio, (uint)sm, true);
+
+        botoes[n_botoes++] = (botao_pio_t){ pio, (uint)sm, gpio };
+        return true;
+    }
+    return false;
+}
+
+// Chamada a cada mudança do clk_sys (sono profundo): a PIO anda no clk_sys, e sem reajuste o
+// tempo mínimo de aperto cresceria na mesma proporção
+void botoes_ajustar_clock() {
+    float divisor = divisor_clock();
+    for (uint i = 0; i < n_botoes; i++) {
+        pio_sm_set_clkdiv(botoes[i].pio, botoes[i].sm, divisor);
+    }
+}
+
+void botoes_obter_estatisticas(botoes_estatisticas_t *saida) {
+    *saida = estatisticas;
+}
@@ -0,0 +1,24 @@
+#include "pico/stdlib.h"
+
+#ifndef botoes_inc_h
+#define botoes_inc_h
+
+// Botões de pedestre filtrados pela PIO: uma máquina de estados por botão amostra o pino (em
+// repouso alto pelo pull-up), só aceita o nível baixo que se mantém pelo tempo mínimo e entrega
+// um único aperto pelo RX FIFO. Repiques e pulsos curtos nunca chegam à CPU.
+#define botoes_max           8      // Duas PIOs com quatro máquinas de estados cada
+#define botoes_frequencia_hz 100000 // Clock das máquinas; cada amostra leva dois ciclos (20 us)
+#define botoes_aperto_min_us 20000  // Nível baixo estável por 20 ms confirma o aperto
+#define botoes_soltura_us    20000  // Nível alto estável por 20 ms rearma o botão
+
+typedef struct {
+    uint32_t apertos;      // Apertos entregues ao laço principal
+    uint32_t interrupcoes; // Interrupções da PIO (uma por aperto, ou menos se chegarem juntos)
+    uint32_t repiques;     // Pulsos descartados pela PIO antes dos apertos entregues
+} botoes_estatisticas_t;
+
+bool botoes_adicionar(uint gpio, uint32_t aperto_min_us, uint32_t soltura_us);
+void botoes_ajustar_clock();
+void botoes_obter_estatisticas(botoes_estatisticas_t *saida);
+
+#endif
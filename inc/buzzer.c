@@ -0,0 +1,206 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/clocks.h"
+#include "buzzer.h"
+
+// Cadências: frequência (Hz, 0 = pausa), duração (ms) e buzzers de cada passo. A espera e a
+// travessia têm ritmo de 1 s, como a contagem regressiva; a liberação bipa 4 vezes por segundo.
+// Uma troca de cadência pode emendar o bipe interrompido no primeiro da nova: somados, nunca
+// passam de 250 ms
+const buzzer_passo_t buzzer_cadencias[BUZZER_N_CADENCIAS][buzzer_passos] = {
+    [BUZZER_ESPERA] = {
+        { 1000, 50, BUZZER_PINO_A | BUZZER_PINO_B }, { 0, 950, 0 },
+        { 1000, 50, BUZZER_PINO_A | BUZZER_PINO_B }, { 0, 950, 0 },
+    },
+    [BUZZER_TRAVESSIA] = {
+        { 880, 150, BUZZER_PINO_A }, { 0, 850, 0 },
+        { 880, 150, BUZZER_PINO_B }, { 0, 850, 0 },
+    },
+    [BUZZER_LIBERACAO] = {
+        { 1760, 80, BUZZER_PINO_A }, { 0, 170, 0 },
+        { 1760, 80, BUZZER_PINO_B }, { 0, 170, 0 },
+    },
+};
+
+// Programa de cada máquina de estados, montado com os codificadores do SDK. Cada passo são duas
+// palavras do TX FIFO: os pinos do passo (relativos ao primeiro buzzer) e, na segunda, meio
+// período em ciclos nos 16 bits altos e a quantidade de períodos - 1 nos baixos. Um período
+// leva 2 * meio + 7 ciclos; as pausas são períodos com os pinos em zero.
+#define PERIODO         4
+#define MEIO_ALTO       6
+#define MEIO_BAIXO      9
+#define N_INSTRUCOES   11
+#define CICLOS_FIXOS    7
+#define MEIO_PAUSA   4996 // Períodos de 10 ms nas pausas
+
+static uint16_t instrucoes[N_INSTRUCOES];
+static const pio_program_t programa = { instrucoes, N_INSTRUCOES, -1 };
+
+#define buzzer_max (NUM_PIOS * NUM_PIO_STATE_MACHINES)
+
+static buzzer_t *buzzers[buzzer_max];
+static uint n_buzzers = 0;
+static int posicao_programa[NUM_PIOS] = { -1, -1 };
+static uint32_t pinos_pio[NUM_PIOS]; // Buzzers entregues a cada PIO
+static uint32_t vaos_pio[NUM_PIOS];  // Pinos cobertos pelos OUTs das máquinas de cada PIO
+
+static void montar_programa() {
+    const uint16_t montado[N_INSTRUCOES] = {
+        pio_encode_pull(false, true),          //  0: pinos do passo
+        pio_encode_mov(pio_isr, pio_osr),      //  1
+        pio_encode_pull(false, true),          //  2: meio período | períodos - 1
+        pio_encode_out(pio_y, 16),             //  3: y = períodos - 1, osr = meio período
+        pio_encode_mov(pio_pins, pio_isr),     //  4 PERIODO
+        pio_encode_mov(pio_x, pio_osr),        //  5
+        pio_encode_jmp_x_dec(MEIO_ALTO),       //  6 MEIO_ALTO
+        pio_encode_mov(pio_pins, pio_null),    //  7
+        pio_encode_mov(pio_x, pio_osr),        //  8
+        pio_encode_jmp_x_dec(MEIO_BAIXO),      //  9 MEIO_BAIXO
+        pio_encode_jmp_y_dec(PERIODO),         // 10: volta ao passo seguinte pelo wrap
+    };
+    memcpy(instrucoes, montado, sizeof(instrucoes));
+}
+
+// Divisor que mantém as máquinas em buzzer_frequencia_hz no clk_sys atual
+static float divisor_clock() {
+    return (float)clock_get_hz(clk_sys) / buzzer_frequencia_hz;
+}
+
+// Traduz a tabela de cadências nas palavras que o DMA entrega à máquina de estados
+static void codificar(buzzer_t *b, uint base, uint8_t pino_a, uint8_t pino_b) {
+    for (int cadencia = BUZZER_SILENCIO + 1; cadencia < BUZZER_N_CADENCIAS; cadencia++) {
+        for (int i = 0; i < buzzer_passos; i++) {
+            const buzzer_passo_t *p = &buzzer_cadencias[cadencia][i];
+            uint32_t pinos = 0;
+            if ((p->buzzers & BUZZER_PINO_A) && pino_a < 32) pinos |= 1u << (pino_a - base);
+            if ((p->buzzers & BUZZER_PINO_B) && pino_b < 32) pinos |= 1u << (pino_b - base);
+
+            uint32_t meio = p->frequencia_hz ? (buzzer_frequencia_hz / p->frequencia_hz - CICLOS_FIXOS) / 2 : MEIO_PAUSA;
+            uint32_t periodo = 2 * meio + CICLOS_FIXOS;
+            uint32_t ciclos = p->duracao_ms * (buzzer_frequencia_hz / 1000);
+            uint32_t periodos = (ciclos + periodo / 2) / periodo;
+            periodos = periodos < 1 ? 1 : (periodos > 0x10000 ? 0x10000 : periodos);
+
+            b->palavras[cadencia][2 * i] = p->frequencia_hz ? pinos : 0;
+            b->palavras[cadencia][2 * i + 1] = meio << 16 | (periodos - 1);
+        }
+    }
+}
+
+// Reserva uma máquina de estados e um canal de DMA para os buzzers do cruzamento (pinos >= 32,
+// como cruzamento_sem_pino, ficam de fora). Retorna false, e o buzzer fica mudo, sem pinos, sem
+// máquina livre ou se outra máquina já escreve nos pinos entre os dois buzzers
+bool buzzer_iniciar(buzzer_t *b, uint8_t pino_a, uint8_t pino_b) {
+    static const PIO pios[NUM_PIOS] = { pio1, pio0 }; // Os botões começam pela pio0
+
+    memset(b, 0, sizeof(*b));
+    b->sm = -1;
+    b->dma = -1;
+    b->cadencia = BUZZER_SILENCIO;
+
+    bool tem_a = pino_a < 32, tem_b = pino_b < 32;
+    if ((!tem_a && !tem_b) || n_buzzers == buzzer_max) {
+        return false;
+    }
+    if (n_buzzers == 0) {
+        montar_programa();
+    }
+
+    uint base = tem_a && tem_b ? MIN(pino_a, pino_b) : (tem_a ? pino_a : pino_b);
+    uint ultimo = tem_a && tem_b ? MAX(pino_a, pino_b) : base;
+    uint32_t pinos = (tem_a ? 1u << pino_a : 0) | (tem_b ? 1u << pino_b : 0);
+    uint32_t vao = (uint32_t)(((1ull << (ultimo - base + 1)) - 1) << base);
+
+    for (uint p = 0; p < NUM_PIOS; p++) {
+        PIO pio = pios[p];
+        uint indice = pio_get_index(pio);
+        if ((vaos_pio[indice] & pinos) || (vao & pinos_pio[indice])) {
+            continue; // Um OUT da outra máquina apagaria estes pinos, ou vice-versa
+        }
+        if (posicao_programa[indice] < 0 && pio_can_add_program(pio, &programa)) {
+            posicao_programa[indice] = pio_add_program(pio, &programa);
+        }
+        if (posicao_programa[indice] < 0) {
+            continue;
+        }
+        int sm = pio_claim_unused_sm(pio, false);
+        if (sm < 0) {
+            continue;
+        }
+        int dma = dma_claim_unused_channel(false);
+        if (dma < 0) {
+            pio_sm_unclaim(pio, (uint)sm);
+            return false;
+        }
+
+        b->pio = pio;
+        b->sm = sm;
+        b->dma = dma;
+        b->offset = (uint)posicao_programa[indice];
+        codificar(b, base, pino_a, pino_b);
+
+        if (tem_a) pio_gpio_init(pio, pino_a);
+        if (tem_b) pio_gpio_init(pio, pino_b);
+        pio_sm_set_pindirs_with_mask(pio, (uint)sm, pinos, pinos);
+
+        pio_sm_config c = pio_get_default_sm_config();
+        sm_config_set_wrap(&c, b->offset, b->offset + N_INSTRUCOES - 1);
+        sm_config_set_out_pins(&c, base, ultimo - base + 1);
+        sm_config_set_out_shift(&c, true, false, 32);
+        sm_config_set_clkdiv(&c, divisor_clock());
+        pio_sm_init(pio, (uint)sm, b->offset, &c);
+
+        // Anel de leitura de 32 bytes: o DMA repete os 4 passos da cadência até ser abortado
+        static_assert(sizeof(b->palavras[0]) == 1u << 5, "anel do DMA diferente de uma cadencia");
+        b->config_dma = dma_channel_get_default_config((uint)dma);
+        channel_config_set_transfer_data_size(&b->config_dma, DMA_SIZE_32);
+        channel_config_set_read_increment(&b->config_dma, true);
+        channel_config_set_write_increment(&b->config_dma, false);
+        channel_config_set_dreq(&b->config_dma, pio_get_dreq(pio, (uint)sm, true));
+        channel_config_set_ring(&b->config_dma, false, 5);
+
+        pinos_pio[indice] |= pinos;
+        vaos_pio[indice] |= vao;
+        buzzers[n_buzzers++] = b;
+        return true;
+    }
+    return false;
+}
+
+// Troca a cadência: a máquina volta ao início com os pinos em zero e o DMA recomeça do primeiro
+// passo da nova cadência. Sem máquina de estados, só registra a cadência.
+void buzzer_tocar(buzzer_t *b, buzzer_cadencia_t cadencia) {
+    if (cadencia == b->cadencia) {
+        return;
+    }
+    b->cadencia = cadencia;
+    if (b->sm < 0) {
+        return;
+    }
+
+    uint sm = (uint)b->sm;
+    pio_sm_set_enabled(b->pio, sm, false);
+    dma_channel_abort((uint)b->dma);
+    pio_sm_clear_fifos(b->pio, sm);
+    pio_sm_restart(b->pio, sm);
+    pio_sm_exec(b->pio, sm, pio_encode_mov(pio_pins, pio_null));
+    pio_sm_exec(b->pio, sm, pio_encode_jmp(b->offset));
+    if (cadencia == BUZZER_SILENCIO) {
+        return;
+    }
+
+    // Contagem máxima: a cadência se repete por anos, muito além de qualquer fase
+    dma_channel_configure((uint)b->dma, &b->config_dma, &b->pio->txf[sm], b->palavras[cadencia], UINT32_MAX, true);
+    pio_sm_set_enabled(b->pio, sm, true);
+}
+
+// Chamada a cada mudança do clk_sys (sono profundo): sem reajuste, o tom e o ritmo cairiam
+// na mesma proporção do clock
+void buzzer_ajustar_clock() {
+    float divisor = divisor_clock();
+    for (uint i = 0; i < n_buzzers; i++) {
+        pio_sm_set_clkdiv(buzzers[i]->pio, (uint)buzzers[i]->sm, divisor);
+    }
+}
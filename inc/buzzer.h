@@ -0,0 +1,48 @@
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+
+#ifndef buzzer_inc_h
+#define buzzer_inc_h
+
+// Sinal sonoro de pedestre gerado pela PIO: cada cadência é uma sequência de passos (frequência,
+// duração, buzzers) repetida em laço. Um canal de DMA em anel entrega os passos à máquina de
+// estados, então a CPU só age quando a cadência muda.
+typedef enum {
+    BUZZER_SILENCIO,
+    BUZZER_ESPERA,    // Pedido registrado: bipe curto por segundo, nos dois buzzers
+    BUZZER_TRAVESSIA, // Travessia liberada: bipe longo por segundo, alternando os buzzers
+    BUZZER_LIBERACAO, // Fim da travessia: bipes rápidos e mais agudos
+    BUZZER_N_CADENCIAS
+} buzzer_cadencia_t;
+
+#define BUZZER_PINO_A 0x01
+#define BUZZER_PINO_B 0x02
+
+#define buzzer_passos        4       // Passos por cadência; 2 palavras cada, anel de 32 bytes
+#define buzzer_frequencia_hz 1000000 // Clock da máquina de estados (1 ciclo = 1 us)
+
+typedef struct {
+    uint16_t frequencia_hz; // 0 = pausa
+    uint16_t duracao_ms;
+    uint8_t buzzers;        // BUZZER_PINO_A | BUZZER_PINO_B
+} buzzer_passo_t;
+
+extern const buzzer_passo_t buzzer_cadencias[BUZZER_N_CADENCIAS][buzzer_passos];
+
+// O anel de leitura do DMA exige cada cadência alinhada ao seu tamanho
+typedef struct {
+    uint32_t palavras[BUZZER_N_CADENCIAS][2 * buzzer_passos] __attribute__((aligned(32)));
+    PIO pio;
+    int sm;     // -1: sem máquina de estados (cruzamento virtual ou PIO esgotada)
+    int dma;
+    uint offset;
+    dma_channel_config config_dma;
+    buzzer_cadencia_t cadencia;
+} buzzer_t;
+
+bool buzzer_iniciar(buzzer_t *b, uint8_t pino_a, uint8_t pino_b);
+void buzzer_tocar(buzzer_t *b, buzzer_cadencia_t cadencia);
+void buzzer_ajustar_clock();
+
+#endif
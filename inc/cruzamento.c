@@ -0,0 +1,336 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "servico_display.h"
+#include "cruzamento.h"
+#include "rastro.h"
+#include "log.h"
+
+#define CONTAGEM_LIBERACAO 3 // Segundos finais da travessia com a cadência de liberação
+
+// Escreve uma saída do cruzamento, se ela tiver pino
+static void escrever(uint8_t pino, bool valor) {
+    if (pino != cruzamento_sem_pino) {
+        gpio_put(pino, valor);
+    }
+}
+
+// Callbacks da roda (interrupção do alarme): apenas postam eventos com o índice do cruzamento
+static void fim_fase_callback(roda_temporizador_t *t) {
+    eventos_postar(EVENTO_FIM_FASE, ((cruzamento_t *)t->dados)->indice);
+}
+
+// Rearma a partir do prazo anterior, e não do instante do callback, para não derivar
+static void contagem_callback(roda_temporizador_t *t) {
+    eventos_postar(EVENTO_CONTAGEM, ((cruzamento_t *)t->dados)->indice);
+    roda_armar(t, t->prazo_us + INTERVALO_CONTAGEM * 1000, contagem_callback, t->dados);
+}
+
+// Índice da faixa do pedido em filas[] e esperas[]
+static inline int faixa(pedido_t pedido) {
+    return pedido - PEDIDO_A;
+}
+
+// Milissegundos desde a época, base dos instantes dos apertos
+static uint32_t ms_desde_epoca(const cruzamento_t *c, uint64_t instante_us) {
+    return (uint32_t)((instante_us - c->epoca_us) / 1000);
+}
+
+// Pedestres com aperto ainda não atendido nas duas faixas: a demanda medida
+static uint32_t pedestres_esperando(const cruzamento_t *c) {
+    uint32_t total = 0;
+    for (int i = 0; i < 2; i++) {
+        total += c->filas[i].quantidade + c->filas[i].excedentes;
+    }
+    return total;
+}
+
+// Pede ao core1 a tela de status, se este for o cruzamento principal; retorna sem esperar o
+// display. O letreiro "Aguarde travessia" aparece enquanto houver pedestre esperando, fora das
+// travessias: a contagem redesenha a tela a cada segundo, e cada envio recomeça o scroll
+static void atualizar_display(cruzamento_t *c, tela_t tela, int contagem) {
+    if (!c->config->principal) return;
+
+    servico_display_solicitar(tela, contagem, pedestres_esperando(c) > 0 && fases_tabela[c->fase].contagem == 0);
+    log_info("%s", (uintptr_t)servico_display_texto(tela)); // Também imprime no Monitor Serial
+}
+
+// Troca a cadência do buzzer; a PIO toca os passos sozinha até a próxima troca
+static void tocar(cruzamento_t *c, buzzer_cadencia_t cadencia) {
+    if (cadencia == c->buzzer.cadencia) return;
+
+    buzzer_tocar(&c->buzzer, cadencia);
+    rastro_registrar(cadencia == BUZZER_SILENCIO ? RASTRO_BUZZER_DESLIGA : RASTRO_BUZZER_LIGA,
+        c->indice << 8 | cadencia);
+}
+
+// Registra o atraso entre o início nominal da fase e a troca efetiva das saídas
+static void registrar_transicao(cruzamento_t *c, fase_id_t id) {
+    uint64_t agora = time_us_64();
+    uint32_t atraso = agora > c->fase_inicio_us ? (uint32_t)(agora - c->fase_inicio_us) : 0;
+    cruzamento_atraso_t *a = &c->atrasos[id];
+
+    if (a->transicoes == 0 || atraso < a->atraso_min_us) a->atraso_min_us = atraso;
+    if (atraso > a->atraso_max_us) a->atraso_max_us = atraso;
+    a->atraso_total_us += atraso;
+    a->transicoes++;
+    c->ultimo_atraso_us = atraso;
+}
+
+// Escolhe a faixa atendida ao fim da fase: o Centro tem prioridade, mas o Bairro passa à frente
+// quando seu aperto mais antigo já esperou fases_envelhecimento_ms e é mais antigo que o do Centro
+static pedido_t escolher_pedido(const cruzamento_t *c) {
+    const cruzamento_fila_t *a = &c->filas[faixa(PEDIDO_A)];
+    const cruzamento_fila_t *b = &c->filas[faixa(PEDIDO_B)];
+
+    if (b->quantidade == 0) return a->quantidade > 0 ? PEDIDO_A : PEDIDO_NENHUM;
+    if (a->quantidade == 0) return PEDIDO_B;
+
+    uint32_t agora = ms_desde_epoca(c, c->fase_fim_us);
+    uint32_t espera_a = agora - a->instantes_ms[0], espera_b = agora - b->instantes_ms[0];
+    return espera_b >= fases_envelhecimento_ms && espera_b > espera_a ? PEDIDO_B : PEDIDO_A;
+}
+
+// Esvazia a fila da faixa atendida, somando a espera de cada aperto até o início da travessia
+static void atender(cruzamento_t *c, pedido_t pedido, uint64_t travessia_us) {
+    if (pedido == PEDIDO_NENHUM) return;
+
+    cruzamento_fila_t *f = &c->filas[faixa(pedido)];
+    cruzamento_espera_t *e = &c->esperas[faixa(pedido)];
+    uint32_t inicio = ms_desde_epoca(c, travessia_us);
+
+    for (int i = 0; i < f->quantidade; i++) {
+        uint32_t espera = inicio - f->instantes_ms[i];
+        if (espera > e->espera_max_ms) e->espera_max_ms = espera;
+        if (espera > ESPERA_MAX_PEDESTRE) e->acima_limite++;
+        e->espera_total_ms += espera;
+    }
+    e->pedestres += f->quantidade;
+    e->excedentes += f->excedentes;
+    e->travessias++;
+    f->quantidade = 0;
+    f->excedentes = 0;
+}
+
+// Entra em uma fase: saídas, display, prazo e contagem vêm todos da linha da tabela; uma fase
+// que consome pedido atende a faixa escolhida
+static void entrar_fase(cruzamento_t *c, fase_id_t id, pedido_t pedido) {
+    const fase_t *fase = &fases_tabela[id];
+
+    c->fase = id;
+    c->saidas = fase->saidas;
+    escrever(c->config->vermelho, fase->saidas & FASE_SAIDA_VERMELHO);
+    escrever(c->config->verde, fase->saidas & FASE_SAIDA_VERDE);
+    rastro_registrar(RASTRO_FASE, c->indice << 8 | id);
+    registrar_transicao(c, id);
+    atualizar_display(c, fase->tela, 0);
+
+    c->fase_fim_us = c->fase_inicio_us + (uint64_t)fase->duracao_ms * 1000;
+    roda_armar(&c->temporizador_fase, c->fase_fim_us, fim_fase_callback, c);
+    if (fase->consome_pedido) {
+        atender(c, pedido, c->fase_fim_us); // A travessia começa no fim desta fase
+    }
+
+    c->contagem_regressiva = fase->contagem;
+    if (fase->contagem > 0) {
+        tocar(c, BUZZER_TRAVESSIA);
+        roda_armar(&c->temporizador_contagem, c->fase_inicio_us + INTERVALO_CONTAGEM * 1000, contagem_callback, c);
+    }
+}
+
+// Com pedestres esperando, uma fase adaptativa encolhe PASSO_REDUCAO por pedestre até a duração
+// mínima, ou termina já se esse tempo passou. O novo prazo cai em um ms inteiro futuro, para a
+// transição sair no tick da roda sem atraso
+static void encurtar_fase(cruzamento_t *c) {
+    const fase_t *fase = &fases_tabela[c->fase];
+    if (fase->duracao_min_ms == fase->duracao_ms) return;
+
+    uint32_t reducao = pedestres_esperando(c) * PASSO_REDUCAO;
+    uint32_t duracao_ms = fase->duracao_ms - fase->duracao_min_ms > reducao ? fase->duracao_ms - reducao : fase->duracao_min_ms;
+    uint64_t fim = c->fase_inicio_us + (uint64_t)duracao_ms * 1000;
+    uint64_t proximo = c->epoca_us + ((uint64_t)ms_desde_epoca(c, time_us_64()) + 2) * 1000;
+
+    if (fim < proximo) fim = proximo;
+    if (fim < c->fase_fim_us) {
+        c->fase_fim_us = fim;
+        roda_armar(&c->temporizador_fase, c->fase_fim_us, fim_fase_callback, c);
+    }
+}
+
+// Ao fim de cada fase, a próxima é a da coluna do pedido escolhido na tabela; sem ninguém
+// esperando, uma fase adaptativa se estende em passos até a duração máxima. Retorna se a fase
+// que terminou era uma travessia
+static bool avancar_fase(cruzamento_t *c) {
+    const fase_t *atual = &fases_tabela[c->fase];
+    bool fim_travessia = atual->contagem > 0;
+
+    uint64_t duracao_us = c->fase_fim_us - c->fase_inicio_us;
+    uint64_t maxima_us = (uint64_t)atual->duracao_max_ms * 1000;
+    if (pedestres_esperando(c) == 0 && duracao_us < maxima_us) {
+        c->fase_fim_us += maxima_us - duracao_us < PASSO_EXTENSAO * 1000 ? maxima_us - duracao_us : PASSO_EXTENSAO * 1000;
+        roda_armar(&c->temporizador_fase, c->fase_fim_us, fim_fase_callback, c);
+        return false;
+    }
+
+    if (fim_travessia) {
+        // Pedido feito durante a travessia: volta à cadência de espera até a próxima
+        tocar(c, pedestres_esperando(c) > 0 ? BUZZER_ESPERA : BUZZER_SILENCIO);
+    }
+    pedido_t pedido = escolher_pedido(c);
+    c->fase_inicio_us = c->fase_fim_us; // A próxima fase começa no prazo, não no instante do despacho
+    entrar_fase(c, atual->proxima[pedido], pedido);
+    return fim_travessia;
+}
+
+// Avança a contagem regressiva de travessia do pedestre a cada tick
+static void avancar_contagem(cruzamento_t *c) {
+    if (c->contagem_regressiva <= 0) return; // Tick já disparado quando a contagem acabou
+
+    if (c->config->principal) {
+        log_info("Contagem Regressiva: %d", c->contagem_regressiva);
+    }
+    if (c->contagem_regressiva == CONTAGEM_LIBERACAO) {
+        tocar(c, BUZZER_LIBERACAO); // Fim da travessia próximo: bipes rápidos
+    }
+    atualizar_display(c, fases_tabela[c->fase].tela, c->contagem_regressiva);
+
+    if (--c->contagem_regressiva == 0) {
+        roda_cancelar(&c->temporizador_contagem); // A fase termina pelo seu próprio prazo
+    }
+}
+
+// Primeira coisa após o reset: acende o vermelho e apaga o verde. O nível é escrito antes de
+// o pino virar saída, então o verde nunca pisca; não depende de clock, roda nem display
+void cruzamento_estado_seguro(const cruzamento_config_t *config) {
+    const uint8_t leds[] = { config->vermelho, config->verde };
+
+    for (size_t i = 0; i < count_of(leds); i++) {
+        if (leds[i] != cruzamento_sem_pino) {
+            gpio_init(leds[i]);
+            gpio_put(leds[i], leds[i] == config->vermelho);
+            gpio_set_dir(leds[i], GPIO_OUT);
+        }
+    }
+}
+
+// Configura os buzzers como saída e os botões como entrada com pull-up; os LEDs já estão no
+// estado seguro (cruzamento_estado_seguro) e não são tocados
+void cruzamento_configurar_pinos(const cruzamento_config_t *config) {
+    const uint8_t saidas[] = { config->buzzer_a, config->buzzer_b };
+    const uint8_t entradas[] = { config->botao_a, config->botao_b };
+
+    for (size_t i = 0; i < count_of(saidas); i++) {
+        if (saidas[i] != cruzamento_sem_pino) {
+            gpio_init(saidas[i]);
+            gpio_set_dir(saidas[i], GPIO_OUT);
+            gpio_put(saidas[i], 0);
+        }
+    }
+    for (size_t i = 0; i < count_of(entradas); i++) {
+        if (entradas[i] != cruzamento_sem_pino) {
+            gpio_init(entradas[i]);
+            gpio_set_dir(entradas[i], GPIO_IN);
+            gpio_pull_up(entradas[i]);
+        }
+    }
+}
+
+// Inicia o cruzamento no vermelho; o ciclo fica deslocado da época pela defasagem configurada.
+// Com pinos de buzzer, reserva uma máquina de estados da PIO: chamar uma vez por cruzamento
+void cruzamento_iniciar(cruzamento_t *c, uint8_t indice, const cruzamento_config_t *config, uint64_t epoca_us) {
+    memset(c, 0, sizeof(*c));
+    c->config = config;
+    c->indice = indice;
+    if (!buzzer_iniciar(&c->buzzer, config->buzzer_a, config->buzzer_b) &&
+        (config->buzzer_a != cruzamento_sem_pino || config->buzzer_b != cruzamento_sem_pino)) {
+        log_aviso("Cruzamento %u sem maquina de estados para o buzzer", indice);
+    }
+    c->epoca_us = epoca_us;
+    c->fase_inicio_us = epoca_us + (uint64_t)config->defasagem_ms * 1000;
+    entrar_fase(c, FASE_VERMELHO, PEDIDO_NENHUM);
+}
+
+// Cancela os temporizadores do cruzamento e apaga suas saídas
+void cruzamento_parar(cruzamento_t *c) {
+    roda_cancelar(&c->temporizador_fase);
+    roda_cancelar(&c->temporizador_contagem);
+
+    escrever(c->config->vermelho, 0);
+    escrever(c->config->verde, 0);
+    tocar(c, BUZZER_SILENCIO);
+}
+
+// Registra um aperto na fila da sua faixa, com o instante para a espera e o envelhecimento;
+// o Centro tem prioridade, mas um aperto do Bairro nunca é descartado
+void cruzamento_pedir(cruzamento_t *c, pedido_t pedido) {
+    if (pedido != PEDIDO_A && pedido != PEDIDO_B) return;
+
+    cruzamento_fila_t *f = &c->filas[faixa(pedido)];
+    uint32_t agora = ms_desde_epoca(c, time_us_64());
+    if (f->quantidade > 0 && agora - f->ultimo_ms < cruzamento_repique_ms) return;
+
+    f->ultimo_ms = agora;
+    if (f->quantidade < cruzamento_fila_max) {
+        f->instantes_ms[f->quantidade++] = agora;
+    } else {
+        f->excedentes++;
+    }
+
+    if (pedido == PEDIDO_A) {
+        if (c->config->principal) log_info("Botao A (Centro) acionado");
+        atualizar_display(c, TELA_BOTAO_A, 0); // Exibe mensagem no display OLED
+    } else {
+        if (c->config->principal) log_info("Botao B (Bairro) acionado");
+        atualizar_display(c, TELA_BOTAO_B, 0); // Exibe mensagem no display OLED
+    }
+    if (fases_tabela[c->fase].contagem == 0) {
+        tocar(c, BUZZER_ESPERA); // Confirma o pedido até a travessia começar
+    }
+    encurtar_fase(c);
+}
+
+// Trata um evento de temporização do cruzamento; retorna true quando uma travessia terminou
+bool cruzamento_tratar_evento(cruzamento_t *c, const evento_t *evento) {
+    switch (evento->tipo) {
+        case EVENTO_FIM_FASE:
+            return avancar_fase(c);
+        case EVENTO_CONTAGEM:
+            avancar_contagem(c);
+            break;
+        default:
+            break;
+    }
+    return false;
+}
+
+// Imprime o atraso mínimo/médio/máximo das transições de cada fase em relação aos prazos
+// absolutos; o atraso da última transição mostra se o ciclo deriva em relação à época
+void cruzamento_imprimir_atrasos(const cruzamento_t *c) {
+    for (int id = 0; id < FASE_N; id++) {
+        const cruzamento_atraso_t *a = &c->atrasos[id];
+        if (a->transicoes > 0) {
+            log_info("Atraso %s: %lu transicoes, min %lu us, media %lu us, max %lu us", (uintptr_t)fases_nomes[id],
+                (unsigned long)a->transicoes, (unsigned long)a->atraso_min_us,
+                (unsigned long)(a->atraso_total_us / a->transicoes), (unsigned long)a->atraso_max_us);
+        }
+    }
+    log_info("Deriva: %lu us na ultima transicao, %lu s desde a epoca", (unsigned long)c->ultimo_atraso_us,
+        (unsigned long)((c->fase_inicio_us - c->epoca_us) / 1000000));
+}
+
+// Imprime a espera média/máxima dos pedestres de cada faixa, do aperto ao início da travessia
+void cruzamento_imprimir_esperas(const cruzamento_t *c) {
+    static const char *const faixas[] = { "Centro", "Bairro" };
+
+    for (int i = 0; i < 2; i++) {
+        const cruzamento_espera_t *e = &c->esperas[i];
+        if (e->travessias > 0) {
+            log_info("Espera %s: %lu pedestres, media %lu ms, max %lu ms, %lu acima do limite, %lu fora da fila",
+                (uintptr_t)faixas[i], (unsigned long)e->pedestres,
+                (unsigned long)(e->pedestres ? e->espera_total_ms / e->pedestres : 0),
+                (unsigned long)e->espera_max_ms, (unsigned long)e->acima_limite, (unsigned long)e->excedentes);
+        }
+    }
+    log_info("Limite de espera: %lu ms (o Bairro passa a frente apos %lu ms)", (unsigned long)ESPERA_MAX_PEDESTRE,
+        (unsigned long)fases_envelhecimento_ms);
+}
@@ -0,0 +1,90 @@
+#include "pico/stdlib.h"
+#include "fases.h"
+#include "eventos.h"
+#include "roda_tempo.h"
+#include "buzzer.h"
+
+#ifndef cruzamento_inc_h
+#define cruzamento_inc_h
+
+// Pino ausente: a saída só é registrada no estado do cruzamento (cruzamentos virtuais)
+#define cruzamento_sem_pino 0xFF
+
+// Maior quantidade de cruzamentos em um controlador; os eventos de temporização levam o
+// índice do cruzamento como argumento
+#define cruzamentos_max 16
+
+// Apertos guardados por faixa até a travessia; com a fila cheia o pedestre ainda atravessa,
+// mas fica fora das estatísticas de espera
+#define cruzamento_fila_max 16
+
+// Apertos da mesma faixa mais próximos que isto são repiques (botão sem filtro da PIO)
+#define cruzamento_repique_ms 250
+
+// Pinos e parâmetros fixos de um cruzamento
+typedef struct {
+    uint8_t vermelho;
+    uint8_t verde;
+    uint8_t botao_a;
+    uint8_t botao_b;
+    uint8_t buzzer_a;
+    uint8_t buzzer_b;
+    uint32_t defasagem_ms; // Deslocamento do ciclo em relação à época comum (onda verde)
+    bool principal;        // Usa o display do core1 e imprime no monitor serial
+} cruzamento_config_t;
+
+// Atraso das transições de uma fase em relação aos prazos absolutos
+typedef struct {
+    uint32_t transicoes;
+    uint32_t atraso_min_us;
+    uint32_t atraso_max_us;
+    uint64_t atraso_total_us;
+} cruzamento_atraso_t;
+
+// Apertos ainda não atendidos de uma faixa, em ordem de chegada (ms desde a época)
+typedef struct {
+    uint32_t instantes_ms[cruzamento_fila_max];
+    uint8_t quantidade;
+    uint32_t excedentes;   // Apertos com a fila cheia
+    uint32_t ultimo_ms;    // Último aperto aceito, para descartar repiques
+} cruzamento_fila_t;
+
+// Espera dos pedestres de uma faixa, do aperto ao início da travessia
+typedef struct {
+    uint32_t pedestres;
+    uint32_t travessias;
+    uint32_t excedentes;
+    uint32_t acima_limite;  // Esperas maiores que ESPERA_MAX_PEDESTRE
+    uint32_t espera_max_ms;
+    uint64_t espera_total_ms;
+} cruzamento_espera_t;
+
+// Estado de um cruzamento; todos os temporizadores são entradas da roda de temporização
+typedef struct {
+    const cruzamento_config_t *config;
+    uint8_t indice;
+    fase_id_t fase;
+    cruzamento_fila_t filas[2];     // Centro (PEDIDO_A) e Bairro (PEDIDO_B)
+    cruzamento_espera_t esperas[2];
+    uint8_t saidas;            // FASE_SAIDA_* acesas
+    int contagem_regressiva;
+    buzzer_t buzzer;           // Cadências sonoras tocadas pela PIO
+    uint64_t epoca_us;         // Referência comum dos ciclos (base da roda)
+    uint64_t fase_inicio_us;   // Início nominal da fase atual
+    uint64_t fase_fim_us;      // Prazo nominal de fim da fase atual
+    roda_temporizador_t temporizador_fase;
+    roda_temporizador_t temporizador_contagem;
+    cruzamento_atraso_t atrasos[FASE_N];
+    uint32_t ultimo_atraso_us;
+} cruzamento_t;
+
+void cruzamento_estado_seguro(const cruzamento_config_t *config);
+void cruzamento_configurar_pinos(const cruzamento_config_t *config);
+void cruzamento_iniciar(cruzamento_t *c, uint8_t indice, const cruzamento_config_t *config, uint64_t epoca_us);
+void cruzamento_parar(cruzamento_t *c);
+void cruzamento_pedir(cruzamento_t *c, pedido_t pedido);
+bool cruzamento_tratar_evento(cruzamento_t *c, const evento_t *evento);
+void cruzamento_imprimir_atrasos(const cruzamento_t *c);
+void cruzamento_imprimir_esperas(const cruzamento_t *c);
+
+#endif
@@ -0,0 +1,96 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "eventos.h"
+#include "roda_tempo.h"
+#include "energia.h"
+
+static const char *nomes[] = { "ativo", "wfi", "profundo" };
+
+static energia_estatisticas_t estatisticas;
+static uint64_t inicio_us;
+static uint32_t frequencia_sys;
+static energia_clock_callback_t clock_callback = NULL;
+
+// No modo profundo o clk_peri passa a vir do pll_usb (48 MHz), então reduzir o clk_sys não
+// altera o I2C nem a UART; o timer conta pelo clk_ref e os prazos continuam exatos. Precisa
+// rodar antes de qualquer periférico calcular divisores (i2c_init, stdio).
+void energia_iniciar() {
+    frequencia_sys = clock_get_hz(clk_sys);
+#if ENERGIA_MODO == ENERGIA_PROFUNDO
+    clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB, 48 * MHZ, 48 * MHZ);
+#endif
+    memset(&estatisticas, 0, sizeof(estatisticas));
+    inicio_us = time_us_64();
+}
+
+void energia_registrar_clock_callback(energia_clock_callback_t callback) {
+    clock_callback = callback;
+}
+
+static void configurar_clk_sys(uint32_t frequencia) {
+    clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX,
+        CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS, frequencia_sys, frequencia);
+    if (clock_callback != NULL) {
+        clock_callback();
+    }
+}
+
+// Chamada pelo laço principal sem trabalho pendente: dorme até a próxima interrupção. As
+// interrupções ficam mascaradas entre a última verificação da fila e o WFI, para que um
+// evento postado nesse meio tempo não seja dormido por cima (o WFI acorda com a interrupção
+// pendente mesmo mascarada, e ela roda no restore_interrupts).
+void energia_ocioso() {
+#if ENERGIA_MODO == ENERGIA_ATIVO
+    tight_loop_contents();
+#else
+    uint32_t irq_state = save_and_disable_interrupts();
+    if (eventos_pendentes()) {
+        restore_interrupts(irq_state);
+        return;
+    }
+
+    uint64_t inicio = time_us_64();
+    uint64_t prazo = roda_proximo_prazo_us();
+    bool profundo = ENERGIA_MODO == ENERGIA_PROFUNDO && prazo > inicio && prazo - inicio >= energia_profundo_min_us;
+
+    if (profundo) {
+        configurar_clk_sys(frequencia_sys / energia_divisor_profundo);
+    }
+    __wfi();
+    if (profundo) {
+        configurar_clk_sys(frequencia_sys); // Antes da interrupção, para ela rodar no clock cheio
+    }
+
+    uint64_t dormido = time_us_64() - inicio;
+    if (profundo) {
+        estatisticas.profundo_us += dormido;
+        estatisticas.sonos_profundos++;
+    } else {
+        estatisticas.wfi_us += dormido;
+    }
+    estatisticas.sonos++;
+    restore_interrupts(irq_state);
+#endif
+}
+
+// O tempo ativo é o que sobra do tempo total fora do sono
+void energia_obter_estatisticas(energia_estatisticas_t *saida) {
+    *saida = estatisticas;
+    saida->ativo_us = time_us_64() - inicio_us - saida->wfi_us - saida->profundo_us;
+}
+
+// Média ponderada das correntes estimadas de cada estado
+uint32_t energia_corrente_media_ua(const energia_estatisticas_t *e) {
+    uint64_t total = e->ativo_us + e->wfi_us + e->profundo_us;
+    if (total == 0) {
+        return 0;
+    }
+    return (uint32_t)((e->ativo_us * energia_corrente_ativo_ua + e->wfi_us * energia_corrente_wfi_ua +
+                       e->profundo_us * energia_corrente_profundo_ua) / total);
+}
+
+const char *energia_nome_modo() {
+    return nomes[ENERGIA_MODO];
+}
@@ -0,0 +1,44 @@
+#include "pico/stdlib.h"
+
+#ifndef energia_inc_h
+#define energia_inc_h
+
+// Modos de ociosidade do laço principal; ENERGIA_MODO escolhe em tempo de compilação o de
+// cada local (painel solar ou bateria: ENERGIA_PROFUNDO)
+#define ENERGIA_ATIVO    0 // Gira em tight_loop_contents (referência de consumo)
+#define ENERGIA_WFI      1 // Dorme com WFI até a próxima interrupção
+#define ENERGIA_PROFUNDO 2 // WFI e, com o próximo prazo distante, clk_sys reduzido
+
+#ifndef ENERGIA_MODO
+#define ENERGIA_MODO ENERGIA_WFI
+#endif
+
+#define energia_profundo_min_us  2000000 // Próximo prazo a pelo menos 2s: reduz o clock
+#define energia_divisor_profundo 5       // clk_sys = pll_sys / 5 (25 MHz) no sono profundo
+
+// Corrente da placa em cada estado (uA): estimativas não calibradas para uma Pico W com o rádio
+// desligado, a substituir por valores medidos com um amperímetro na placa do local
+#define energia_corrente_ativo_ua    24000 // Núcleo executando a 125 MHz
+#define energia_corrente_wfi_ua      12000 // WFI a 125 MHz
+#define energia_corrente_profundo_ua  5000 // WFI com clk_sys a 25 MHz
+
+// Tempo em cada estado desde energia_iniciar
+typedef struct {
+    uint64_t ativo_us;
+    uint64_t wfi_us;
+    uint64_t profundo_us;
+    uint32_t sonos;
+    uint32_t sonos_profundos;
+} energia_estatisticas_t;
+
+// Chamada após cada mudança do clk_sys, para quem deriva tempos dele (divisores da PIO)
+typedef void (*energia_clock_callback_t)();
+
+void energia_iniciar();
+void energia_registrar_clock_callback(energia_clock_callback_t callback);
+void energia_ocioso();
+void energia_obter_estatisticas(energia_estatisticas_t *saida);
+uint32_t energia_corrente_media_ua(const energia_estatisticas_t *e);
+const char *energia_nome_modo();
+
+#endif
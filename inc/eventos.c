@@ -0,0 +1,80 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "eventos.h"
+
+// Fila circular sem travas, produtor único / consumidor único. Os produtores são as
+// interrupções do core0 (GPIO e alarmes do timer), todas na mesma prioridade padrão, que
+// portanto nunca se interrompem entre si e se comportam como um único produtor.
+// Apenas o produtor escreve "cabeca" e apenas o consumidor escreve "cauda".
+static evento_t fila[eventos_capacidade];
+static volatile uint32_t cabeca = 0;
+static volatile uint32_t cauda = 0;
+static volatile uint32_t descartados = 0;
+
+static eventos_estatisticas_t estatisticas[EVENTO_N_TIPOS];
+
+// Posta um evento (chamada a partir das interrupções); retorna false se a fila estiver cheia
+bool eventos_postar(evento_tipo_t tipo, uint32_t arg) {
+    uint32_t posicao = cabeca;
+
+    if (posicao - cauda == eventos_capacidade) {
+        descartados++;
+        return false;
+    }
+
+    evento_t *evento = &fila[posicao & (eventos_capacidade - 1)];
+    evento->tipo = tipo;
+    evento->arg = arg;
+    evento->postado_us = time_us_32();
+
+    __dmb(); // O evento precisa estar completo antes de ficar visível ao consumidor
+    cabeca = posicao + 1;
+    return true;
+}
+
+// Retira o próximo evento (chamada pelo laço principal) e contabiliza sua latência
+bool eventos_retirar(evento_t *evento) {
+    uint32_t posicao = cauda;
+
+    if (posicao == cabeca) {
+        return false;
+    }
+
+    __dmb();
+    *evento = fila[posicao & (eventos_capacidade - 1)];
+    __dmb(); // Cópia concluída antes de liberar a posição ao produtor
+    cauda = posicao + 1;
+
+    uint32_t latencia = time_us_32() - evento->postado_us;
+    eventos_estatisticas_t *e = &estatisticas[evento->tipo];
+    if (e->despachados == 0 || latencia < e->latencia_min_us) {
+        e->latencia_min_us = latencia;
+    }
+    if (latencia > e->latencia_max_us) {
+        e->latencia_max_us = latencia;
+    }
+    e->latencia_total_us += latencia;
+    e->despachados++;
+    return true;
+}
+
+// Há evento esperando o laço principal (para decidir se o núcleo pode dormir)
+bool eventos_pendentes() {
+    return cauda != cabeca;
+}
+
+// Copia as estatísticas de latência de um tipo de evento
+void eventos_obter_estatisticas(evento_tipo_t tipo, eventos_estatisticas_t *saida) {
+    *saida = estatisticas[tipo];
+}
+
+// Quantidade de eventos perdidos por fila cheia
+uint32_t eventos_descartados() {
+    return descartados;
+}
+
+// Zera as estatísticas de latência
+void eventos_zerar_estatisticas() {
+    memset(estatisticas, 0, sizeof(estatisticas));
+}
@@ -0,0 +1,39 @@
+#include "pico/stdlib.h"
+
+#ifndef eventos_inc_h
+#define eventos_inc_h
+
+// Capacidade da fila de eventos (precisa ser potência de 2); comporta os eventos simultâneos
+// de vários cruzamentos no mesmo tick
+#define eventos_capacidade 64
+
+// Tipos de evento postados pelas interrupções e tratados no laço principal
+typedef enum {
+    EVENTO_BOTAO,      // Botão de pedestre pressionado (arg = gpio)
+    EVENTO_FIM_FASE,   // Prazo da fase expirou (arg = índice do cruzamento)
+    EVENTO_CONTAGEM,   // Tick de 1s da contagem regressiva de travessia (arg = cruzamento)
+    EVENTO_N_TIPOS
+} evento_tipo_t;
+
+typedef struct {
+    evento_tipo_t tipo;
+    uint32_t arg;
+    uint32_t postado_us; // Instante (time_us_32) em que a interrupção postou o evento
+} evento_t;
+
+// Latência entre a postagem na interrupção e o despacho no laço principal
+typedef struct {
+    uint32_t despachados;
+    uint32_t latencia_min_us;
+    uint32_t latencia_max_us;
+    uint64_t latencia_total_us;
+} eventos_estatisticas_t;
+
+bool eventos_postar(evento_tipo_t tipo, uint32_t arg);
+bool eventos_retirar(evento_t *evento);
+bool eventos_pendentes();
+void eventos_obter_estatisticas(evento_tipo_t tipo, eventos_estatisticas_t *saida);
+uint32_t eventos_descartados();
+void eventos_zerar_estatisticas();
+
+#endif
@@ -0,0 +1,151 @@
+// Tabela de transições do semáforo, montada e validada em tempo de compilação
+#include "fases.h"
+#include "telas.h"
+
+// Conta TEMPO_TRAVESSIA / INTERVALO_CONTAGEM números e termina um intervalo depois do último
+constexpr uint32_t duracao_travessia = TEMPO_TRAVESSIA + INTERVALO_CONTAGEM;
+
+// Sem inicializadores designados em C++17: as linhas seguem a ordem de fase_id_t
+constexpr fase_t fases_tabela[FASE_N] = {
+    // FASE_VERMELHO
+    { TEMPO_VERMELHO, TEMPO_VERMELHO, TEMPO_VERMELHO, FASE_SAIDA_VERMELHO, TELA_VERMELHO, 0, false,
+      { FASE_VERDE, FASE_AMARELO_CENTRO, FASE_AMARELO_BAIRRO } },
+    // FASE_VERDE: a única adaptativa
+    { TEMPO_VERDE, TEMPO_VERDE_MIN, TEMPO_VERDE_MAX, FASE_SAIDA_VERDE, TELA_VERDE, 0, false,
+      { FASE_AMARELO, FASE_AMARELO_CENTRO, FASE_AMARELO_BAIRRO } },
+    // FASE_AMARELO (vermelho + verde)
+    { TEMPO_AMARELO, TEMPO_AMARELO, TEMPO_AMARELO, FASE_SAIDA_VERMELHO | FASE_SAIDA_VERDE, TELA_AMARELO, 0, false,
+      { FASE_VERMELHO, FASE_AMARELO_CENTRO, FASE_AMARELO_BAIRRO } },
+    // FASE_AMARELO_CENTRO: pedidos feitos agora ficam para depois da travessia
+    { TEMPO_AMARELO, TEMPO_AMARELO, TEMPO_AMARELO, FASE_SAIDA_VERMELHO | FASE_SAIDA_VERDE, TELA_AMARELO, 0, true,
+      { FASE_TRAVESSIA_CENTRO, FASE_TRAVESSIA_CENTRO, FASE_TRAVESSIA_CENTRO } },
+    // FASE_AMARELO_BAIRRO
+    { TEMPO_AMARELO, TEMPO_AMARELO, TEMPO_AMARELO, FASE_SAIDA_VERMELHO | FASE_SAIDA_VERDE, TELA_AMARELO, 0, true,
+      { FASE_TRAVESSIA_BAIRRO, FASE_TRAVESSIA_BAIRRO, FASE_TRAVESSIA_BAIRRO } },
+    // FASE_TRAVESSIA_CENTRO: conta 5..1
+    { duracao_travessia, duracao_travessia, duracao_travessia, FASE_SAIDA_VERMELHO, TELA_TRAVESSIA_CENTRO,
+      TEMPO_TRAVESSIA / INTERVALO_CONTAGEM, false,
+      { FASE_VERMELHO, FASE_AMARELO_CENTRO, FASE_AMARELO_BAIRRO } },
+    // FASE_TRAVESSIA_BAIRRO
+    { duracao_travessia, duracao_travessia, duracao_travessia, FASE_SAIDA_VERMELHO, TELA_TRAVESSIA_BAIRRO,
+      TEMPO_TRAVESSIA / INTERVALO_CONTAGEM, false,
+      { FASE_VERMELHO, FASE_AMARELO_CENTRO, FASE_AMARELO_BAIRRO } },
+};
+
+constexpr const char *fases_nomes[FASE_N] = {
+    "Vermelho", "Verde", "Amarelo", "Amarelo (Centro)", "Amarelo (Bairro)",
+    "Travessia Centro", "Travessia Bairro",
+};
+
+// Toda transição aponta para uma fase existente e toda fase tem duração e tela válidas
+constexpr bool tabela_bem_formada() {
+    for (const fase_t &f : fases_tabela) {
+        if (f.duracao_ms == 0 || f.tela >= TELA_N || f.saidas == 0) return false;
+        for (uint8_t proxima : f.proxima) {
+            if (proxima >= FASE_N) return false;
+        }
+    }
+    return true;
+}
+
+// Fases com contagem regressiva são travessias: só o vermelho aceso, e o último número
+// fica visível por um intervalo inteiro antes do fim
+constexpr bool travessias_seguras() {
+    for (const fase_t &f : fases_tabela) {
+        if (f.contagem == 0) continue;
+        if (f.saidas != FASE_SAIDA_VERMELHO) return false;
+        if ((uint32_t)f.contagem * INTERVALO_CONTAGEM >= f.duracao_ms) return false;
+    }
+    return true;
+}
+
+// Só se entra em uma travessia vindo de um amarelo, nunca direto do verde
+constexpr bool travessias_precedidas_de_amarelo() {
+    for (const fase_t &f : fases_tabela) {
+        for (uint8_t proxima : f.proxima) {
+            if (fases_tabela[proxima].contagem != 0 && f.saidas != (FASE_SAIDA_VERMELHO | FASE_SAIDA_VERDE)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Uma fase que atende o pedido já decidiu o destino: os pedidos novos não o mudam
+constexpr bool destino_fixo_ao_atender() {
+    for (const fase_t &f : fases_tabela) {
+        if (f.consome_pedido && (f.proxima[PEDIDO_A] != f.proxima[PEDIDO_NENHUM] ||
+                                 f.proxima[PEDIDO_B] != f.proxima[PEDIDO_NENHUM])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Só o verde se adapta à demanda, dentro dos seus limites: amarelos e travessias têm duração
+// fixa, e o verde mínimo ainda passa de um amarelo
+constexpr bool duracoes_adaptativas_seguras() {
+    for (const fase_t &f : fases_tabela) {
+        if (f.duracao_min_ms > f.duracao_ms || f.duracao_ms > f.duracao_max_ms || f.duracao_min_ms == 0) return false;
+        bool adaptativa = f.duracao_min_ms != f.duracao_ms || f.duracao_max_ms != f.duracao_ms;
+        if (adaptativa && (f.saidas != FASE_SAIDA_VERDE || f.duracao_min_ms < TEMPO_AMARELO)) return false;
+    }
+    return true;
+}
+
+// Pior caso entre um pedido passar à frente e a sua travessia começar: o resto da fase mais
+// longa que não atende pedidos (com pedido esperando ela não se estende), o amarelo e a
+// travessia da outra faixa, se o pedido dela for ainda mais antigo, e o próprio amarelo
+constexpr uint32_t pior_atendimento_ms() {
+    uint32_t fase_max = 0, outra_faixa_max = 0, amarelo_max = 0;
+    for (const fase_t &f : fases_tabela) {
+        if (!f.consome_pedido) {
+            fase_max = f.duracao_ms > fase_max ? f.duracao_ms : fase_max;
+            continue;
+        }
+        uint32_t atendimento = f.duracao_ms + fases_tabela[f.proxima[PEDIDO_NENHUM]].duracao_ms;
+        outra_faixa_max = atendimento > outra_faixa_max ? atendimento : outra_faixa_max;
+        amarelo_max = f.duracao_ms > amarelo_max ? f.duracao_ms : amarelo_max;
+    }
+    return fase_max + outra_faixa_max + amarelo_max;
+}
+
+constexpr uint32_t fases_envelhecimento_ms = ESPERA_MAX_PEDESTRE - pior_atendimento_ms();
+
+// Toda contagem tem a sua página pré-renderizada em telas.cpp
+constexpr bool contagens_pre_renderizadas() {
+    for (const fase_t &f : fases_tabela) {
+        if (f.contagem > telas_contagem_max) return false;
+    }
+    return true;
+}
+
+// Todas as fases são alcançáveis a partir do vermelho inicial
+constexpr bool todas_alcancaveis() {
+    bool alcancada[FASE_N] = {};
+    alcancada[FASE_VERMELHO] = true;
+    for (int passo = 0; passo < FASE_N; passo++) {
+        for (int i = 0; i < FASE_N; i++) {
+            if (!alcancada[i]) continue;
+            for (uint8_t proxima : fases_tabela[i].proxima) {
+                alcancada[proxima] = true;
+            }
+        }
+    }
+    for (bool a : alcancada) {
+        if (!a) return false;
+    }
+    return true;
+}
+
+static_assert(tabela_bem_formada(), "transicao para fase inexistente ou fase sem duracao/tela/saidas");
+static_assert(travessias_seguras(), "travessia com verde aceso ou sem tempo para o ultimo numero");
+static_assert(travessias_precedidas_de_amarelo(), "travessia sem amarelo antes");
+static_assert(destino_fixo_ao_atender(), "fase que atende pedido com destino variavel");
+static_assert(duracoes_adaptativas_seguras(), "duracao adaptativa fora do verde ou fora dos limites");
+static_assert(ESPERA_MAX_PEDESTRE > pior_atendimento_ms(), "ESPERA_MAX_PEDESTRE menor que o pior caso de atendimento");
+static_assert(contagens_pre_renderizadas(), "contagem maior que telas_contagem_max");
+static_assert(todas_alcancaveis(), "fase inalcancavel a partir do vermelho");
+static_assert(fases_tabela[FASE_TRAVESSIA_CENTRO].tela == TELA_TRAVESSIA_CENTRO &&
+              fases_tabela[FASE_TRAVESSIA_BAIRRO].tela == TELA_TRAVESSIA_BAIRRO,
+              "linhas da tabela fora da ordem de fase_id_t");
@@ -0,0 +1,79 @@
+#include "pico/stdlib.h"
+#include "servico_display.h"
+
+#ifndef fases_inc_h
+#define fases_inc_h
+
+// Definição dos tempos de controle do semáforo e travessia
+#define TEMPO_VERMELHO     10000 // 10s no vermelho
+#define TEMPO_VERDE        10000 // 10s no verde
+#define TEMPO_AMARELO      3000  // 3s no amarelo
+#define TEMPO_TRAVESSIA    5000  // 5s de travessia para pedestre
+#define INTERVALO_CONTAGEM 1000  // 1s entre cada decremento da contagem
+
+// Limites do verde adaptativo: encolhe com pedestres esperando e se estende sem eles
+#define TEMPO_VERDE_MIN    5000  // Verde mínimo mesmo com pedestres esperando
+#define TEMPO_VERDE_MAX    20000 // Verde máximo sem nenhum pedido
+#define PASSO_REDUCAO      2000  // Encurtamento por pedestre esperando
+#define PASSO_EXTENSAO     5000  // Extensão a cada prazo vencido sem pedido
+
+// Maior espera de um pedestre, do aperto ao início da sua travessia; precisa cobrir o pior caso
+// de atendimento de um pedido que passou à frente (conferido em fases.cpp)
+#ifndef ESPERA_MAX_PEDESTRE
+#define ESPERA_MAX_PEDESTRE 40000
+#endif
+
+// Fases do ciclo; a ordem é a das linhas de fases_tabela
+typedef enum {
+    FASE_VERMELHO,
+    FASE_VERDE,
+    FASE_AMARELO,
+    FASE_AMARELO_CENTRO,    // Amarelo que antecede a travessia do Centro
+    FASE_AMARELO_BAIRRO,    // Amarelo que antecede a travessia do Bairro
+    FASE_TRAVESSIA_CENTRO,
+    FASE_TRAVESSIA_BAIRRO,
+    FASE_N
+} fase_id_t;
+
+// Pedido de travessia pendente; indexa a coluna de próxima fase na tabela
+typedef enum {
+    PEDIDO_NENHUM,
+    PEDIDO_A, // Botão A (Centro), tem prioridade sobre o B até o B envelhecer
+    PEDIDO_B, // Botão B (Bairro)
+    PEDIDO_N
+} pedido_t;
+
+// Saídas acesas em cada fase
+#define FASE_SAIDA_VERMELHO 0x01
+#define FASE_SAIDA_VERDE    0x02
+
+// Linha da tabela de transições: tudo o que o laço principal precisa para entrar na fase e
+// decidir a seguinte, sem lógica específica de cada fase
+typedef struct {
+    uint32_t duracao_ms;          // Tempo até o fim da fase
+    uint32_t duracao_min_ms;      // Menor duração com pedestres esperando (= duracao_ms: fixa)
+    uint32_t duracao_max_ms;      // Maior duração sem pedidos (= duracao_ms: fixa)
+    uint8_t saidas;               // FASE_SAIDA_*
+    uint8_t tela;                 // tela_t mostrada ao entrar
+    uint8_t contagem;             // Segundos de contagem regressiva com buzzer (0 = sem)
+    bool consome_pedido;          // Entrar na fase atende o pedido pendente
+    uint8_t proxima[PEDIDO_N];    // Próxima fase conforme o pedido pendente ao fim desta
+} fase_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tabela gerada e validada em tempo de compilação (fases.cpp)
+extern const fase_t fases_tabela[FASE_N];
+extern const char *const fases_nomes[FASE_N];
+
+// Espera a partir da qual um pedido passa à frente da prioridade do Centro: ESPERA_MAX_PEDESTRE
+// menos o pior caso até a sua travessia começar
+extern const uint32_t fases_envelhecimento_ms;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "log.h"
+
+// Um anel por núcleo. No anel de cada núcleo os produtores (laço e interrupções daquele
+// núcleo) gravam com as interrupções mascaradas enquanto copiam o registro; o único
+// consumidor é log_drenar no laço do core0. Só o produtor escreve "cabeca" e só o
+// consumidor escreve "cauda", como na fila de eventos.
+typedef struct {
+    log_registro_t registros[log_capacidade];
+    volatile uint32_t cabeca;
+    volatile uint32_t cauda;
+    log_estatisticas_t estatisticas; // Escritas só pelo núcleo dono do anel
+} log_anel_t;
+
+static log_anel_t aneis[log_nucleos];
+static uint32_t descartados_avisados = 0;
+
+static const char *prefixos[LOG_DEPURACAO + 1] = { "ERRO: ", "AVISO: ", "", "DEPURACAO: " };
+
+// Copia o registro para o anel do núcleo atual; retorna false (e conta a perda) se estiver cheio
+bool log_gravar(uint8_t nivel, const char *formato, const uintptr_t *args, uint8_t n_args) {
+    log_anel_t *anel = &aneis[get_core_num()];
+    uint32_t irq_state = save_and_disable_interrupts();
+    uint32_t posicao = anel->cabeca;
+    uint32_t ocupacao = posicao - anel->cauda;
+
+    if (ocupacao == log_capacidade) {
+        anel->estatisticas.descartados++;
+        restore_interrupts(irq_state);
+        return false;
+    }
+
+    log_registro_t *r = &anel->registros[posicao & (log_capacidade - 1)];
+    r->formato = formato;
+    r->nivel = nivel;
+    r->n_args = n_args;
+    for (uint8_t i = 0; i < n_args; i++) {
+        r->args[i] = args[i];
+    }
+
+    anel->estatisticas.gravados[nivel]++;
+    if (ocupacao + 1 > anel->estatisticas.maior_ocupacao) {
+        anel->estatisticas.maior_ocupacao = ocupacao + 1;
+    }
+    __dmb(); // O registro precisa estar completo antes de ficar visível à drenagem
+    anel->cabeca = posicao + 1;
+    restore_interrupts(irq_state);
+    return true;
+}
+
+// Formata um registro: cada conversão do formato é passada ao snprintf com o tipo que ela
+// espera (%s recebe o ponteiro, %l/%ll o inteiro estendido, o resto int ou unsigned)
+static void formatar(const log_registro_t *r, char *linha, size_t tamanho) {
+    size_t n = strlen(strcpy(linha, prefixos[r->nivel]));
+    uint8_t arg = 0;
+
+    for (const char *p = r->formato; *p != '\0' && n < tamanho - 1; ) {
+        if (*p != '%') {
+            linha[n++] = *p++;
+            continue;
+        }
+
+        char especificacao[16];
+        size_t e = 0;
+        int longos = 0;
+        especificacao[e++] = *p++;
+        while (*p != '\0' && strchr("diouxXcsp%", *p) == NULL && e < sizeof(especificacao) - 2) {
+            longos += *p == 'l';
+            especificacao[e++] = *p++;
+        }
+        char conversao = *p;
+        if (conversao == '\0') break;
+        especificacao[e++] = *p++;
+        especificacao[e] = '\0';
+
+        uintptr_t valor = conversao != '%' && arg < r->n_args ? r->args[arg++] : 0;
+        int escritos;
+        if (conversao == '%') {
+            escritos = snprintf(linha + n, tamanho - n, "%%");
+        } else if (conversao == 's' || conversao == 'p') {
+            escritos = snprintf(linha + n, tamanho - n, especificacao, (const char *)valor);
+        } else if (conversao == 'd' || conversao == 'i') {
+            escritos = longos >= 2 ? snprintf(linha + n, tamanho - n, especificacao, (long long)(intptr_t)valor)
+                     : longos ? snprintf(linha + n, tamanho - n, especificacao, (long)(intptr_t)valor)
+                     : snprintf(linha + n, tamanho - n, especificacao, (int)valor);
+        } else {
+            escritos = longos >= 2 ? snprintf(linha + n, tamanho - n, especificacao, (unsigned long long)valor)
+                     : longos ? snprintf(linha + n, tamanho - n, especificacao, (unsigned long)valor)
+                     : snprintf(linha + n, tamanho - n, especificacao, (unsigned)valor);
+        }
+        if (escritos < 0) break;
+        n += (size_t)escritos < tamanho - n ? (size_t)escritos : tamanho - n - 1;
+    }
+    linha[n] = '\0';
+}
+
+// Formata e envia ao stdio até log_por_drenagem registros (chamada no laço principal do
+// core0); retorna quantos foram enviados
+uint32_t log_drenar() {
+    uint32_t enviados = 0;
+    char linha[160];
+
+    for (int nucleo = 0; nucleo < log_nucleos; nucleo++) {
+        log_anel_t *anel = &aneis[nucleo];
+        while (enviados < log_por_drenagem && anel->cauda != anel->cabeca) {
+            __dmb();
+            log_registro_t r = anel->registros[anel->cauda & (log_capacidade - 1)];
+            __dmb(); // Cópia concluída antes de liberar a posição ao produtor
+            anel->cauda++;
+
+            formatar(&r, linha, sizeof(linha));
+            puts(linha);
+            enviados++;
+        }
+    }
+
+    uint32_t descartados = aneis[0].estatisticas.descartados + aneis[1].estatisticas.descartados;
+    if (descartados != descartados_avisados) {
+        printf("AVISO: log: %lu mensagens descartadas\n", (unsigned long)(descartados - descartados_avisados));
+        descartados_avisados = descartados;
+    }
+    return enviados;
+}
+
+// Drena tudo o que estiver pendente (antes de despejos longos ou ao encerrar)
+void log_drenar_tudo() {
+    while (log_drenar() > 0) {
+    }
+}
+
+// Soma os contadores dos dois anéis (leituras de 32 bits, sem travar o outro núcleo)
+void log_obter_estatisticas(log_estatisticas_t *saida) {
+    memset(saida, 0, sizeof(*saida));
+    for (int nucleo = 0; nucleo < log_nucleos; nucleo++) {
+        const log_estatisticas_t *e = &aneis[nucleo].estatisticas;
+        for (int nivel = 0; nivel <= LOG_DEPURACAO; nivel++) {
+            saida->gravados[nivel] += e->gravados[nivel];
+        }
+        saida->descartados += e->descartados;
+        if (e->maior_ocupacao > saida->maior_ocupacao) {
+            saida->maior_ocupacao = e->maior_ocupacao;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#include "pico/stdlib.h"
+
+#ifndef log_inc_h
+#define log_inc_h
+
+// Log diferido: quem registra (inclusive interrupções) só copia o formato e os argumentos para
+// um anel, em poucos ciclos; log_drenar, no laço principal, formata e envia ao stdio USB.
+//
+// O formato precisa ser uma string constante e os argumentos inteiros de até 32 bits ou
+// ponteiros para strings constantes (%s), pois a formatação acontece depois.
+
+// Níveis; LOG_NIVEL (padrão LOG_INFO) escolhe em tempo de compilação quais chamadas existem.
+// As de nível acima viram código morto: o compilador as remove, mas ainda confere os argumentos
+#define LOG_ERRO      0
+#define LOG_AVISO     1
+#define LOG_INFO      2
+#define LOG_DEPURACAO 3
+
+#ifndef LOG_NIVEL
+#define LOG_NIVEL LOG_INFO
+#endif
+
+#define log_nucleos     2
+#define log_capacidade  64 // Registros por núcleo (precisa ser potência de 2)
+#define log_max_args    6
+#define log_por_drenagem 8 // Registros formatados a cada chamada de log_drenar
+
+typedef struct {
+    const char *formato;
+    uint8_t nivel;
+    uint8_t n_args;
+    uintptr_t args[log_max_args];
+} log_registro_t;
+
+// Contadores por nível (gravados) e de perdas por anel cheio
+typedef struct {
+    uint32_t gravados[LOG_DEPURACAO + 1];
+    uint32_t descartados;
+    uint32_t maior_ocupacao; // Maior quantidade de registros esperando a drenagem
+} log_estatisticas_t;
+
+#define log_escrever(nivel, formato, ...) do {                                          \
+    const uintptr_t log_args_[] = { 0, ##__VA_ARGS__ };                                 \
+    static_assert(count_of(log_args_) - 1 <= log_max_args, "argumentos demais no log"); \
+    log_gravar((nivel), (formato), log_args_ + 1, count_of(log_args_) - 1);             \
+} while (0)
+
+#if LOG_NIVEL >= LOG_ERRO
+#define log_erro(formato, ...) log_escrever(LOG_ERRO, formato, ##__VA_ARGS__)
+#else
+#define log_erro(formato, ...) do { if (0) log_escrever(LOG_ERRO, formato, ##__VA_ARGS__); } while (0)
+#endif
+
+#if LOG_NIVEL >= LOG_AVISO
+#define log_aviso(formato, ...) log_escrever(LOG_AVISO, formato, ##__VA_ARGS__)
+#else
+#define log_aviso(formato, ...) do { if (0) log_escrever(LOG_AVISO, formato, ##__VA_ARGS__); } while (0)
+#endif
+
+#if LOG_NIVEL >= LOG_INFO
+#define log_info(formato, ...) log_escrever(LOG_INFO, formato, ##__VA_ARGS__)
+#else
+#define log_info(formato, ...) do { if (0) log_escrever(LOG_INFO, formato, ##__VA_ARGS__); } while (0)
+#endif
+
+#if LOG_NIVEL >= LOG_DEPURACAO
+#define log_depuracao(formato, ...) log_escrever(LOG_DEPURACAO, formato, ##__VA_ARGS__)
+#else
+#define log_depuracao(formato, ...) do { if (0) log_escrever(LOG_DEPURACAO, formato, ##__VA_ARGS__); } while (0)
+#endif
+
+bool log_gravar(uint8_t nivel, const char *formato, const uintptr_t *args, uint8_t n_args);
+uint32_t log_drenar();
+void log_drenar_tudo();
+void log_obter_estatisticas(log_estatisticas_t *saida);
+
+#endif
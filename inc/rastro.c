@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "rastro.h"
+
+#if SEMAFORO_RASTRO
+
+// Um anel por núcleo: cada núcleo só escreve no seu, então não há disputa entre núcleos. No
+// mesmo núcleo, o laço principal e as interrupções gravam com as interrupções mascaradas por
+// poucas instruções (cópia de 16 bytes), sem travas.
+typedef struct {
+    rastro_registro_t registros[rastro_capacidade];
+    volatile uint32_t gravados; // Total desde o início; publicado depois do registro completo
+} rastro_anel_t;
+
+static_assert(sizeof(rastro_registro_t) == 16, "registro do rastro fora do formato do despejo");
+
+static rastro_anel_t aneis[rastro_nucleos];
+static volatile bool pausado = false;
+
+// Grava um registro no anel do núcleo atual (chamada a partir de interrupções ou do laço)
+void rastro_gravar(rastro_evento_t evento, uint32_t dados, uint64_t instante_us) {
+    if (pausado) return;
+
+    rastro_anel_t *anel = &aneis[get_core_num()];
+    uint32_t irq_state = save_and_disable_interrupts();
+    uint32_t posicao = anel->gravados;
+    rastro_registro_t *r = &anel->registros[posicao & (rastro_capacidade - 1)];
+    r->instante_us = instante_us;
+    r->dados = dados;
+    r->evento = evento;
+    __dmb();
+    anel->gravados = posicao + 1;
+    restore_interrupts(irq_state);
+}
+
+static void escrever(const void *dados, size_t tamanho) {
+    const uint8_t *bytes = dados;
+    for (size_t i = 0; i < tamanho; i++) {
+        putchar_raw(bytes[i]); // Sem a tradução de \n para \r\n do stdio
+    }
+}
+
+static void escrever_u32(uint32_t valor) {
+    uint8_t bytes[4] = { valor, valor >> 8, valor >> 16, valor >> 24 };
+    escrever(bytes, sizeof(bytes));
+}
+
+// Despeja os anéis pela USB: "RSTR", versão, tamanho do registro, núcleos, reservado e, para
+// cada núcleo, total gravado, quantidade despejada e os registros do mais antigo ao mais novo.
+// A posição seguinte ao último registro pode estar sendo escrita pelo outro núcleo no instante
+// da pausa, então um anel cheio é despejado sem o seu registro mais antigo.
+void rastro_despejar() {
+    pausado = true;
+    __dmb();
+
+    static const uint8_t cabecalho[8] = { 'R', 'S', 'T', 'R', 1, sizeof(rastro_registro_t), rastro_nucleos, 0 };
+    escrever(cabecalho, sizeof(cabecalho));
+
+    for (int n = 0; n < rastro_nucleos; n++) {
+        const rastro_anel_t *anel = &aneis[n];
+        uint32_t gravados = anel->gravados;
+        uint32_t quantidade = gravados < rastro_capacidade ? gravados : rastro_capacidade - 1;
+
+        escrever_u32(gravados);
+        escrever_u32(quantidade);
+        for (uint32_t i = gravados - quantidade; i != gravados; i++) {
+            escrever(&anel->registros[i & (rastro_capacidade - 1)], sizeof(rastro_registro_t));
+        }
+    }
+    stdio_flush();
+
+    pausado = false;
+}
+
+// Chegada de caracteres pela USB (interrupção do stdio): só avisa o laço principal
+static volatile bool serial_pendente = false;
+
+static void serial_callback(void *param) {
+    serial_pendente = true;
+}
+
+void rastro_iniciar_serial() {
+    stdio_set_chars_available_callback(serial_callback, NULL);
+}
+
+// Chamada no laço principal: lê os comandos recebidos e despeja o rastro quando pedido
+void rastro_atender_serial() {
+    if (!serial_pendente) return;
+    serial_pendente = false;
+
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if (c == RASTRO_COMANDO_DESPEJAR) {
+            rastro_despejar();
+        }
+    }
+}
+
+#endif
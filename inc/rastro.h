@@ -0,0 +1,64 @@
+#include "pico/stdlib.h"
+
+#ifndef rastro_inc_h
+#define rastro_inc_h
+
+// Rastro binário de eventos para medir latências em campo. Liga-se em tempo de compilação com
+// SEMAFORO_RASTRO=1; desligado, rastro_registrar não gera código nenhum.
+#ifndef SEMAFORO_RASTRO
+#define SEMAFORO_RASTRO 0
+#endif
+
+// Registros por núcleo (precisa ser potência de 2); quando cheio, sobrescreve os mais antigos
+#ifndef rastro_capacidade
+#define rastro_capacidade 1024
+#endif
+
+#define rastro_nucleos 2
+
+// Identificadores dos pontos de registro (tools/rastro.py mantém a mesma numeração)
+typedef enum {
+    RASTRO_IRQ_ENTRADA = 1, // dados = fonte << 8 | detalhe (gpio do botão)
+    RASTRO_IRQ_SAIDA,       // dados = fonte << 8 | detalhe
+    RASTRO_FASE,            // dados = cruzamento << 8 | fase_id_t
+    RASTRO_BUZZER_LIGA,     // dados = cruzamento << 8 | buzzer_cadencia_t (troca de cadência)
+    RASTRO_BUZZER_DESLIGA,  // dados = cruzamento << 8 | BUZZER_SILENCIO
+    RASTRO_DISPLAY_PEDIDO,  // dados = servico_display_comando(tela, contagem, aviso) (core0)
+    RASTRO_FLUSH_INICIO,    // dados = bytes sujos << 8 | ssd1306_flush_status_t (core1)
+    RASTRO_FLUSH_FIM,       // Fim da transferência DMA do quadro (core1)
+} rastro_evento_t;
+
+// Fontes de interrupção
+#define RASTRO_FONTE_GPIO   1 // Borda do botão (sem máquina de estados da PIO livre)
+#define RASTRO_FONTE_ALARME 2
+#define RASTRO_FONTE_PIO    3 // Aperto já filtrado pela PIO
+
+// Registro de tamanho fixo, gravado como está no despejo (little-endian)
+typedef struct {
+    uint64_t instante_us; // time_us_64
+    uint32_t dados;
+    uint8_t evento;       // rastro_evento_t
+    uint8_t reservado[3];
+} rastro_registro_t;
+
+#if SEMAFORO_RASTRO
+#define rastro_registrar(evento, dados) rastro_gravar((evento), (dados), time_us_64())
+#define rastro_registrar_em(evento, dados, instante_us) rastro_gravar((evento), (dados), (instante_us))
+#define rastro_iniciar() rastro_iniciar_serial()
+#define rastro_atender() rastro_atender_serial()
+#else
+#define rastro_registrar(evento, dados) ((void)0)
+#define rastro_registrar_em(evento, dados, instante_us) ((void)0)
+#define rastro_iniciar() ((void)0)
+#define rastro_atender() ((void)0)
+#endif
+
+// Comando recebido pelo monitor serial que dispara o despejo
+#define RASTRO_COMANDO_DESPEJAR 'R'
+
+void rastro_gravar(rastro_evento_t evento, uint32_t dados, uint64_t instante_us);
+void rastro_despejar();
+void rastro_iniciar_serial();
+void rastro_atender_serial();
+
+#endif
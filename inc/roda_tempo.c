@@ -0,0 +1,285 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+#include "hardware/sync.h"
+#include "roda_tempo.h"
+#include "rastro.h"
+
+// Cada posição é a cabeça (sentinela) de uma lista circular duplamente ligada, então inserir
+// e remover não têm casos especiais. Um temporizador com prazo além de uma volta fica na mesma
+// lista e é ignorado até o tick certo (comparação pelo tick absoluto).
+//
+// A roda não tem tick periódico: o alarme é programado para o próximo tick com temporizador
+// armado, e entre dois prazos o núcleo pode dormir sem interrupções. O mapa "ocupadas" tem um
+// bit por posição com lista não vazia, então a busca pula as posições vazias 32 por vez.
+#define roda_palavras (roda_posicoes / 32)
+
+static roda_temporizador_t posicoes[roda_posicoes];
+static uint32_t ocupadas[roda_palavras];
+static uint alarme;
+static uint64_t base_us;
+static volatile uint32_t tick_atual; // Próximo tick a ser processado
+static uint32_t tick_alvo;           // Tick para o qual o alarme está programado
+static volatile bool alvo_ativo = false;
+static bool em_irq = false;
+static roda_estatisticas_t estatisticas;
+
+static void inserir(roda_temporizador_t *cabeca, roda_temporizador_t *t) {
+    t->proximo = cabeca;
+    t->anterior = cabeca->anterior;
+    cabeca->anterior->proximo = t;
+    cabeca->anterior = t;
+}
+
+static void remover(roda_temporizador_t *t) {
+    t->anterior->proximo = t->proximo;
+    t->proximo->anterior = t->anterior;
+    t->proximo = NULL;
+    t->anterior = NULL;
+}
+
+// Inserção e remoção nas listas das posições, mantendo o mapa de ocupadas
+static void ocupar(roda_temporizador_t *t) {
+    uint32_t posicao = t->tick & (roda_posicoes - 1);
+    inserir(&posicoes[posicao], t);
+    ocupadas[posicao / 32] |= 1u << (posicao % 32);
+}
+
+static void liberar_se_vazia(uint32_t posicao) {
+    if (posicoes[posicao].proximo == &posicoes[posicao]) {
+        ocupadas[posicao / 32] &= ~(1u << (posicao % 32));
+    }
+}
+
+static void desocupar(roda_temporizador_t *t) {
+    remover(t);
+    liberar_se_vazia(t->tick & (roda_posicoes - 1));
+}
+
+// Primeira posição ocupada a partir de "desde" (sem dar a volta), ou roda_posicoes se não houver;
+// no RP2040 o __builtin_ctz vem do pico_bit_ops (o Cortex-M0+ não tem CLZ)
+static uint32_t proxima_ocupada(uint32_t desde) {
+    uint32_t palavra = desde / 32;
+    uint32_t bits = ocupadas[palavra] & (~0u << (desde % 32));
+    while (bits == 0) {
+        if (++palavra == roda_palavras) {
+            return roda_posicoes;
+        }
+        bits = ocupadas[palavra];
+    }
+    return palavra * 32 + (uint32_t)__builtin_ctz(bits);
+}
+
+static uint64_t instante_do_tick(uint32_t tick) {
+    return base_us + (uint64_t)tick * roda_tick_us;
+}
+
+// Processa a posição de um tick: primeiro separa os vencidos, depois chama os callbacks, que
+// podem rearmar a si mesmos ou cancelar outros temporizadores com segurança
+static void processar_tick(uint32_t tick) {
+    roda_temporizador_t *cabeca = &posicoes[tick & (roda_posicoes - 1)];
+    roda_temporizador_t vencidos = { &vencidos, &vencidos };
+
+    for (roda_temporizador_t *t = cabeca->proximo, *seguinte; t != cabeca; t = seguinte) {
+        seguinte = t->proximo;
+        if ((int32_t)(t->tick - tick) <= 0) {
+            remover(t);
+            inserir(&vencidos, t);
+        }
+    }
+    liberar_se_vazia(tick & (roda_posicoes - 1));
+
+    while (vencidos.proximo != &vencidos) {
+        roda_temporizador_t *t = vencidos.proximo;
+        remover(t);
+
+        uint64_t agora = time_us_64();
+        uint32_t atraso = agora > t->prazo_us ? (uint32_t)(agora - t->prazo_us) : 0;
+        if (atraso > estatisticas.atraso_max_us) {
+            estatisticas.atraso_max_us = atraso;
+        }
+        estatisticas.atraso_total_us += atraso;
+        estatisticas.disparos++;
+
+        t->callback(t);
+    }
+}
+
+// Processa todos os ticks até "agora" (inclusive); depois de uma lacuna maior que uma volta,
+// cada posição é visitada uma única vez, já comparando com o tick mais recente dela
+static void avancar_ate(uint32_t agora) {
+    if ((int32_t)(agora - tick_atual) < 0) {
+        return;
+    }
+
+    uint32_t tick = agora - tick_atual >= roda_posicoes ? agora - roda_posicoes + 1 : tick_atual;
+    tick_atual = agora + 1; // Rearmes feitos nos callbacks caem no próximo tick
+    for (; tick != agora + 1; tick++) {
+        uint32_t posicao = tick & (roda_posicoes - 1);
+        if (ocupadas[posicao / 32] & (1u << (posicao % 32))) {
+            processar_tick(tick);
+        }
+    }
+}
+
+// Próximo tick com temporizador armado: o primeiro que vence dentro de uma volta ou, se não
+// houver, o menor tick entre os que estão além dela; retorna false com a roda vazia. Só as
+// posições ocupadas são visitadas, a partir da do tick atual e dando a volta no mapa
+static bool proximo_tick(uint32_t *saida) {
+    const uint32_t inicio = tick_atual & (roda_posicoes - 1);
+    bool achou = false;
+
+    estatisticas.buscas++;
+    for (uint32_t i = 0; i < roda_posicoes; i++) {
+        uint32_t desde = (inicio + i) & (roda_posicoes - 1);
+        uint32_t posicao = proxima_ocupada(desde);
+        if (posicao == roda_posicoes) {
+            i += roda_posicoes - desde - 1; // Nada até o fim do mapa: continua da posição 0
+            continue;
+        }
+        i += posicao - desde;
+        if (i >= roda_posicoes) {
+            break;
+        }
+
+        uint32_t tick = tick_atual + i;
+        roda_temporizador_t *cabeca = &posicoes[posicao];
+        estatisticas.listas_visitadas++;
+        for (roda_temporizador_t *t = cabeca->proximo; t != cabeca; t = t->proximo) {
+            if (t->tick == tick) {
+                *saida = tick;
+                return true;
+            }
+            if (!achou || (int32_t)(t->tick - *saida) < 0) {
+                *saida = t->tick;
+                achou = true;
+            }
+        }
+    }
+    return achou;
+}
+
+// Interrupção do alarme: processa os ticks vencidos e programa o alarme para o próximo tick
+// armado; se esse alvo já passou enquanto processava, processa de novo em vez de perdê-lo
+static void roda_tick_irq(uint numero) {
+    uint64_t inicio = time_us_64();
+    uint32_t disparos = estatisticas.disparos;
+
+    // Latência de despertar: do instante programado até a entrada nesta interrupção
+    if (alvo_ativo && inicio >= instante_do_tick(tick_alvo)) {
+        uint32_t latencia = (uint32_t)(inicio - instante_do_tick(tick_alvo));
+        if (latencia > estatisticas.despertar_max_us) {
+            estatisticas.despertar_max_us = latencia;
+        }
+        estatisticas.despertar_total_us += latencia;
+        estatisticas.despertares++;
+    }
+    alvo_ativo = false;
+    em_irq = true;
+
+    for (;;) {
+        avancar_ate((uint32_t)((time_us_64() - base_us) / roda_tick_us));
+
+        uint32_t proximo;
+        if (!proximo_tick(&proximo)) {
+            break; // Roda vazia: sem alarme até o próximo roda_armar
+        }
+        tick_alvo = proximo;
+        alvo_ativo = true;
+        if (!hardware_alarm_set_target(alarme, from_us_since_boot(instante_do_tick(proximo)))) {
+            break;
+        }
+    }
+
+    em_irq = false;
+    estatisticas.interrupcoes++;
+    estatisticas.ocupado_us += time_us_64() - inicio;
+
+    // Só as interrupções que venceram temporizadores vão para o rastro
+    if (estatisticas.disparos != disparos) {
+        rastro_registrar_em(RASTRO_IRQ_ENTRADA, RASTRO_FONTE_ALARME << 8, inicio);
+        rastro_registrar(RASTRO_IRQ_SAIDA, RASTRO_FONTE_ALARME << 8);
+    }
+}
+
+// Reserva um alarme de hardware e começa a contar ticks a partir de agora (a base)
+void roda_iniciar() {
+    for (int i = 0; i < roda_posicoes; i++) {
+        posicoes[i].proximo = &posicoes[i];
+        posicoes[i].anterior = &posicoes[i];
+    }
+    memset(ocupadas, 0, sizeof(ocupadas));
+
+    alarme = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(alarme, roda_tick_irq);
+
+    base_us = time_us_64();
+    tick_atual = 1;
+    alvo_ativo = false; // O primeiro roda_armar programa o alarme
+}
+
+// Instante do tick 0: prazos múltiplos de roda_tick_us a partir daqui vencem sem atraso
+uint64_t roda_base_us() {
+    return base_us;
+}
+
+// Arma (ou rearma) um temporizador para um prazo absoluto; prazos passados vencem no próximo tick
+void roda_armar(roda_temporizador_t *temporizador, uint64_t prazo_us, roda_callback_t callback, void *dados) {
+    uint64_t relativo = prazo_us > base_us ? prazo_us - base_us : 0;
+    uint32_t tick = (uint32_t)((relativo + roda_tick_us - 1) / roda_tick_us);
+
+    uint32_t irq_state = save_and_disable_interrupts();
+    if (temporizador->proximo != NULL) {
+        desocupar(temporizador);
+    }
+    if ((int32_t)(tick - tick_atual) < 0) {
+        tick = tick_atual;
+    }
+
+    temporizador->prazo_us = prazo_us;
+    temporizador->tick = tick;
+    temporizador->callback = callback;
+    temporizador->dados = dados;
+    ocupar(temporizador);
+
+    // Prazo anterior ao alvo atual: adianta o alarme (dentro da interrupção, ela mesma reprograma)
+    if (!em_irq && (!alvo_ativo || (int32_t)(tick - tick_alvo) < 0)) {
+        tick_alvo = tick;
+        alvo_ativo = true;
+        if (hardware_alarm_set_target(alarme, from_us_since_boot(instante_do_tick(tick)))) {
+            hardware_alarm_force_irq(alarme); // Já passou: a interrupção processa o tick agora
+        }
+    }
+    restore_interrupts(irq_state);
+}
+
+// Cancela um temporizador armado; não faz nada se ele já venceu ou nunca foi armado
+void roda_cancelar(roda_temporizador_t *temporizador) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    if (temporizador->proximo != NULL) {
+        desocupar(temporizador);
+    }
+    restore_interrupts(irq_state);
+}
+
+// Instante em que o alarme da roda vai disparar, ou UINT64_MAX se não houver nada armado;
+// um temporizador cancelado pode deixar o alarme adiantado (a interrupção só reprograma)
+uint64_t roda_proximo_prazo_us() {
+    return alvo_ativo ? instante_do_tick(tick_alvo) : UINT64_MAX;
+}
+
+bool roda_armado(const roda_temporizador_t *temporizador) {
+    return temporizador->proximo != NULL;
+}
+
+void roda_obter_estatisticas(roda_estatisticas_t *saida) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    *saida = estatisticas;
+    restore_interrupts(irq_state);
+}
+
+void roda_zerar_estatisticas() {
+    uint32_t irq_state = save_and_disable_interrupts();
+    memset(&estatisticas, 0, sizeof(estatisticas));
+    restore_interrupts(irq_state);
+}
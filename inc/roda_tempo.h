@@ -0,0 +1,51 @@
+#include "pico/stdlib.h"
+
+#ifndef roda_tempo_inc_h
+#define roda_tempo_inc_h
+
+// Roda de temporização com hash sobre um único alarme de hardware: cada temporizador fica na
+// lista da posição (tick do prazo % roda_posicoes). Armar e cancelar são O(1). Sem tick
+// periódico: o alarme só dispara nos ticks que têm temporizador armado, achado por um mapa de
+// bits das posições ocupadas (uma palavra de 32 posições por vez).
+#define roda_posicoes 256  // Precisa ser potência de 2
+#define roda_tick_us  1000 // Resolução; os prazos vencem no primeiro tick >= prazo
+
+typedef struct roda_temporizador roda_temporizador_t;
+
+// Executado na interrupção do alarme; pode rearmar o próprio temporizador
+typedef void (*roda_callback_t)(roda_temporizador_t *temporizador);
+
+struct roda_temporizador {
+    roda_temporizador_t *proximo;  // NULL quando desarmado
+    roda_temporizador_t *anterior;
+    uint64_t prazo_us;             // Prazo absoluto pedido (time_us_64)
+    uint32_t tick;                 // Tick absoluto em que vence
+    roda_callback_t callback;
+    void *dados;
+};
+
+// Contadores da roda; o atraso é medido do prazo pedido até a chamada do callback, e o
+// despertar do instante programado no alarme até a entrada na interrupção
+typedef struct {
+    uint32_t interrupcoes;
+    uint32_t disparos;
+    uint32_t atraso_max_us;
+    uint64_t atraso_total_us;
+    uint32_t despertares;
+    uint32_t despertar_max_us;
+    uint64_t despertar_total_us;
+    uint64_t ocupado_us;           // Tempo total dentro da interrupção do alarme
+    uint32_t buscas;               // Buscas do próximo tick armado
+    uint64_t listas_visitadas;     // Listas de posições percorridas nessas buscas
+} roda_estatisticas_t;
+
+void roda_iniciar();
+uint64_t roda_base_us();
+void roda_armar(roda_temporizador_t *temporizador, uint64_t prazo_us, roda_callback_t callback, void *dados);
+void roda_cancelar(roda_temporizador_t *temporizador);
+uint64_t roda_proximo_prazo_us();
+bool roda_armado(const roda_temporizador_t *temporizador);
+void roda_obter_estatisticas(roda_estatisticas_t *saida);
+void roda_zerar_estatisticas();
+
+#endif
@@ -0,0 +1,220 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "ssd1306.h"
+#include "servico_display.h"
+#include "telas.h"
+#include "ui.h"
+#include "rastro.h"
+
+// Caixa de correio entre os núcleos: o core0 sobrescreve o comando mais recente e usa a FIFO
+// apenas como campainha. Se a FIFO estiver cheia o core1 já tem avisos pendentes e lerá o
+// comando novo de qualquer forma, então o core0 nunca espera pelo display.
+static volatile uint32_t caixa_comando;
+static volatile uint32_t caixa_instante_us;
+
+// Passo do letreiro: uma coluna a cada 5 quadros do display (~20 colunas/s)
+#define AVISO_INTERVALO SSD1306_SCROLL_5_FRAMES
+
+// Painel na variante SPI de 4 fios (spi0) em vez do I2C: os pinos do I2C passados a
+// servico_display_iniciar são ignorados e valem os abaixo
+#ifndef DISPLAY_SPI
+#define DISPLAY_SPI 0
+#endif
+#define DISPLAY_SPI_SCK 18
+#define DISPLAY_SPI_MOSI 19
+#define DISPLAY_SPI_CS 17
+#define DISPLAY_SPI_DC 20
+
+// Sem resposta do display na inicialização (ausente, ainda energizando ou barramento preso),
+// o core1 tenta de novo com espera dobrada até o máximo; o semáforo já roda no core0
+#define DISPLAY_ESPERA_INICIAL_MS 50
+#define DISPLAY_ESPERA_MAX_MS 2000
+
+static uint sda_pino, scl_pino;
+
+// Só depois do lançamento a FIFO é campainha: antes dele ela carrega o protocolo de partida
+// do core1, e o pedido fica apenas na caixa (lido pelo core1 ao terminar a inicialização)
+static volatile bool nucleo1_iniciado;
+static servico_display_estatisticas_t estatisticas;
+
+// Display controlado pelo core1 (todo o armazenamento é estático, dentro do handle)
+static ssd1306_t display;
+
+// Imagens dos widgets, recortadas das páginas pré-renderizadas (telas.cpp)
+static const uint8_t *imagem_texto(int tela) {
+    return telas_imagens.texto[tela][0];
+}
+
+static const uint8_t *imagem_prefixo(int visivel) {
+    return telas_imagens.contagem[visivel ? telas_contagem_max : 0];
+}
+
+static const uint8_t *imagem_numero(int contagem) {
+    return &telas_imagens.contagem[contagem >= 0 && contagem <= telas_contagem_max ? contagem : 0][telas_coluna_numero];
+}
+
+static const uint8_t *imagem_aviso(int visivel) {
+    return visivel ? telas_imagens.aviso : telas_imagens.contagem[0];
+}
+
+// Widgets da tela: o texto da fase e, abaixo, o prefixo e o dígito da contagem. Um passo da
+// contagem só suja o dígito. Na última página, o aviso rola pelo scroll do próprio display
+enum { WIDGET_TEXTO, WIDGET_PREFIXO, WIDGET_NUMERO, WIDGET_AVISO, N_WIDGETS };
+static ui_widget_t widgets[N_WIDGETS] = {
+    [WIDGET_TEXTO] = UI_WIDGET(0, 0, ssd1306_width, telas_paginas_texto, imagem_texto, TELA_VERMELHO),
+    [WIDGET_PREFIXO] = UI_WIDGET(0, telas_pagina_contagem, telas_coluna_numero, 1, imagem_prefixo, false),
+    [WIDGET_NUMERO] = UI_WIDGET(telas_coluna_numero, telas_pagina_contagem, telas_largura_numero, 1, imagem_numero, 0),
+    [WIDGET_AVISO] = UI_WIDGET(0, telas_pagina_aviso, ssd1306_width, 1, imagem_aviso, false),
+};
+
+const char *servico_display_texto(tela_t tela) {
+    return telas_textos[tela];
+}
+
+// Fim da transferência DMA de um quadro (interrupção do DMA, no core1)
+static void fim_envio(ssd1306_t *ssd) {
+    (void)ssd;
+    if (estatisticas.primeiro_quadro_us == 0) {
+        estatisticas.primeiro_quadro_us = time_us_32();
+    }
+    rastro_registrar(RASTRO_FLUSH_FIM, 0);
+}
+
+// Configuracao do display OLED via I2C ou SPI (executada no core1, dono do barramento). Repete
+// a sequência de inicialização até o display responder, sem nunca bloquear o core0
+static void configurar_display() {
+#if DISPLAY_SPI
+    spi_init(spi0, ssd1306_spi_clock * 1000);
+    gpio_set_function(DISPLAY_SPI_SCK, GPIO_FUNC_SPI);
+    gpio_set_function(DISPLAY_SPI_MOSI, GPIO_FUNC_SPI);
+    ssd1306_init_spi(&display, ssd1306_width, ssd1306_height, false, spi0, DISPLAY_SPI_DC, DISPLAY_SPI_CS);
+#else
+    i2c_init(i2c1, ssd1306_i2c_clock * 1000);
+    gpio_set_function(sda_pino, GPIO_FUNC_I2C);
+    gpio_set_function(scl_pino, GPIO_FUNC_I2C);
+    gpio_pull_up(sda_pino);
+    gpio_pull_up(scl_pino);
+
+    ssd1306_init_bm(&display, ssd1306_width, ssd1306_height, false, ssd1306_i2c_address, i2c1);
+    ssd1306_set_i2c_pins(&display, sda_pino, scl_pino); // Liberação do barramento preso
+#endif
+    uint32_t espera_ms = DISPLAY_ESPERA_INICIAL_MS;
+    while (true) {
+        estatisticas.tentativas_display++;
+        if (ssd1306_config(&display)) {
+            break;
+        }
+        sleep_ms(espera_ms);
+        espera_ms = MIN(espera_ms * 2, DISPLAY_ESPERA_MAX_MS);
+    }
+    ssd1306_probe_clock(&display); // Maior clock do I2C que a fiação sustenta (até 1 MHz)
+    estatisticas.display_pronto_us = time_us_32();
+    ssd1306_send_data(&display); // Limpa o display na inicializacao
+
+    ssd1306_init_dma(&display); // O IRQ do DMA fica registrado no core1
+    ssd1306_set_flush_callback(&display, fim_envio);
+}
+
+// Atualiza os widgets com a tela pedida e envia ao display só as caixas que mudaram. As páginas
+// entre a contagem e o aviso ficam sempre em branco. O letreiro é animado pelo scroll do
+// display: uma vez enviado, não há mais tráfego até a próxima mudança de tela
+static void desenhar(tela_t tela, int contagem, bool aviso) {
+    const bool letreiro = widgets[WIDGET_AVISO].valor;
+    ui_definir(&widgets[WIDGET_TEXTO], tela);
+    ui_definir(&widgets[WIDGET_PREFIXO], contagem > 0);
+    ui_definir(&widgets[WIDGET_NUMERO], contagem);
+    ui_definir(&widgets[WIDGET_AVISO], aviso);
+    if (aviso && !letreiro) {
+        // Liga no fim do envio, com o texto já no display; depois a página gira sem novos envios
+        ssd1306_scroll_start(&display, telas_pagina_aviso, telas_pagina_aviso, SSD1306_SCROLL_LEFT, AVISO_INTERVALO);
+    } else if (letreiro && !aviso) {
+        ssd1306_scroll_stop(&display); // O envio devolve a página deslocada ao quadro
+    }
+
+    ui_quadro_t quadro = ui_desenhar(&display, widgets, N_WIDGETS);
+    if (quadro.widgets == 0) {
+        rastro_registrar(RASTRO_FLUSH_INICIO, SSD1306_FLUSH_UNCHANGED); // Mesmo comando: nada a enviar
+        return;
+    }
+
+    estatisticas.bytes_sujos += quadro.bytes_sujos;
+    if (estatisticas.bytes_sujos_min == 0 || quadro.bytes_sujos < estatisticas.bytes_sujos_min) {
+        estatisticas.bytes_sujos_min = quadro.bytes_sujos;
+    }
+    if (quadro.bytes_sujos > estatisticas.bytes_sujos_max) {
+        estatisticas.bytes_sujos_max = quadro.bytes_sujos;
+    }
+
+    ssd1306_flush_status_t status = ssd1306_flush_async(&display);
+    rastro_registrar(RASTRO_FLUSH_INICIO, (uint32_t)quadro.bytes_sujos << 8 | status);
+    (void)status; // Só usado pelo rastro, que pode estar desligado
+}
+
+// Desenha o comando mais recente da caixa e mede o tempo de desenho
+static void atender_comando() {
+    uint32_t comando = caixa_comando;
+    uint32_t pedido_us = caixa_instante_us;
+    uint32_t inicio_us = time_us_32();
+
+    desenhar(servico_display_tela(comando), servico_display_contagem(comando), servico_display_aviso(comando));
+
+    uint32_t fim_us = time_us_32();
+    estatisticas.renderizados++;
+    if (fim_us - inicio_us > estatisticas.render_max_us) {
+        estatisticas.render_max_us = fim_us - inicio_us;
+    }
+    if (fim_us - pedido_us > estatisticas.pedido_ate_fim_max_us) {
+        estatisticas.pedido_ate_fim_max_us = fim_us - pedido_us;
+    }
+}
+
+// Laço do core1: aguarda a campainha, lê o comando mais recente e o desenha
+static void nucleo1_principal() {
+    configurar_display();
+    if (estatisticas.pedidos > 0) {
+        atender_comando(); // Pedido feito durante a inicialização (a campainha pode não ter tocado)
+    }
+
+    while (true) {
+        multicore_fifo_pop_blocking();
+        while (multicore_fifo_rvalid()) {
+            multicore_fifo_pop_blocking(); // Avisos acumulados se referem ao mesmo comando mais recente
+        }
+        atender_comando();
+    }
+}
+
+// Inicia o core1, que passa a ser o único dono do barramento e do framebuffer do display. Pode
+// ser chamada depois dos primeiros pedidos: o core1 desenha o último ao ficar pronto
+void servico_display_iniciar(uint sda, uint scl) {
+    sda_pino = sda;
+    scl_pino = scl;
+    multicore_launch_core1(nucleo1_principal);
+    nucleo1_iniciado = true;
+}
+
+// Pede (a partir do core0) que o core1 mostre uma tela, com ou sem o letreiro de aviso; nunca
+// bloqueia
+void servico_display_solicitar(tela_t tela, int contagem, bool aviso) {
+    uint32_t comando = servico_display_comando(tela, contagem, aviso);
+    rastro_registrar(RASTRO_DISPLAY_PEDIDO, comando);
+    caixa_instante_us = time_us_32();
+    caixa_comando = comando;
+    estatisticas.pedidos++;
+
+    if (nucleo1_iniciado && multicore_fifo_wready()) {
+        multicore_fifo_push_blocking(0); // Há espaço: não bloqueia
+    }
+}
+
+void servico_display_obter_estatisticas(servico_display_estatisticas_t *saida) {
+    *saida = estatisticas;
+}
+
+// Display do serviço, para leitura dos contadores do driver
+ssd1306_t *servico_display_ssd() {
+    return &display;
+}
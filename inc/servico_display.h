@@ -0,0 +1,47 @@
+#include "pico/stdlib.h"
+#include "ssd1306_i2c.h"
+
+#ifndef servico_display_inc_h
+#define servico_display_inc_h
+
+// Telas que o core0 pode pedir ao serviço de display do core1
+typedef enum {
+    TELA_VERMELHO,
+    TELA_VERDE,
+    TELA_AMARELO,
+    TELA_TRAVESSIA_CENTRO,
+    TELA_TRAVESSIA_BAIRRO,
+    TELA_BOTAO_A,
+    TELA_BOTAO_B,
+    TELA_N
+} tela_t;
+
+// Comando compacto trocado entre os núcleos: aviso no bit 24, tela nos bits 16..23, contagem
+// nos bits 0..15
+#define servico_display_comando(tela, contagem, aviso) \
+    (((uint32_t)((aviso) ? 1 : 0) << 24) | ((uint32_t)(tela) << 16) | ((uint32_t)(contagem) & 0xFFFF))
+#define servico_display_tela(comando) ((tela_t)(((comando) >> 16) & 0xFF))
+#define servico_display_contagem(comando) ((int)((comando) & 0xFFFF))
+#define servico_display_aviso(comando) ((bool)(((comando) >> 24) & 1))
+
+// Contadores do serviço (escritos pelo core1, lidos pelo core0)
+typedef struct {
+    uint32_t pedidos;           // Comandos enviados pelo core0
+    uint32_t renderizados;      // Quadros efetivamente desenhados (pedidos antigos são mesclados)
+    uint32_t render_max_us;     // Maior tempo de desenho + envio no core1
+    uint32_t pedido_ate_fim_max_us; // Maior tempo entre o pedido no core0 e o fim do desenho no core1
+    uint32_t bytes_sujos;       // Bytes do framebuffer marcados para envio, somados
+    uint16_t bytes_sujos_min;   // Menor e maior quantidade num quadro com algum widget alterado
+    uint16_t bytes_sujos_max;
+    uint32_t tentativas_display; // Envios da sequência de inicialização até o display responder
+    uint32_t display_pronto_us; // Instantes (desde o reset) do display inicializado e do fim do
+    uint32_t primeiro_quadro_us; // primeiro quadro; 0 enquanto não ocorreram
+} servico_display_estatisticas_t;
+
+void servico_display_iniciar(uint sda, uint scl);
+void servico_display_solicitar(tela_t tela, int contagem, bool aviso);
+const char *servico_display_texto(tela_t tela);
+void servico_display_obter_estatisticas(servico_display_estatisticas_t *saida);
+ssd1306_t *servico_display_ssd();
+
+#endif
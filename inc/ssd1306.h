@@ -8,10 +8,48 @@ extern void ssd1306_scroll(bool set);
 extern void render_on_display(uint8_t *ssd, struct render_area *area);
 extern void ssd1306_set_pixel(uint8_t *ssd, int x, int y, bool set);
 extern void ssd1306_draw_line(uint8_t *ssd, int x_0, int y_0, int x_1, int y_1, bool set);
+extern void ssd1306_fill(uint8_t *ssd, bool set);
+extern void ssd1306_fill_rect(uint8_t *ssd, int x, int y, int w, int h, bool set);
+extern void ssd1306_invert_rect(uint8_t *ssd, int x, int y, int w, int h);
+extern void ssd1306_draw_hline(uint8_t *ssd, int x, int y, int w, bool set);
+extern void ssd1306_draw_vline(uint8_t *ssd, int x, int y, int h, bool set);
+extern void ssd1306_draw_rect(uint8_t *ssd, int x, int y, int w, int h, bool set);
+extern void ssd1306_draw_progress(uint8_t *ssd, int x, int y, int w, int h, uint32_t value, uint32_t max);
 extern void ssd1306_draw_char(uint8_t *ssd, int16_t x, int16_t y, uint8_t character);
-extern void ssd1306_draw_string(uint8_t *ssd, int16_t x, int16_t y, char *string);
+extern int ssd1306_draw_string(uint8_t *ssd, int16_t x, int16_t y, const char *string);
 extern void ssd1306_command(ssd1306_t *ssd, uint8_t command);
-extern void ssd1306_config(ssd1306_t *ssd);
+extern void ssd1306_command_stream_begin(ssd1306_command_stream_t *stream);
+extern void ssd1306_command_stream_push(ssd1306_command_stream_t *stream, uint8_t command);
+extern void ssd1306_command_stream_send(ssd1306_t *ssd, ssd1306_command_stream_t *stream);
+extern bool ssd1306_config(ssd1306_t *ssd);
 extern void ssd1306_init_bm(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c);
+extern void ssd1306_init_spi(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, spi_inst_t *spi, uint dc_pin, uint cs_pin);
+extern void ssd1306_init_mock(ssd1306_t *ssd, uint8_t width, uint8_t height, ssd1306_mock_t *mock);
+extern void ssd1306_set_i2c_pins(ssd1306_t *ssd, uint sda_pin, uint scl_pin);
+extern uint32_t ssd1306_probe_clock(ssd1306_t *ssd);
 extern void ssd1306_send_data(ssd1306_t *ssd);
-extern void ssd1306_draw_bitmap(ssd1306_t *ssd, const uint8_t *bitmap);
\ No newline at end of file
+extern void ssd1306_flush(ssd1306_t *ssd);
+extern void ssd1306_init_dma(ssd1306_t *ssd);
+extern void ssd1306_set_flush_callback(ssd1306_t *ssd, ssd1306_flush_callback_t callback);
+extern ssd1306_flush_status_t ssd1306_flush_async(ssd1306_t *ssd);
+extern bool ssd1306_flush_busy(ssd1306_t *ssd);
+extern void ssd1306_flush_wait(ssd1306_t *ssd);
+extern void ssd1306_invalidate_shadow(ssd1306_t *ssd);
+extern void ssd1306_scroll_start(ssd1306_t *ssd, uint8_t start_page, uint8_t end_page, ssd1306_scroll_direction_t direction, ssd1306_scroll_interval_t interval);
+extern void ssd1306_scroll_pause(ssd1306_t *ssd);
+extern void ssd1306_scroll_resume(ssd1306_t *ssd);
+extern void ssd1306_scroll_stop(ssd1306_t *ssd);
+extern void ssd1306_mark_dirty(ssd1306_t *ssd, int x, int y, int w, int h);
+extern void ssd1306_get_diff_stats(ssd1306_t *ssd, ssd1306_diff_stats_t *stats);
+extern void ssd1306_reset_diff_stats(ssd1306_t *ssd);
+extern void ssd1306_get_bus_stats(i2c_inst_t *i2c, ssd1306_bus_stats_t *stats);
+extern uint32_t ssd1306_bus_time_us(const ssd1306_bus_stats_t *stats, uint32_t clock_khz);
+extern void ssd1306_get_transport_stats(const ssd1306_t *ssd, ssd1306_bus_stats_t *stats);
+extern uint32_t ssd1306_transport_time_us(const ssd1306_t *ssd, const ssd1306_bus_stats_t *stats);
+extern const ssd1306_transport_t ssd1306_transport_i2c;
+extern const ssd1306_transport_t ssd1306_transport_spi;
+extern const ssd1306_transport_t ssd1306_transport_mock;
+extern void ssd1306_draw_bitmap(ssd1306_t *ssd, const uint8_t *bitmap);
+extern void ssd1306_blit(ssd1306_t *ssd, const uint8_t *bitmap, int x, int y, int w, int h);
+extern void ssd1306_send_region(ssd1306_t *ssd, int x, int y, int w, int h);
+extern void ssd1306_draw_bitmap_region(ssd1306_t *ssd, const uint8_t *bitmap, int x, int y, int w, int h);
\ No newline at end of file
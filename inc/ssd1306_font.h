@@ -1,40 +1,134 @@
 
-static uint8_t font[] = {
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // Nothing
-    0x78, 0x14, 0x12, 0x11, 0x12, 0x14, 0x78, 0x00, // A
-    0x7f, 0x49, 0x49, 0x49, 0x49, 0x49, 0x7f, 0x00, // B
-    0x7e, 0x41, 0x41, 0x41, 0x41, 0x41, 0x41, 0x00, // C
-    0x7f, 0x41, 0x41, 0x41, 0x41, 0x41, 0x7e, 0x00, // D
-    0x7f, 0x49, 0x49, 0x49, 0x49, 0x49, 0x49, 0x00, // E
-    0x7f, 0x09, 0x09, 0x09, 0x09, 0x01, 0x01, 0x00, // F
-    0x7f, 0x41, 0x41, 0x41, 0x51, 0x51, 0x73, 0x00, // G
-    0x7f, 0x08, 0x08, 0x08, 0x08, 0x08, 0x7f, 0x00, // H
-    0x00, 0x00, 0x00, 0x7f, 0x00, 0x00, 0x00, 0x00, // I
-    0x21, 0x41, 0x41, 0x3f, 0x01, 0x01, 0x01, 0x00, // J
-    0x00, 0x7f, 0x08, 0x08, 0x14, 0x22, 0x41, 0x00, // K
-    0x7f, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, // L
-    0x7f, 0x02, 0x04, 0x08, 0x04, 0x02, 0x7f, 0x00, // M
-    0x7f, 0x02, 0x04, 0x08, 0x10, 0x20, 0x7f, 0x00, // N
-    0x3e, 0x41, 0x41, 0x41, 0x41, 0x41, 0x3e, 0x00, // O
-    0x7f, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e, 0x00, // P
-    0x3e, 0x41, 0x41, 0x49, 0x51, 0x61, 0x7e, 0x00, // Q
-    0x7f, 0x11, 0x11, 0x11, 0x31, 0x51, 0x0e, 0x00, // R
-    0x46, 0x49, 0x49, 0x49, 0x49, 0x30, 0x00, 0x00, // S
-    0x01, 0x01, 0x01, 0x7f, 0x01, 0x01, 0x01, 0x00, // T
-    0x3f, 0x40, 0x40, 0x40, 0x40, 0x40, 0x3f, 0x00, // U
-    0x0f, 0x10, 0x20, 0x40, 0x20, 0x10, 0x0f, 0x00, // V
-    0x7f, 0x20, 0x10, 0x08, 0x10, 0x20, 0x7f, 0x00, // W
-    0x00, 0x41, 0x22, 0x14, 0x14, 0x22, 0x41, 0x00, // X
-    0x01, 0x02, 0x04, 0x78, 0x04, 0x02, 0x01, 0x00, // Y
-    0x41, 0x61, 0x59, 0x45, 0x43, 0x41, 0x00, 0x00, // Z
-    0x3e, 0x41, 0x41, 0x49, 0x41, 0x41, 0x3e, 0x00, // 0
-    0x00, 0x00, 0x42, 0x7f, 0x40, 0x00, 0x00, 0x00, // 1
-    0x30, 0x49, 0x49, 0x49, 0x49, 0x46, 0x00, 0x00, // 2
-    0x49, 0x49, 0x49, 0x49, 0x49, 0x49, 0x36, 0x00, // 3
-    0x3f, 0x20, 0x20, 0x78, 0x20, 0x20, 0x00, 0x00, // 4
-    0x4f, 0x49, 0x49, 0x49, 0x49, 0x30, 0x00, 0x00, // 5
-    0x3f, 0x48, 0x48, 0x48, 0x48, 0x48, 0x30, 0x00, // 6
-    0x01, 0x01, 0x01, 0x61, 0x31, 0x0d, 0x03, 0x00, // 7
-    0x36, 0x49, 0x49, 0x49, 0x49, 0x49, 0x36, 0x00, // 8
-    0x06, 0x09, 0x09, 0x09, 0x09, 0x09, 0x7f, 0x00, // 9
-};
\ No newline at end of file
+// Fonte 5x7 indexada diretamente pelo código Latin-1 do caractere: buscar um glifo é um único
+// acesso à tabela, sem desvios. Cada glifo são 5 colunas (bit 0 = linha de cima); as minúsculas
+// acentuadas usam as duas linhas acima da altura-x e as maiúsculas acentuadas são desenhadas
+// com 6 linhas, abaixo do acento. Cedilhas usam a oitava linha. Códigos sem glifo ficam em branco.
+// A lista é uma X-macro: o C monta a tabela abaixo e o C++ (telas.cpp) a mesma fonte em constexpr
+#define ssd1306_font_glyphs(glyph) \
+    glyph(0x20, 0x00, 0x00, 0x00, 0x00, 0x00) /* espaço */          \
+    glyph(0x21, 0x00, 0x00, 0x5f, 0x00, 0x00) /* ! */               \
+    glyph(0x22, 0x00, 0x07, 0x00, 0x07, 0x00) /* " */               \
+    glyph(0x23, 0x14, 0x7f, 0x14, 0x7f, 0x14) /* # */               \
+    glyph(0x24, 0x24, 0x2a, 0x7f, 0x2a, 0x12) /* $ */               \
+    glyph(0x25, 0x23, 0x13, 0x08, 0x64, 0x62) /* % */               \
+    glyph(0x26, 0x36, 0x49, 0x55, 0x22, 0x50) /* & */               \
+    glyph(0x27, 0x00, 0x05, 0x03, 0x00, 0x00) /* ' */               \
+    glyph(0x28, 0x00, 0x1c, 0x22, 0x41, 0x00) /* ( */               \
+    glyph(0x29, 0x00, 0x41, 0x22, 0x1c, 0x00) /* ) */               \
+    glyph(0x2a, 0x14, 0x08, 0x3e, 0x08, 0x14) /* * */               \
+    glyph(0x2b, 0x08, 0x08, 0x3e, 0x08, 0x08) /* + */               \
+    glyph(0x2c, 0x00, 0x50, 0x30, 0x00, 0x00) /* , */               \
+    glyph(0x2d, 0x08, 0x08, 0x08, 0x08, 0x08) /* - */               \
+    glyph(0x2e, 0x00, 0x60, 0x60, 0x00, 0x00) /* . */               \
+    glyph(0x2f, 0x20, 0x10, 0x08, 0x04, 0x02) /* / */               \
+    glyph(0x30, 0x3e, 0x51, 0x49, 0x45, 0x3e) /* 0 */               \
+    glyph(0x31, 0x00, 0x42, 0x7f, 0x40, 0x00) /* 1 */               \
+    glyph(0x32, 0x42, 0x61, 0x51, 0x49, 0x46) /* 2 */               \
+    glyph(0x33, 0x21, 0x41, 0x45, 0x4b, 0x31) /* 3 */               \
+    glyph(0x34, 0x18, 0x14, 0x12, 0x7f, 0x10) /* 4 */               \
+    glyph(0x35, 0x27, 0x45, 0x45, 0x45, 0x39) /* 5 */               \
+    glyph(0x36, 0x3c, 0x4a, 0x49, 0x49, 0x30) /* 6 */               \
+    glyph(0x37, 0x01, 0x71, 0x09, 0x05, 0x03) /* 7 */               \
+    glyph(0x38, 0x36, 0x49, 0x49, 0x49, 0x36) /* 8 */               \
+    glyph(0x39, 0x06, 0x49, 0x49, 0x29, 0x1e) /* 9 */               \
+    glyph(0x3a, 0x00, 0x36, 0x36, 0x00, 0x00) /* : */               \
+    glyph(0x3b, 0x00, 0x56, 0x36, 0x00, 0x00) /* ; */               \
+    glyph(0x3c, 0x08, 0x14, 0x22, 0x41, 0x00) /* < */               \
+    glyph(0x3d, 0x14, 0x14, 0x14, 0x14, 0x14) /* = */               \
+    glyph(0x3e, 0x00, 0x41, 0x22, 0x14, 0x08) /* > */               \
+    glyph(0x3f, 0x02, 0x01, 0x51, 0x09, 0x06) /* ? */               \
+    glyph(0x40, 0x32, 0x49, 0x79, 0x41, 0x3e) /* @ */               \
+    glyph(0x41, 0x7e, 0x11, 0x11, 0x11, 0x7e) /* A */               \
+    glyph(0x42, 0x7f, 0x49, 0x49, 0x49, 0x36) /* B */               \
+    glyph(0x43, 0x3e, 0x41, 0x41, 0x41, 0x22) /* C */               \
+    glyph(0x44, 0x7f, 0x41, 0x41, 0x22, 0x1c) /* D */               \
+    glyph(0x45, 0x7f, 0x49, 0x49, 0x49, 0x41) /* E */               \
+    glyph(0x46, 0x7f, 0x09, 0x09, 0x09, 0x01) /* F */               \
+    glyph(0x47, 0x3e, 0x41, 0x49, 0x49, 0x7a) /* G */               \
+    glyph(0x48, 0x7f, 0x08, 0x08, 0x08, 0x7f) /* H */               \
+    glyph(0x49, 0x00, 0x41, 0x7f, 0x41, 0x00) /* I */               \
+    glyph(0x4a, 0x20, 0x40, 0x41, 0x3f, 0x01) /* J */               \
+    glyph(0x4b, 0x7f, 0x08, 0x14, 0x22, 0x41) /* K */               \
+    glyph(0x4c, 0x7f, 0x40, 0x40, 0x40, 0x40) /* L */               \
+    glyph(0x4d, 0x7f, 0x02, 0x0c, 0x02, 0x7f) /* M */               \
+    glyph(0x4e, 0x7f, 0x04, 0x08, 0x10, 0x7f) /* N */               \
+    glyph(0x4f, 0x3e, 0x41, 0x41, 0x41, 0x3e) /* O */               \
+    glyph(0x50, 0x7f, 0x09, 0x09, 0x09, 0x06) /* P */               \
+    glyph(0x51, 0x3e, 0x41, 0x51, 0x21, 0x5e) /* Q */               \
+    glyph(0x52, 0x7f, 0x09, 0x19, 0x29, 0x46) /* R */               \
+    glyph(0x53, 0x46, 0x49, 0x49, 0x49, 0x31) /* S */               \
+    glyph(0x54, 0x01, 0x01, 0x7f, 0x01, 0x01) /* T */               \
+    glyph(0x55, 0x3f, 0x40, 0x40, 0x40, 0x3f) /* U */               \
+    glyph(0x56, 0x1f, 0x20, 0x40, 0x20, 0x1f) /* V */               \
+    glyph(0x57, 0x3f, 0x40, 0x38, 0x40, 0x3f) /* W */               \
+    glyph(0x58, 0x63, 0x14, 0x08, 0x14, 0x63) /* X */               \
+    glyph(0x59, 0x07, 0x08, 0x70, 0x08, 0x07) /* Y */               \
+    glyph(0x5a, 0x61, 0x51, 0x49, 0x45, 0x43) /* Z */               \
+    glyph(0x5b, 0x00, 0x7f, 0x41, 0x41, 0x00) /* [ */               \
+    glyph(0x5c, 0x02, 0x04, 0x08, 0x10, 0x20) /* barra invertida */ \
+    glyph(0x5d, 0x00, 0x41, 0x41, 0x7f, 0x00) /* ] */               \
+    glyph(0x5e, 0x04, 0x02, 0x01, 0x02, 0x04) /* ^ */               \
+    glyph(0x5f, 0x40, 0x40, 0x40, 0x40, 0x40) /* _ */               \
+    glyph(0x60, 0x00, 0x01, 0x02, 0x04, 0x00) /* ` */               \
+    glyph(0x61, 0x20, 0x54, 0x54, 0x54, 0x78) /* a */               \
+    glyph(0x62, 0x7f, 0x48, 0x44, 0x44, 0x38) /* b */               \
+    glyph(0x63, 0x38, 0x44, 0x44, 0x44, 0x20) /* c */               \
+    glyph(0x64, 0x38, 0x44, 0x44, 0x48, 0x7f) /* d */               \
+    glyph(0x65, 0x38, 0x54, 0x54, 0x54, 0x18) /* e */               \
+    glyph(0x66, 0x08, 0x7e, 0x09, 0x01, 0x02) /* f */               \
+    glyph(0x67, 0x08, 0x54, 0x54, 0x54, 0x3c) /* g */               \
+    glyph(0x68, 0x7f, 0x08, 0x04, 0x04, 0x78) /* h */               \
+    glyph(0x69, 0x00, 0x44, 0x7d, 0x40, 0x00) /* i */               \
+    glyph(0x6a, 0x20, 0x40, 0x44, 0x3d, 0x00) /* j */               \
+    glyph(0x6b, 0x7f, 0x10, 0x28, 0x44, 0x00) /* k */               \
+    glyph(0x6c, 0x00, 0x41, 0x7f, 0x40, 0x00) /* l */               \
+    glyph(0x6d, 0x7c, 0x04, 0x18, 0x04, 0x78) /* m */               \
+    glyph(0x6e, 0x7c, 0x08, 0x04, 0x04, 0x78) /* n */               \
+    glyph(0x6f, 0x38, 0x44, 0x44, 0x44, 0x38) /* o */               \
+    glyph(0x70, 0x7c, 0x14, 0x14, 0x14, 0x08) /* p */               \
+    glyph(0x71, 0x08, 0x14, 0x14, 0x18, 0x7c) /* q */               \
+    glyph(0x72, 0x7c, 0x08, 0x04, 0x04, 0x08) /* r */               \
+    glyph(0x73, 0x48, 0x54, 0x54, 0x54, 0x20) /* s */               \
+    glyph(0x74, 0x04, 0x3f, 0x44, 0x40, 0x20) /* t */               \
+    glyph(0x75, 0x3c, 0x40, 0x40, 0x20, 0x7c) /* u */               \
+    glyph(0x76, 0x1c, 0x20, 0x40, 0x20, 0x1c) /* v */               \
+    glyph(0x77, 0x3c, 0x40, 0x30, 0x40, 0x3c) /* w */               \
+    glyph(0x78, 0x44, 0x28, 0x10, 0x28, 0x44) /* x */               \
+    glyph(0x79, 0x0c, 0x50, 0x50, 0x50, 0x3c) /* y */               \
+    glyph(0x7a, 0x44, 0x64, 0x54, 0x4c, 0x44) /* z */               \
+    glyph(0x7b, 0x00, 0x08, 0x36, 0x41, 0x00) /* { */               \
+    glyph(0x7c, 0x00, 0x00, 0x7f, 0x00, 0x00) /* | */               \
+    glyph(0x7d, 0x00, 0x41, 0x36, 0x08, 0x00) /* } */               \
+    glyph(0x7e, 0x08, 0x04, 0x08, 0x10, 0x08) /* ~ */               \
+    glyph(0xb0, 0x00, 0x06, 0x09, 0x09, 0x06) /* ° */               \
+    glyph(0xc0, 0xf0, 0x29, 0x26, 0x28, 0xf0) /* À */               \
+    glyph(0xc1, 0xf0, 0x28, 0x26, 0x29, 0xf0) /* Á */               \
+    glyph(0xc2, 0xf0, 0x2a, 0x25, 0x2a, 0xf0) /* Â */               \
+    glyph(0xc3, 0xf0, 0x2a, 0x25, 0x2a, 0xf1) /* Ã */               \
+    glyph(0xc7, 0x3e, 0x41, 0xc1, 0x41, 0x22) /* Ç */               \
+    glyph(0xc9, 0xfc, 0xa4, 0xa6, 0xa5, 0x84) /* É */               \
+    glyph(0xca, 0xfc, 0xa6, 0xa5, 0xa6, 0x84) /* Ê */               \
+    glyph(0xcd, 0x00, 0x84, 0xfe, 0x85, 0x00) /* Í */               \
+    glyph(0xd3, 0x78, 0x84, 0x86, 0x85, 0x78) /* Ó */               \
+    glyph(0xd4, 0x78, 0x86, 0x85, 0x86, 0x78) /* Ô */               \
+    glyph(0xd5, 0x78, 0x86, 0x85, 0x86, 0x79) /* Õ */               \
+    glyph(0xda, 0x7c, 0x80, 0x82, 0x81, 0x7c) /* Ú */               \
+    glyph(0xdc, 0x7c, 0x81, 0x80, 0x81, 0x7c) /* Ü */               \
+    glyph(0xe0, 0x20, 0x55, 0x56, 0x54, 0x78) /* à */               \
+    glyph(0xe1, 0x20, 0x54, 0x56, 0x55, 0x78) /* á */               \
+    glyph(0xe2, 0x20, 0x56, 0x55, 0x56, 0x78) /* â */               \
+    glyph(0xe3, 0x20, 0x56, 0x55, 0x56, 0x79) /* ã */               \
+    glyph(0xe7, 0x38, 0x44, 0xc4, 0x44, 0x20) /* ç */               \
+    glyph(0xe9, 0x38, 0x54, 0x56, 0x55, 0x18) /* é */               \
+    glyph(0xea, 0x38, 0x56, 0x55, 0x56, 0x18) /* ê */               \
+    glyph(0xed, 0x00, 0x44, 0x7e, 0x41, 0x00) /* í */               \
+    glyph(0xf3, 0x38, 0x44, 0x46, 0x45, 0x38) /* ó */               \
+    glyph(0xf4, 0x38, 0x46, 0x45, 0x46, 0x38) /* ô */               \
+    glyph(0xf5, 0x38, 0x46, 0x45, 0x46, 0x39) /* õ */               \
+    glyph(0xfa, 0x3c, 0x40, 0x42, 0x21, 0x7c) /* ú */               \
+    glyph(0xfc, 0x3c, 0x41, 0x40, 0x21, 0x7c) /* ü */
+
+#ifndef __cplusplus
+#define ssd1306_font_entry(code, c0, c1, c2, c3, c4) [code] = { c0, c1, c2, c3, c4 },
+static const uint8_t ssd1306_font[256][ssd1306_glyph_width] = { ssd1306_font_glyphs(ssd1306_font_entry) };
+#endif
@@ -1,88 +1,1284 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
 #include "pico/stdlib.h"
 #include "pico/binary_info.h"
 #include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "ssd1306.h"
 #include "ssd1306_font.h"
-#include "ssd1306_i2c.h"
+
+// Displays registrados (para o tratador de DMA compartilhado e o rodízio do barramento)
+static ssd1306_t *ssd1306_instances[ssd1306_max_instances];
+static int ssd1306_instance_count = 0;
+static bool ssd1306_dma_handler_installed = false;
+
+// Display que está transmitindo via DMA em cada barramento e uso de cada barramento
+static ssd1306_t *volatile ssd1306_bus_owner[ssd1306_max_buses];
+static ssd1306_bus_stats_t ssd1306_bus_stats[ssd1306_max_buses];
+
+// Prazo do último fluxo de DMA de cada barramento: passado ele, com o DMA ou a FIFO ainda
+// ocupados, o barramento é dado como preso (um SDA preso não gera interrupção nenhuma)
+static uint32_t ssd1306_bus_deadline_us[ssd1306_max_buses];
+
+// Degraus do clock adaptativo do I2C (kHz), do mais rápido ao mais lento
+static const uint16_t ssd1306_i2c_clock_steps[] = {
+    ssd1306_i2c_clock_max, 800, 600, ssd1306_i2c_clock, 200, ssd1306_i2c_clock_min,
+};
+
+// Fim de transação nas palavras do DMA: o STOP do I2C. O SPI, com quadros de 8 bits, ignora os
+// bits acima do byte, então as mesmas palavras servem aos dois transportes
+#define ssd1306_dma_stop I2C_IC_DATA_CMD_STOP_BITS
+
+// Display usado pela API de funções livres (i2c1, ssd1306_i2c_address)
+static ssd1306_t ssd1306_default;
+
+// Sequência de inicialização pré-montada: um único fluxo de comandos (byte de controle 0x00).
+// Modo de endereçamento horizontal: o framebuffer é organizado página a página
+static const uint8_t ssd1306_init_sequence[] = {
+    ssd1306_control_command_stream,
+    ssd1306_set_display, ssd1306_set_memory_mode, 0x00,
+    ssd1306_set_display_start_line, ssd1306_set_segment_remap | 0x01,
+    ssd1306_set_mux_ratio, ssd1306_height - 1,
+    ssd1306_set_common_output_direction | 0x08, ssd1306_set_display_offset,
+    0x00, ssd1306_set_common_pin_configuration, 0x12,
+    ssd1306_set_display_clock_divide_ratio, 0x80, ssd1306_set_precharge,
+    0xF1, ssd1306_set_vcomh_deselect_level, 0x30, ssd1306_set_contrast,
+    0xFF, ssd1306_set_entire_on, ssd1306_set_normal_display,
+    ssd1306_set_charge_pump, 0x14, ssd1306_set_scroll | 0x00,
+    ssd1306_set_display | 0x01,
+};
+
+// Posições na sequência dos parâmetros que dependem da geometria
+#define ssd1306_init_mux_index 7
+#define ssd1306_init_com_pins_index 12
 
 // Calcular quanto do buffer será destinado à área de renderização
 void calculate_render_area_buffer_length(struct render_area *area) {
     area->buffer_length = (area->end_column - area->start_column + 1) * (area->end_page - area->start_page + 1);
 }
 
+// Esvazia as regiões: first > last em todas as páginas
+static void ssd1306_dirty_clear(ssd1306_dirty_t *dirty) {
+    memset(dirty->first, 0xFF, sizeof(dirty->first));
+    memset(dirty->last, 0, sizeof(dirty->last));
+}
+
+// Estende as regiões das páginas page_0..page_1 até cobrirem as colunas x_0..x_1
+static void ssd1306_dirty_add(ssd1306_dirty_t *dirty, int x_0, int x_1, int page_0, int page_1) {
+    for (int page = page_0; page <= page_1; page++) {
+        if (x_0 < dirty->first[page]) dirty->first[page] = x_0;
+        if (x_1 > dirty->last[page]) dirty->last[page] = x_1;
+    }
+}
+
+// Une a "dirty" as regiões de "other", página a página
+static void ssd1306_dirty_merge(ssd1306_dirty_t *dirty, const ssd1306_dirty_t *other) {
+    for (int page = 0; page < ssd1306_n_pages; page++) {
+        if (other->first[page] < dirty->first[page]) dirty->first[page] = other->first[page];
+        if (other->last[page] > dirty->last[page]) dirty->last[page] = other->last[page];
+    }
+}
+
+// Primeiro degrau do clock do I2C que não passa de clock_khz
+static uint8_t ssd1306_i2c_step(uint32_t clock_khz) {
+    uint8_t step = 0;
+    while (step + 1 < count_of(ssd1306_i2c_clock_steps) && ssd1306_i2c_clock_steps[step] > clock_khz) {
+        step++;
+    }
+    return step;
+}
+
+// Muda o clock do I2C para um degrau; vale para todos os displays do mesmo barramento
+static void ssd1306_i2c_set_clock(ssd1306_t *ssd, uint8_t step) {
+    uint32_t clock_khz = i2c_set_baudrate(ssd->i2c_port, ssd1306_i2c_clock_steps[step] * 1000) / 1000;
+    for (int i = 0; i < ssd1306_instance_count; i++) {
+        ssd1306_t *other = ssd1306_instances[i];
+        if (other->bus == ssd->bus) {
+            other->clock_step = step;
+            other->clock_khz = clock_khz;
+            other->error_streak = 0;
+        }
+    }
+}
+
+// Libera o barramento preso por um escravo que segura o SDA no meio de um byte: com o bloco
+// desligado, pulsos de SCL por GPIO em dreno aberto (o pino só é puxado para baixo ou solto)
+// até o SDA subir, e um STOP; depois o bloco volta no clock atual. Sem os pinos informados
+// (ssd1306_set_i2c_pins), só reinicializa o bloco
+static void ssd1306_i2c_bus_clear(ssd1306_t *ssd) {
+    ssd1306_bus_stats[ssd->bus].recoveries++;
+    i2c_deinit(ssd->i2c_port);
+
+    if (ssd->sda_pin != ssd1306_no_pin) {
+        const uint sda = ssd->sda_pin, scl = ssd->scl_pin;
+        gpio_put(sda, 0);
+        gpio_put(scl, 0);
+        gpio_set_dir(sda, GPIO_IN);
+        gpio_set_dir(scl, GPIO_IN);
+        gpio_set_function(sda, GPIO_FUNC_SIO);
+        gpio_set_function(scl, GPIO_FUNC_SIO);
+
+        for (int i = 0; i < ssd1306_bus_clear_pulses && !gpio_get(sda); i++) {
+            gpio_set_dir(scl, GPIO_OUT);
+            busy_wait_us(ssd1306_bus_clear_half_period_us);
+            gpio_set_dir(scl, GPIO_IN);
+            busy_wait_us(ssd1306_bus_clear_half_period_us);
+        }
+
+        // STOP: com o SCL baixo o SDA desce; o SCL sobe e, por último, o SDA
+        gpio_set_dir(scl, GPIO_OUT);
+        gpio_set_dir(sda, GPIO_OUT);
+        busy_wait_us(ssd1306_bus_clear_half_period_us);
+        gpio_set_dir(scl, GPIO_IN);
+        busy_wait_us(ssd1306_bus_clear_half_period_us);
+        gpio_set_dir(sda, GPIO_IN);
+        busy_wait_us(ssd1306_bus_clear_half_period_us);
+
+        gpio_set_function(sda, GPIO_FUNC_I2C);
+        gpio_set_function(scl, GPIO_FUNC_I2C);
+    }
+    i2c_init(ssd->i2c_port, ssd->clock_khz * 1000);
+    i2c_get_hw(ssd->i2c_port)->intr_mask = 0; // O reset do bloco volta a máscara ao padrão
+}
+
+// Transporte I2C: o byte de controle segue na própria transação, e o fluxo do DMA inteiro vai
+// numa só transferência (o bit de STOP de cada palavra encerra as transações). Um prazo
+// esgotado indica o barramento preso, liberado na hora
+static bool ssd1306_i2c_write(ssd1306_t *ssd, const uint8_t *buffer, size_t length) {
+    const ssd1306_bus_stats_t transaction = { 1, length };
+    uint timeout_us = 2 * ssd1306_bus_time_us(&transaction, ssd->clock_khz) + ssd1306_write_timeout_margin_us;
+    int result = i2c_write_timeout_us(ssd->i2c_port, ssd->address, buffer, length, false, timeout_us);
+
+    if (result == PICO_ERROR_TIMEOUT) {
+        ssd1306_bus_stats[ssd->bus].timeouts++;
+        ssd1306_i2c_bus_clear(ssd);
+    } else if (result != (int)length) {
+        ssd1306_bus_stats[ssd->bus].errors++;
+    }
+    return result == (int)length;
+}
+
+static void ssd1306_dma_advance(ssd1306_t *ssd);
+static bool ssd1306_i2c_irq_installed[2];
+
+// Interrupção do I2C (STOP ou aborto), armada por ssd1306_i2c_dma_next enquanto a FIFO
+// esvazia: retoma o fim do envio do display dono do barramento, que a rearma se ainda houver
+// bytes (só o dono mexe na máscara, compartilhada pelos displays do bloco)
+static void ssd1306_i2c_irq_handler() {
+    for (int i = 0; i < ssd1306_instance_count; i++) {
+        ssd1306_t *ssd = ssd1306_instances[i];
+        if (ssd->transport == &ssd1306_transport_i2c && ssd->dma_busy && ssd1306_bus_owner[ssd->bus] == ssd &&
+            !dma_channel_is_busy(ssd->dma_channel)) {
+            i2c_get_hw(ssd->i2c_port)->intr_mask = 0;
+            ssd1306_dma_advance(ssd);
+        }
+    }
+}
+
+// Alvo do DMA e, uma vez por bloco, a interrupção que avisa o fim da FIFO
+static volatile void *ssd1306_i2c_dma_target(ssd1306_t *ssd, uint *dreq) {
+    const uint index = i2c_get_index(ssd->i2c_port);
+    i2c_get_hw(ssd->i2c_port)->intr_mask = 0;
+    if (!ssd1306_i2c_irq_installed[index]) {
+        irq_add_shared_handler(I2C0_IRQ + index, ssd1306_i2c_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(I2C0_IRQ + index, true);
+        ssd1306_i2c_irq_installed[index] = true;
+    }
+
+    *dreq = i2c_get_dreq(ssd->i2c_port, true);
+    return &i2c_get_hw(ssd->i2c_port)->data_cmd;
+}
+
+// Só com o barramento ocioso: desligar o bloco para trocar o endereço descarta a FIFO
+static void ssd1306_i2c_dma_start(ssd1306_t *ssd) {
+    i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+    hw->enable = 0;
+    hw->tar = ssd->address;
+    hw->enable = 1;
+    dma_channel_transfer_from_buffer_now(ssd->dma_channel, ssd->dma_words, ssd->dma_length);
+}
+
+// NAK ou perda de arbitragem: a FIFO foi descartada e o DMA ficaria parado para sempre
+static bool ssd1306_i2c_error(ssd1306_t *ssd) {
+    return i2c_get_hw(ssd->i2c_port)->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+}
+
+static void ssd1306_i2c_recover(ssd1306_t *ssd) {
+    i2c_get_hw(ssd->i2c_port)->intr_mask = 0; // Envio abortado no meio da espera pela FIFO
+    (void)i2c_get_hw(ssd->i2c_port)->clr_tx_abrt;
+}
+
+static bool ssd1306_i2c_active(ssd1306_t *ssd) {
+    i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+    return !(hw->status & I2C_IC_STATUS_TFE_BITS) || (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS);
+}
+
+// O DMA termina quando a última palavra entra na FIFO: até ssd1306_i2c_fifo_depth bytes e o
+// STOP ainda vão ao barramento (~400 us a 400 kHz). Enquanto saem, o fim do envio fica para a
+// interrupção de STOP ou de aborto do I2C, e só então o barramento é solto e o bloco pode ser
+// desligado. FIFO vazia, NAK ou prazo vencido encerram o envio; quem chama confere qual
+static bool ssd1306_i2c_dma_next(ssd1306_t *ssd) {
+    i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+    (void)hw->clr_stop_det;
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+
+    // Conferido depois de armar: um STOP no meio fica registrado e dispara a interrupção
+    if (!ssd1306_i2c_active(ssd) || ssd1306_i2c_error(ssd) ||
+        (int32_t)(time_us_32() - ssd1306_bus_deadline_us[ssd->bus]) > 0) {
+        hw->intr_mask = 0;
+        return false;
+    }
+    return true;
+}
+
+const ssd1306_transport_t ssd1306_transport_i2c = {
+    "I2C", ssd1306_i2c_write, ssd1306_i2c_dma_target, ssd1306_i2c_dma_start, ssd1306_i2c_dma_next,
+    ssd1306_i2c_error, ssd1306_i2c_recover, ssd1306_i2c_active, ssd1306_bus_time_us,
+};
+
+// Transporte SPI de 4 fios: o byte de controle não vai ao barramento, vira o nível do D/C#
+// (alto para dados), e o CS# fica baixo durante a transação
+static void ssd1306_spi_select(ssd1306_t *ssd, uint8_t control) {
+    gpio_put(ssd->dc_pin, control & ssd1306_control_data);
+    gpio_put(ssd->cs_pin, 0);
+}
+
+// Sem confirmação no SPI: a escrita sempre "chega"
+static bool ssd1306_spi_write(ssd1306_t *ssd, const uint8_t *buffer, size_t length) {
+    ssd1306_spi_select(ssd, buffer[0]);
+    spi_write_blocking(ssd->spi_port, buffer + 1, length - 1); // Retorna com o último bit já enviado
+    gpio_put(ssd->cs_pin, 1);
+    return true;
+}
+
+static volatile void *ssd1306_spi_dma_target(ssd1306_t *ssd, uint *dreq) {
+    *dreq = spi_get_dreq(ssd->spi_port, true);
+    return &spi_get_hw(ssd->spi_port)->dr;
+}
+
+// Dispara a próxima transação do fluxo, sem o byte de controle; o D/C# muda entre transações,
+// então cada uma é uma transferência. Retorna false (e solta o CS#) no fim do fluxo
+static bool ssd1306_spi_dma_transaction(ssd1306_t *ssd) {
+    const int first = ssd->dma_position;
+    if (first >= ssd->dma_length) {
+        gpio_put(ssd->cs_pin, 1);
+        return false;
+    }
+
+    int last = first + 1;
+    while (!(ssd->dma_words[last] & ssd1306_dma_stop)) {
+        last++;
+    }
+    ssd->dma_position = last + 1;
+    ssd1306_spi_select(ssd, (uint8_t)ssd->dma_words[first]);
+    dma_channel_transfer_from_buffer_now(ssd->dma_channel, &ssd->dma_words[first + 1], last - first);
+    return true;
+}
+
+static void ssd1306_spi_dma_start(ssd1306_t *ssd) {
+    ssd->dma_position = 0;
+    ssd1306_spi_dma_transaction(ssd);
+}
+
+// O DMA termina com até 8 bytes ainda na FIFO: o D/C# só muda depois que o último sai do
+// registrador de deslocamento (~7 us a 9 MHz, dentro da interrupção)
+static bool ssd1306_spi_dma_next(ssd1306_t *ssd) {
+    while (spi_is_busy(ssd->spi_port)) {
+        tight_loop_contents();
+    }
+    return ssd1306_spi_dma_transaction(ssd);
+}
+
+static bool ssd1306_spi_error(ssd1306_t *ssd) {
+    return false;
+}
+
+static void ssd1306_spi_recover(ssd1306_t *ssd) {
+}
+
+static bool ssd1306_spi_active(ssd1306_t *ssd) {
+    return spi_is_busy(ssd->spi_port);
+}
+
+// Tempo de barramento no SPI: 8 bits por byte, descontado o byte de controle de cada transação
+static uint32_t ssd1306_spi_time_us(const ssd1306_bus_stats_t *stats, uint32_t clock_khz) {
+    uint64_t bits = ((uint64_t)stats->bytes - stats->transactions) * 8;
+    return (uint32_t)(bits * 1000 / clock_khz);
+}
+
+const ssd1306_transport_t ssd1306_transport_spi = {
+    "SPI", ssd1306_spi_write, ssd1306_spi_dma_target, ssd1306_spi_dma_start, ssd1306_spi_dma_next,
+    ssd1306_spi_error, ssd1306_spi_recover, ssd1306_spi_active, ssd1306_spi_time_us,
+};
+
+// Transporte simulado: cada transação é interpretada sobre a cópia da memória do display
+static uint8_t ssd1306_mock_parameters(uint8_t command) {
+    switch (command) {
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+            return 1;
+        case 0x21: case 0x22: case 0xA3:
+            return 2;
+        case 0x29: case 0x2A:
+            return 5;
+        case 0x26: case 0x27:
+            return 6;
+        default:
+            return 0;
+    }
+}
+
+static void ssd1306_mock_command(ssd1306_mock_t *mock, uint8_t byte) {
+    if (mock->command_length == 0) {
+        mock->command_expected = ssd1306_mock_parameters(byte);
+    }
+    mock->command[mock->command_length++] = byte;
+    if (mock->command_length <= mock->command_expected) {
+        return;
+    }
+
+    mock->command_length = 0;
+    if (mock->command[0] == ssd1306_set_column_address) {
+        mock->start_column = mock->column = mock->command[1] & 127;
+        mock->end_column = mock->command[2] & 127;
+    } else if (mock->command[0] == ssd1306_set_page_address) {
+        mock->start_page = mock->page = mock->command[1] & 7;
+        mock->end_page = mock->command[2] & 7;
+    }
+}
+
+// Endereçamento horizontal: coluna a coluna dentro da janela, passando à página seguinte
+static void ssd1306_mock_data(ssd1306_mock_t *mock, uint8_t byte) {
+    mock->gddram[mock->page * ssd1306_width + mock->column] = byte;
+    if (mock->column++ >= mock->end_column) {
+        mock->column = mock->start_column;
+        mock->page = mock->page >= mock->end_page ? mock->start_page : mock->page + 1;
+    }
+}
+
+static bool ssd1306_mock_write(ssd1306_t *ssd, const uint8_t *buffer, size_t length) {
+    ssd1306_mock_t *mock = ssd->mock;
+    const bool data = buffer[0] & ssd1306_control_data;
+
+    mock->transactions++;
+    for (size_t i = 1; i < length; i++) {
+        if (data) {
+            ssd1306_mock_data(mock, buffer[i]);
+        } else {
+            ssd1306_mock_command(mock, buffer[i]);
+        }
+    }
+    if (data) {
+        mock->data_bytes += length - 1;
+    } else {
+        mock->command_bytes += length - 1;
+    }
+    return true;
+}
+
+static bool ssd1306_mock_never(ssd1306_t *ssd) {
+    return false;
+}
+
+static void ssd1306_mock_recover(ssd1306_t *ssd) {
+}
+
+static uint32_t ssd1306_mock_time_us(const ssd1306_bus_stats_t *stats, uint32_t clock_khz) {
+    return 0;
+}
+
+const ssd1306_transport_t ssd1306_transport_mock = {
+    "simulado", ssd1306_mock_write, NULL, NULL, NULL,
+    ssd1306_mock_never, ssd1306_mock_recover, ssd1306_mock_never, ssd1306_mock_time_us,
+};
+
+// Escrita bloqueante pelo transporte do display, com contabilização de transações e bytes;
+// retorna se o display recebeu a transação
+static bool ssd1306_transfer(ssd1306_t *ssd, const uint8_t *buffer, size_t length) {
+    ssd1306_bus_stats[ssd->bus].transactions++;
+    ssd1306_bus_stats[ssd->bus].bytes += length;
+    return ssd->transport->write(ssd, buffer, length);
+}
+
+// Resultado de uma transação em operação: ssd1306_error_limit falhas seguidas derrubam o clock
+// do I2C um degrau (a fiação não sustenta o clock atual)
+static void ssd1306_bus_result(ssd1306_t *ssd, bool ok) {
+    if (ok) {
+        ssd->error_streak = 0;
+        return;
+    }
+    if (++ssd->error_streak < ssd1306_error_limit) {
+        return;
+    }
+
+    ssd->error_streak = 0;
+    if (ssd->transport == &ssd1306_transport_i2c && ssd->clock_step + 1 < count_of(ssd1306_i2c_clock_steps)) {
+        ssd1306_i2c_set_clock(ssd, ssd->clock_step + 1);
+        ssd1306_bus_stats[ssd->bus].clock_drops++;
+    }
+}
+
+static bool ssd1306_write(ssd1306_t *ssd, const uint8_t *buffer, size_t length) {
+    bool ok = ssd1306_transfer(ssd, buffer, length);
+    ssd1306_bus_result(ssd, ok);
+    return ok;
+}
+
+// Envia dados do framebuffer sem cópia: o byte anterior a "data" faz temporariamente o papel
+// de byte de controle (o framebuffer reserva a posição 0 para o primeiro byte da tela)
+static void ssd1306_write_data(ssd1306_t *ssd, uint8_t *data, size_t length) {
+    uint8_t saved = data[-1];
+    data[-1] = ssd1306_control_data;
+    ssd1306_write(ssd, data - 1, length + 1);
+    data[-1] = saved;
+}
+
+// Inicia um fluxo de comandos: o byte de controle 0x00 (Co = 0) indica que todos os bytes
+// seguintes da transação são comandos
+void ssd1306_command_stream_begin(ssd1306_command_stream_t *stream) {
+    stream->buffer[0] = ssd1306_control_command_stream;
+    stream->length = 1;
+}
+
+// Acrescenta um comando (ou parâmetro) ao fluxo
+void ssd1306_command_stream_push(ssd1306_command_stream_t *stream, uint8_t command) {
+    assert(stream->length < sizeof(stream->buffer));
+    stream->buffer[stream->length++] = command;
+}
+
+// Envia o fluxo inteiro numa única transação i2c
+void ssd1306_command_stream_send(ssd1306_t *ssd, ssd1306_command_stream_t *stream) {
+    ssd1306_flush_wait(ssd);
+    ssd1306_write(ssd, stream->buffer, stream->length);
+}
+
+// Monta o fluxo de endereçamento da janela de escrita (colunas e páginas)
+static void ssd1306_address_stream(ssd1306_command_stream_t *stream,
+                                   uint8_t start_column, uint8_t end_column, uint8_t start_page, uint8_t end_page) {
+    ssd1306_command_stream_begin(stream);
+    ssd1306_command_stream_push(stream, ssd1306_set_column_address);
+    ssd1306_command_stream_push(stream, start_column);
+    ssd1306_command_stream_push(stream, end_column);
+    ssd1306_command_stream_push(stream, ssd1306_set_page_address);
+    ssd1306_command_stream_push(stream, start_page);
+    ssd1306_command_stream_push(stream, end_page);
+}
+
+// Comando de configuração com base na estrutura ssd1306_t
+void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
+    ssd1306_flush_wait(ssd);
+    ssd->port_buffer[1] = command;
+    ssd1306_write(ssd, ssd->port_buffer, 2);
+}
+
+// Inicializa o handle do display sobre um transporte: nenhuma alocação, todo o armazenamento
+// está na estrutura
+static void ssd1306_init_transport(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc,
+                                   const ssd1306_transport_t *transport, uint8_t bus, uint32_t clock_khz) {
+    assert(width <= ssd1306_width && height <= ssd1306_height && height % 8 == 0);
+
+    ssd->width = width;
+    ssd->height = height;
+    ssd->pages = height / 8U;
+    ssd->transport = transport;
+    ssd->bus = bus;
+    ssd->clock_khz = clock_khz;
+    ssd->sda_pin = ssd1306_no_pin;
+    ssd->scl_pin = ssd1306_no_pin;
+    ssd->error_streak = 0;
+    ssd->external_vcc = external_vcc;
+    ssd->ram_buffer = ssd->frame;
+    ssd->bufsize = ssd->pages * ssd1306_width + 1;
+    memset(ssd->frame, 0, sizeof(ssd->frame));
+    ssd->ram_buffer[0] = ssd1306_control_data;
+    ssd->port_buffer[0] = ssd1306_control_command;
+
+    ssd->shadow_valid = false;
+    memset(&ssd->diff_stats, 0, sizeof(ssd->diff_stats));
+    ssd1306_dirty_clear(&ssd->dirty);
+    ssd->dirty_marked = false;
+    memset(&ssd->scroll, 0, sizeof(ssd->scroll));
+    ssd->dma_channel = -1;
+    ssd->dma_busy = false;
+    ssd->pending = false;
+    ssd->flush_callback = NULL;
+
+    for (int i = 0; i < ssd1306_instance_count; i++) {
+        if (ssd1306_instances[i] == ssd) {
+            return;
+        }
+    }
+    assert(ssd1306_instance_count < ssd1306_max_instances);
+    ssd1306_instances[ssd1306_instance_count++] = ssd;
+}
+
+// Display no I2C ("i2c" já inicializado, a ssd1306_i2c_clock kHz)
+void ssd1306_init_bm(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
+    ssd->address = address;
+    ssd->i2c_port = i2c;
+    ssd->clock_step = ssd1306_i2c_step(ssd1306_i2c_clock);
+    ssd1306_init_transport(ssd, width, height, external_vcc, &ssd1306_transport_i2c, i2c_get_index(i2c), ssd1306_i2c_clock);
+}
+
+// Pinos do I2C do display, para a liberação do barramento preso por GPIO
+void ssd1306_set_i2c_pins(ssd1306_t *ssd, uint sda_pin, uint scl_pin) {
+    ssd->sda_pin = sda_pin;
+    ssd->scl_pin = scl_pin;
+}
+
+// Sonda o maior clock do I2C que a fiação do display sustenta: do Fast-mode Plus para baixo,
+// fica no primeiro degrau em que ssd1306_probe_writes fluxos de NOPs seguidos são confirmados.
+// Sem nenhum degrau confiável (display ausente), volta a ssd1306_i2c_clock. Nos demais
+// transportes não há o que sondar. Retorna o clock em kHz
+uint32_t ssd1306_probe_clock(ssd1306_t *ssd) {
+    if (ssd->transport != &ssd1306_transport_i2c) {
+        return ssd->clock_khz;
+    }
+
+    uint8_t nops[ssd1306_command_stream_max + 1];
+    memset(nops, ssd1306_nop, sizeof(nops));
+    nops[0] = ssd1306_control_command_stream;
+
+    ssd1306_flush_wait(ssd);
+    for (uint8_t step = 0; step < count_of(ssd1306_i2c_clock_steps); step++) {
+        ssd1306_i2c_set_clock(ssd, step);
+        int confirmed = 0;
+        while (confirmed < ssd1306_probe_writes && ssd1306_transfer(ssd, nops, sizeof(nops))) {
+            confirmed++;
+        }
+        if (confirmed == ssd1306_probe_writes) {
+            return ssd->clock_khz;
+        }
+    }
+
+    ssd1306_i2c_set_clock(ssd, ssd1306_i2c_step(ssd1306_i2c_clock));
+    return ssd->clock_khz;
+}
+
+// Display no SPI de 4 fios: "spi" já inicializado (modo 0, 8 bits, até ssd1306_spi_clock) com
+// SCK e MOSI na função SPI; D/C# e CS# são GPIO controlados pelo driver, e o RES# fica com o
+// chamador
+void ssd1306_init_spi(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, spi_inst_t *spi, uint dc_pin, uint cs_pin) {
+    ssd->spi_port = spi;
+    ssd->dc_pin = dc_pin;
+    ssd->cs_pin = cs_pin;
+    gpio_init(dc_pin);
+    gpio_set_dir(dc_pin, GPIO_OUT);
+    gpio_init(cs_pin);
+    gpio_put(cs_pin, 1);
+    gpio_set_dir(cs_pin, GPIO_OUT);
+    ssd1306_init_transport(ssd, width, height, external_vcc, &ssd1306_transport_spi,
+        ssd1306_bus_spi0 + spi_get_index(spi), spi_get_baudrate(spi) / 1000);
+}
+
+// Display sobre o transporte simulado: as transações só atualizam "mock"
+void ssd1306_init_mock(ssd1306_t *ssd, uint8_t width, uint8_t height, ssd1306_mock_t *mock) {
+    memset(mock, 0, sizeof(*mock));
+    mock->end_column = ssd1306_width - 1;
+    mock->end_page = ssd1306_n_pages - 1;
+    ssd->mock = mock;
+    ssd1306_init_transport(ssd, width, height, false, &ssd1306_transport_mock, ssd1306_bus_mock, 0);
+}
+
+// Envia a sequência de inicialização pré-montada numa única transação, ajustada à geometria;
+// retorna false se o display não respondeu (ausente ou barramento preso), para nova tentativa
+bool ssd1306_config(ssd1306_t *ssd) {
+    uint8_t commands[sizeof(ssd1306_init_sequence)];
+    memcpy(commands, ssd1306_init_sequence, sizeof(commands));
+    commands[ssd1306_init_mux_index] = ssd->height - 1;
+    commands[ssd1306_init_com_pins_index] = (ssd->width == 128 && ssd->height == 64) ? 0x12 : 0x02;
+
+    ssd1306_flush_wait(ssd);
+    bool ok = ssd1306_write(ssd, commands, sizeof(commands));
+    ssd1306_invalidate_shadow(ssd); // Conteúdo da memória do display é desconhecido após a inicialização
+    memset(&ssd->scroll, 0, sizeof(ssd->scroll)); // A sequência desliga o scroll
+    return ok;
+}
+
+// Força o próximo quadro a ser enviado por completo
+void ssd1306_invalidate_shadow(ssd1306_t *ssd) {
+    ssd->shadow_valid = false;
+}
+
+// Marca o retângulo (x, y, w, h), arredondado para páginas inteiras, como alterado no
+// ram_buffer. Havendo marcas, o próximo envio compara com a sombra só as regiões marcadas, então
+// quem marca precisa marcar tudo o que mudou; sem nenhuma marca, compara o quadro inteiro
+void ssd1306_mark_dirty(ssd1306_t *ssd, int x, int y, int w, int h) {
+    if (y + h <= 0) {
+        return; // Inteiro acima da tela (a divisão abaixo truncaria para a página 0)
+    }
+    int x_0 = x < 0 ? 0 : x;
+    int x_1 = x + w - 1 >= ssd->width ? ssd->width - 1 : x + w - 1;
+    int page_0 = y < 0 ? 0 : y / 8;
+    int page_1 = y + h - 1 >= ssd->height ? ssd->pages - 1 : (y + h - 1) / 8;
+    if (x_0 > x_1 || page_0 > page_1) {
+        return;
+    }
+
+    ssd1306_dirty_add(&ssd->dirty, x_0, x_1, page_0, page_1);
+    ssd->dirty_marked = true;
+}
+
+// Copia os contadores da renderização por diferença
+void ssd1306_get_diff_stats(ssd1306_t *ssd, ssd1306_diff_stats_t *stats) {
+    *stats = ssd->diff_stats;
+}
+
+// Zera os contadores da renderização por diferença
+void ssd1306_reset_diff_stats(ssd1306_t *ssd) {
+    memset(&ssd->diff_stats, 0, sizeof(ssd->diff_stats));
+}
+
+// Copia os contadores de uso de um barramento (transações e bytes após o endereço)
+void ssd1306_get_bus_stats(i2c_inst_t *i2c, ssd1306_bus_stats_t *stats) {
+    *stats = ssd1306_bus_stats[i2c_get_index(i2c)];
+}
+
+// Tempo de barramento estimado em microssegundos: cada transação custa START, byte de endereço
+// (9 bits com ACK) e STOP; cada byte, 9 bits
+uint32_t ssd1306_bus_time_us(const ssd1306_bus_stats_t *stats, uint32_t clock_khz) {
+    uint64_t bits = (uint64_t)stats->transactions * 11 + (uint64_t)stats->bytes * 9;
+    return (uint32_t)(bits * 1000 / clock_khz);
+}
+
+// Copia os contadores do barramento do display, qualquer que seja o transporte
+void ssd1306_get_transport_stats(const ssd1306_t *ssd, ssd1306_bus_stats_t *stats) {
+    *stats = ssd1306_bus_stats[ssd->bus];
+}
+
+// Tempo de barramento estimado para os contadores, no transporte e no clock do display
+uint32_t ssd1306_transport_time_us(const ssd1306_t *ssd, const ssd1306_bus_stats_t *stats) {
+    return ssd->transport->time_us(stats, ssd->clock_khz);
+}
+
+// Monta o fluxo que desliga o scroll ou que o desliga, configura a faixa e liga de novo
+// (o controlador só aceita a configuração com o scroll desligado)
+static void ssd1306_scroll_stream(const ssd1306_t *ssd, ssd1306_command_stream_t *stream, bool run) {
+    ssd1306_command_stream_begin(stream);
+    ssd1306_command_stream_push(stream, ssd1306_set_scroll);
+    if (run) {
+        ssd1306_command_stream_push(stream, ssd->scroll.direction);
+        ssd1306_command_stream_push(stream, 0x00);
+        ssd1306_command_stream_push(stream, ssd->scroll.start_page);
+        ssd1306_command_stream_push(stream, ssd->scroll.interval);
+        ssd1306_command_stream_push(stream, ssd->scroll.end_page);
+        ssd1306_command_stream_push(stream, 0x00);
+        ssd1306_command_stream_push(stream, 0xFF);
+        ssd1306_command_stream_push(stream, ssd1306_set_scroll | 0x01);
+    }
+}
+
+// Envia um fluxo de comandos no meio de um envio bloqueante
+static void ssd1306_send_commands(ssd1306_t *ssd, const ssd1306_command_stream_t *stream) {
+    ssd1306_write(ssd, stream->buffer, stream->length);
+    ssd->diff_stats.command_bytes_sent += stream->length;
+}
+
+// Desliga o scroll antes de uma escrita na memória do display; retorna quantos fluxos emitiu
+static int ssd1306_scroll_halt(ssd1306_t *ssd, void (*emit_commands)(ssd1306_t *ssd, const ssd1306_command_stream_t *stream)) {
+    if (!ssd->scroll.active) {
+        return 0;
+    }
+
+    ssd1306_command_stream_t stream;
+    ssd1306_scroll_stream(ssd, &stream, false);
+    emit_commands(ssd, &stream);
+    ssd->scroll.active = false;
+    return 1;
+}
+
+// Leva o scroll do display ao estado pedido depois dos dados: liga (ou reconfigura) a faixa,
+// ou a desliga se foi pausada ou parada; retorna quantos fluxos de comandos emitiu
+static int ssd1306_scroll_update(ssd1306_t *ssd, void (*emit_commands)(ssd1306_t *ssd, const ssd1306_command_stream_t *stream)) {
+    ssd1306_scroll_t *scroll = &ssd->scroll;
+    const bool run = scroll->enabled && scroll->running;
+    if (run == scroll->active && !(run && scroll->reconfigure)) {
+        return 0;
+    }
+
+    ssd1306_command_stream_t stream;
+    ssd1306_scroll_stream(ssd, &stream, run);
+    emit_commands(ssd, &stream);
+    scroll->active = run;
+    scroll->reconfigure = false;
+    scroll->shifted = scroll->shifted || run;
+    return 1;
+}
+
+// Envia o framebuffer inteiro numa única escrita, direto do ram_buffer
+void ssd1306_send_data(ssd1306_t *ssd) {
+    ssd1306_dirty_clear(&ssd->dirty);
+    ssd->dirty_marked = false;
+    ssd1306_flush_wait(ssd);
+    ssd1306_scroll_halt(ssd, ssd1306_send_commands);
+
+    ssd1306_command_stream_t stream;
+    ssd1306_address_stream(&stream, 0, ssd->width - 1, 0, ssd->pages - 1);
+    ssd1306_command_stream_send(ssd, &stream);
+
+    if (ssd->width == ssd1306_width) {
+        ssd1306_write(ssd, ssd->ram_buffer, ssd->bufsize);
+    } else {
+        for (int page = 0; page < ssd->pages; page++) {
+            ssd1306_write_data(ssd, ssd->ram_buffer + 1 + page * ssd1306_width, ssd->width);
+        }
+    }
+
+    memcpy(ssd->shadow, ssd->ram_buffer + 1, ssd->bufsize - 1);
+    ssd->shadow_valid = true;
+    ssd->scroll.shifted = false;
+    ssd1306_scroll_update(ssd, ssd1306_send_commands); // A faixa volta a rolar do início
+}
+
+// Envia um retângulo de uma única página com os comandos de endereçamento de coluna/página
+static void ssd1306_send_span(ssd1306_t *ssd, uint8_t *data, uint8_t page, uint8_t start_column, uint8_t end_column) {
+    ssd1306_command_stream_t stream;
+    ssd1306_address_stream(&stream, start_column, end_column, page, page);
+
+    ssd1306_command_stream_send(ssd, &stream);
+    ssd1306_write_data(ssd, data, end_column - start_column + 1);
+
+    ssd->diff_stats.areas_sent++;
+    ssd->diff_stats.command_bytes_sent += stream.length;
+}
+
+// Percorre as regiões página a página e entrega a "emit" cada faixa de colunas de "frame" que
+// difere da cópia sombra, atualizando a sombra e os contadores; retorna quantas faixas houve
+static int ssd1306_diff(ssd1306_t *ssd, uint8_t *frame, const ssd1306_dirty_t *region,
+                        void (*emit)(ssd1306_t *ssd, uint8_t *data, uint8_t page, uint8_t start_column, uint8_t end_column)) {
+    int compared = 0;
+    int sent = 0;
+    int spans = 0;
+    bool full = true;
+
+    for (int page = 0; page < ssd->pages; page++) {
+        const int start_column = region->first[page];
+        const int end_column = region->last[page];
+        full = full && start_column == 0 && end_column == ssd->width - 1;
+        if (start_column > end_column) {
+            continue;
+        }
+
+        const int area_width = end_column - start_column + 1;
+        uint8_t *row = frame + page * ssd1306_width + start_column;
+        uint8_t *shadow = ssd->shadow + page * ssd1306_width + start_column;
+        int column = 0;
+        compared += area_width;
+
+        while (column < area_width) {
+            if (ssd->shadow_valid && row[column] == shadow[column]) {
+                column++;
+                continue;
+            }
+
+            // Estende a faixa enquanto as diferenças estiverem próximas o bastante
+            int first = column;
+            int last = column;
+            while (++column < area_width && column - last <= ssd1306_diff_merge_gap) {
+                if (!ssd->shadow_valid || row[column] != shadow[column]) {
+                    last = column;
+                }
+            }
+
+            emit(ssd, row + first, page, start_column + first, start_column + last);
+            memcpy(shadow + first, row + first, last - first + 1);
+            sent += last - first + 1;
+            spans++;
+            column = last + 1;
+        }
+    }
+
+    ssd->shadow_valid = ssd->shadow_valid || full;
+
+    ssd->diff_stats.frames++;
+    ssd->diff_stats.data_bytes_sent += sent;
+    ssd->diff_stats.data_bytes_skipped += compared - sent;
+    return spans;
+}
+
+// Indica se algum byte de "frame" nas regiões difere da sombra (sem sombra, sempre)
+static bool ssd1306_region_differs(const ssd1306_t *ssd, const uint8_t *frame, const ssd1306_dirty_t *region) {
+    for (int page = 0; page < ssd->pages; page++) {
+        const int offset = page * ssd1306_width + region->first[page];
+        if (region->first[page] <= region->last[page] &&
+            (!ssd->shadow_valid || memcmp(frame + offset, ssd->shadow + offset, region->last[page] - region->first[page] + 1))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ssd1306_diff com o scroll por hardware. Rolando, a memória não pode ser escrita: havendo
+// diferença, o scroll é desligado antes dos dados. A faixa deslocada (rolando, pausada ou
+// parada) não pode ser corrigida aos pedaços, então é reescrita inteira quando muda, quando o
+// scroll parou ou quando outra escrita desligou o scroll; pausada e sem mudança, fica como
+// está. Por fim o scroll vai ao estado pedido. Retorna quantas faixas e fluxos de comandos houve
+static int ssd1306_diff_scroll(ssd1306_t *ssd, uint8_t *frame, const ssd1306_dirty_t *region,
+                               void (*emit)(ssd1306_t *ssd, uint8_t *data, uint8_t page, uint8_t start_column, uint8_t end_column),
+                               void (*emit_commands)(ssd1306_t *ssd, const ssd1306_command_stream_t *stream)) {
+    ssd1306_scroll_t *scroll = &ssd->scroll;
+    int sent;
+
+    if (!scroll->shifted) {
+        sent = ssd1306_diff(ssd, frame, region, emit); // Sem deslocamento o scroll não está ativo
+        return sent + ssd1306_scroll_update(ssd, emit_commands);
+    }
+
+    ssd1306_dirty_t outside = *region, band;
+    ssd1306_dirty_clear(&band);
+    ssd1306_dirty_add(&band, 0, ssd->width - 1, scroll->start_page, scroll->end_page);
+    for (int page = scroll->start_page; page <= scroll->end_page; page++) {
+        outside.first[page] = 0xFF;
+        outside.last[page] = 0;
+    }
+
+    const bool rewrite = !scroll->enabled || ssd1306_region_differs(ssd, frame, &band);
+    if (!rewrite && !(scroll->active && ssd1306_region_differs(ssd, frame, &outside))) {
+        sent = ssd1306_diff(ssd, frame, &outside, emit);
+        return sent + ssd1306_scroll_update(ssd, emit_commands);
+    }
+
+    sent = ssd1306_scroll_halt(ssd, emit_commands);
+
+    // Sombra da faixa descartada (o complemento do quadro): a diferença a envia inteira
+    if (ssd->shadow_valid) {
+        for (int i = scroll->start_page * ssd1306_width; i < (scroll->end_page + 1) * ssd1306_width; i++) {
+            ssd->shadow[i] = ~frame[i];
+        }
+    }
+    ssd1306_dirty_merge(&outside, &band);
+    sent += ssd1306_diff(ssd, frame, &outside, emit);
+    scroll->shifted = false;
+    return sent + ssd1306_scroll_update(ssd, emit_commands);
+}
+
+// Regiões que cobrem a tela inteira do display
+static ssd1306_dirty_t ssd1306_full_region(const ssd1306_t *ssd) {
+    ssd1306_dirty_t region;
+    ssd1306_dirty_clear(&region);
+    ssd1306_dirty_add(&region, 0, ssd->width - 1, 0, ssd->pages - 1);
+    return region;
+}
+
+// Regiões do próximo envio (as marcadas ou, sem marcas, a tela inteira), consumindo as marcas
+static ssd1306_dirty_t ssd1306_take_dirty(ssd1306_t *ssd) {
+    ssd1306_dirty_t region = ssd->dirty_marked ? ssd->dirty : ssd1306_full_region(ssd);
+    ssd1306_dirty_clear(&ssd->dirty);
+    ssd->dirty_marked = false;
+    return region;
+}
+
+// Envia ao display (bloqueando) apenas as faixas do framebuffer que mudaram
+void ssd1306_flush(ssd1306_t *ssd) {
+    ssd1306_dirty_t region = ssd1306_take_dirty(ssd);
+    ssd1306_flush_wait(ssd); // Não intercala escritas bloqueantes com uma transferência DMA em curso
+    if (!ssd->shadow_valid) {
+        region = ssd1306_full_region(ssd); // Sem sombra, as marcas não dizem o que o display mostra
+    }
+    ssd1306_diff_scroll(ssd, ssd->ram_buffer + 1, &region, ssd1306_send_span, ssd1306_send_commands);
+}
+
+// Acrescenta um byte ao fluxo do DMA; "stop" encerra a transação após o byte
+static inline void ssd1306_dma_put(ssd1306_t *ssd, uint8_t byte, bool stop) {
+    ssd->dma_words[ssd->dma_length++] = byte | (stop ? ssd1306_dma_stop : 0);
+    ssd->dma_transactions += stop;
+}
+
+// Codifica uma faixa alterada no fluxo do DMA: um fluxo de endereçamento seguido dos dados
+static void ssd1306_encode_span(ssd1306_t *ssd, uint8_t *data, uint8_t page, uint8_t start_column, uint8_t end_column) {
+    ssd1306_command_stream_t stream;
+    ssd1306_address_stream(&stream, start_column, end_column, page, page);
+
+    for (int i = 0; i < stream.length; i++) {
+        ssd1306_dma_put(ssd, stream.buffer[i], i == stream.length - 1);
+    }
+
+    ssd1306_dma_put(ssd, ssd1306_control_data, false);
+    for (int i = start_column; i < end_column; i++) {
+        ssd1306_dma_put(ssd, *data++, false);
+    }
+    ssd1306_dma_put(ssd, *data, true);
+
+    ssd1306_bus_stats_t *bus = &ssd1306_bus_stats[ssd->bus];
+    ssd->diff_stats.areas_sent++;
+    ssd->diff_stats.command_bytes_sent += stream.length;
+    bus->transactions += 2;
+    bus->bytes += stream.length + end_column - start_column + 2;
+}
+
+// Codifica um fluxo de comandos no fluxo do DMA, numa transação própria
+static void ssd1306_encode_commands(ssd1306_t *ssd, const ssd1306_command_stream_t *stream) {
+    for (int i = 0; i < stream->length; i++) {
+        ssd1306_dma_put(ssd, stream->buffer[i], i == stream->length - 1);
+    }
+
+    ssd1306_bus_stats_t *bus = &ssd1306_bus_stats[ssd->bus];
+    ssd->diff_stats.command_bytes_sent += stream->length;
+    bus->transactions++;
+    bus->bytes += stream->length;
+}
+
+// Codifica as diferenças de "frame" nas regiões e dispara o DMA (chamar com interrupções
+// desabilitadas e o barramento livre); retorna false se não havia nada a enviar
+static bool ssd1306_dma_start(ssd1306_t *ssd, uint8_t *frame, const ssd1306_dirty_t *region) {
+    ssd1306_dirty_t full;
+    if (!ssd->shadow_valid) {
+        full = ssd1306_full_region(ssd); // Sombra invalidada (ex.: abortado) depois das marcas
+        region = &full;
+    }
+
+    ssd->dma_length = 0;
+    ssd->dma_transactions = 0;
+    if (ssd1306_diff_scroll(ssd, frame, region, ssd1306_encode_span, ssd1306_encode_commands) == 0) {
+        return false;
+    }
+
+    // Prazo como o das escritas bloqueantes: o dobro do tempo do fluxo mais a folga
+    const ssd1306_bus_stats_t stream = { ssd->dma_transactions, ssd->dma_length };
+    ssd1306_bus_deadline_us[ssd->bus] = time_us_32() + 2 * ssd->transport->time_us(&stream, ssd->clock_khz) +
+                                        ssd1306_write_timeout_margin_us;
+
+    ssd->dma_busy = true;
+    ssd1306_bus_owner[ssd->bus] = ssd;
+    ssd->transport->dma_start(ssd);
+    return true;
+}
+
+// Barramento liberado: dispara o próximo display com quadro pendente nesse barramento, se a
+// FIFO já esvaziou
+static void ssd1306_bus_start_next(uint bus) {
+    for (int i = 0; i < ssd1306_instance_count && ssd1306_bus_owner[bus] == NULL; i++) {
+        ssd1306_t *ssd = ssd1306_instances[i];
+        if (ssd->pending && ssd->bus == bus && !ssd->transport->active(ssd)) {
+            ssd->pending = false;
+            ssd1306_dma_start(ssd, ssd->pending_frame, &ssd->pending_dirty);
+        }
+    }
+}
+
+// Fim da transferência: libera o barramento, encadeia quadros pendentes e notifica o chamador
+static void ssd1306_dma_complete(ssd1306_t *ssd) {
+    uint bus = ssd->bus;
+
+    dma_channel_acknowledge_irq0(ssd->dma_channel);
+    ssd->dma_busy = false;
+    ssd1306_bus_owner[bus] = NULL;
+
+    ssd1306_bus_start_next(bus);
+    if (ssd->flush_callback) {
+        ssd->flush_callback(ssd);
+    }
+}
+
+static void ssd1306_dma_fail(ssd1306_t *ssd, bool stuck);
+
+// Fim de uma transferência: o transporte dispara o próximo trecho do fluxo ou espera a FIFO
+// esvaziar, e o envio termina. Depois de um NAK a FIFO descarta as palavras, e o DMA termina
+// sem nada ter sido enviado; a FIFO que não esvazia no prazo é o barramento preso
+static void ssd1306_dma_advance(ssd1306_t *ssd) {
+    dma_channel_acknowledge_irq0(ssd->dma_channel);
+    if (!ssd->transport->error(ssd) && ssd->transport->dma_next(ssd)) {
+        return;
+    }
+
+    if (ssd->transport->error(ssd)) {
+        ssd1306_bus_stats[ssd->bus].errors++;
+        ssd1306_dma_fail(ssd, false);
+    } else if (ssd->transport->active(ssd)) {
+        ssd1306_bus_stats[ssd->bus].timeouts++;
+        ssd1306_dma_fail(ssd, true);
+    } else {
+        ssd1306_bus_result(ssd, true);
+        ssd1306_dma_complete(ssd);
+    }
+}
+
+// Fluxo interrompido por NAK ou parado além do prazo (stuck): aborta o DMA, recupera o
+// barramento e conta a falha; o quadro segue inteiro no próximo envio
+static void ssd1306_dma_fail(ssd1306_t *ssd, bool stuck) {
+    dma_channel_abort(ssd->dma_channel);
+    ssd->transport->recover(ssd);
+    if (stuck && ssd->transport == &ssd1306_transport_i2c) {
+        ssd1306_i2c_bus_clear(ssd);
+    }
+    ssd1306_invalidate_shadow(ssd);
+    ssd1306_bus_result(ssd, false);
+    ssd1306_dma_complete(ssd);
+}
+
+// Tratador compartilhado do DMA_IRQ_0 para todos os displays
+static void ssd1306_dma_irq_handler() {
+    for (int i = 0; i < ssd1306_instance_count; i++) {
+        ssd1306_t *ssd = ssd1306_instances[i];
+        if (ssd->dma_channel >= 0 && ssd->dma_busy && dma_channel_get_irq0_status(ssd->dma_channel)) {
+            ssd1306_dma_advance(ssd);
+        }
+    }
+}
+
+// Reserva o canal DMA que alimenta a FIFO de transmissão do barramento do display (transportes
+// sem DMA seguem com o envio bloqueante)
+void ssd1306_init_dma(ssd1306_t *ssd) {
+    if (ssd->transport->dma_target == NULL) {
+        return;
+    }
+    ssd->dma_channel = dma_claim_unused_channel(true);
+
+    uint dreq;
+    volatile void *target = ssd->transport->dma_target(ssd, &dreq);
+    dma_channel_config config = dma_channel_get_default_config(ssd->dma_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, dreq);
+    dma_channel_configure(ssd->dma_channel, &config, target, NULL, 0, false);
+    dma_channel_set_irq0_enabled(ssd->dma_channel, true);
+
+    if (!ssd1306_dma_handler_installed) {
+        irq_add_shared_handler(DMA_IRQ_0, ssd1306_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        ssd1306_dma_handler_installed = true;
+    }
+}
+
+// Registra a função chamada (em contexto de interrupção) ao fim de cada transferência DMA
+void ssd1306_set_flush_callback(ssd1306_t *ssd, ssd1306_flush_callback_t callback) {
+    ssd->flush_callback = callback;
+}
+
+static bool ssd1306_bus_poll(ssd1306_t *ssd);
+
+// Sem DMA em curso, o barramento só segue ativo enquanto a FIFO esvazia (até
+// ssd1306_i2c_fifo_depth bytes): espera esse tempo e dispara os pendentes, porque nenhuma
+// interrupção o faria. Uma FIFO que não esvazia fica para ssd1306_bus_poll
+static void ssd1306_bus_settle(ssd1306_t *ssd) {
+    const ssd1306_bus_stats_t fifo = { 1, ssd1306_i2c_fifo_depth };
+    const uint32_t deadline = time_us_32() + ssd->transport->time_us(&fifo, ssd->clock_khz) +
+                              ssd1306_write_timeout_margin_us;
+    while (ssd->transport->active(ssd) && (int32_t)(time_us_32() - deadline) < 0) {
+        tight_loop_contents();
+    }
+    ssd1306_bus_start_next(ssd->bus);
+}
+
+// Versão não bloqueante de ssd1306_flush: codifica as diferenças e retorna imediatamente.
+// Se o barramento estiver ocupado (DMA em curso ou bytes ainda na FIFO), o quadro atual é
+// guardado como pendente (substituindo um pendente anterior) e segue assim que o barramento
+// ficar ocioso
+ssd1306_flush_status_t ssd1306_flush_async(ssd1306_t *ssd) {
+    if (ssd->dma_channel < 0) {
+        ssd1306_flush(ssd);
+        return SSD1306_FLUSH_STARTED;
+    }
+
+    ssd1306_flush_status_t status;
+    uint32_t irq_state = save_and_disable_interrupts();
+    if (ssd1306_bus_owner[ssd->bus] != NULL) {
+        ssd1306_bus_poll(ssd); // Um barramento preso só é percebido pelo prazo, sem interrupção
+    }
+    ssd1306_dirty_t region = ssd1306_take_dirty(ssd);
+
+    if (ssd->dma_busy || ssd->pending || ssd1306_bus_owner[ssd->bus] != NULL || ssd->transport->active(ssd)) {
+        // O pendente substituído ainda não foi comparado: suas regiões somam-se às novas
+        memcpy(ssd->pending_frame, ssd->ram_buffer + 1, ssd->bufsize - 1);
+        if (ssd->pending) {
+            ssd1306_dirty_merge(&region, &ssd->pending_dirty);
+        }
+        ssd->pending_dirty = region;
+        ssd->pending = true;
+        status = SSD1306_FLUSH_QUEUED;
+
+        if (ssd1306_bus_owner[ssd->bus] == NULL) {
+            ssd1306_bus_settle(ssd);
+            if (!ssd->pending) {
+                status = ssd1306_bus_owner[ssd->bus] == ssd ? SSD1306_FLUSH_STARTED : SSD1306_FLUSH_UNCHANGED;
+            }
+        }
+    } else {
+        status = ssd1306_dma_start(ssd, ssd->ram_buffer + 1, &region) ? SSD1306_FLUSH_STARTED : SSD1306_FLUSH_UNCHANGED;
+    }
+
+    restore_interrupts(irq_state);
+    return status;
+}
+
+// Confere erros, prazos e o fim das transferências do barramento do display; retorna se ainda
+// há DMA em curso, quadro pendente ou bytes na FIFO (chamar com interrupções desabilitadas).
+// Passado o prazo do fluxo, o barramento preso é liberado aqui (~100 us de pulsos no SCL)
+static bool ssd1306_bus_poll(ssd1306_t *ssd) {
+    const uint bus = ssd->bus;
+    ssd1306_t *owner = ssd1306_bus_owner[bus];
+    const bool late = (int32_t)(time_us_32() - ssd1306_bus_deadline_us[bus]) > 0;
+
+    if (owner != NULL && owner->transport->error(owner)) {
+        ssd1306_bus_stats[bus].errors++;
+        ssd1306_dma_fail(owner, false);
+    } else if (owner != NULL && !dma_channel_is_busy(owner->dma_channel)) {
+        // Fim já ocorreu, mas o tratador do DMA não pôde rodar (ex.: chamada de outra interrupção)
+        ssd1306_dma_advance(owner);
+    } else if (owner != NULL && late) {
+        ssd1306_bus_stats[bus].timeouts++;
+        ssd1306_dma_fail(owner, true);
+    } else if (owner == NULL && late && ssd->transport->active(ssd)) {
+        // O DMA entregou o fluxo, mas a FIFO não esvazia: o mesmo barramento preso
+        ssd1306_bus_stats[bus].timeouts++;
+        if (ssd->transport == &ssd1306_transport_i2c) {
+            ssd1306_i2c_bus_clear(ssd);
+        }
+        ssd1306_invalidate_shadow(ssd);
+    } else if (owner == NULL) {
+        ssd1306_bus_start_next(bus);
+    }
+
+    bool pending = false;
+    for (int i = 0; i < ssd1306_instance_count; i++) {
+        pending |= ssd1306_instances[i]->pending && ssd1306_instances[i]->bus == bus;
+    }
+
+    return ssd1306_bus_owner[bus] != NULL || pending || ssd->transport->active(ssd);
+}
+
+// Indica se ainda há quadro em transferência ou pendente no barramento do display
+bool ssd1306_flush_busy(ssd1306_t *ssd) {
+    if (ssd->dma_channel < 0 && ssd1306_bus_owner[ssd->bus] == NULL) {
+        return false;
+    }
+
+    uint32_t irq_state = save_and_disable_interrupts();
+    bool busy = ssd1306_bus_poll(ssd);
+    restore_interrupts(irq_state);
+    return busy;
+}
+
+// Aguarda o fim de toda transferência assíncrona no barramento do display (inclusive de
+// outros displays no mesmo barramento) antes de uma escrita bloqueante
+void ssd1306_flush_wait(ssd1306_t *ssd) {
+    while (ssd1306_flush_busy(ssd)) {
+        tight_loop_contents();
+    }
+}
+
+// Pede o scroll horizontal por hardware das páginas start_page..end_page, na direção e no
+// intervalo entre passos dados. O scroll liga ao fim do próximo envio, depois que o conteúdo da
+// faixa chega ao display; daí em diante a faixa gira sem tráfego no barramento
+void ssd1306_scroll_start(ssd1306_t *ssd, uint8_t start_page, uint8_t end_page,
+                          ssd1306_scroll_direction_t direction, ssd1306_scroll_interval_t interval) {
+    assert(start_page <= end_page && end_page < ssd->pages);
+    ssd1306_scroll_t *scroll = &ssd->scroll;
+
+    if (scroll->shifted && (start_page != scroll->start_page || end_page != scroll->end_page)) {
+        ssd1306_invalidate_shadow(ssd); // A faixa anterior está deslocada: o envio reescreve tudo
+        scroll->shifted = false;
+    }
+    scroll->reconfigure = scroll->active;
+    scroll->start_page = start_page;
+    scroll->end_page = end_page;
+    scroll->direction = direction;
+    scroll->interval = interval;
+    scroll->enabled = true;
+    scroll->running = true;
+}
+
+// Pede que o scroll congele onde está (no próximo envio); a faixa segue deslocada até voltar a
+// rolar ou até mudar, quando é reescrita na posição inicial
+void ssd1306_scroll_pause(ssd1306_t *ssd) {
+    ssd->scroll.running = false;
+}
+
+// Pede que a faixa pausada volte a rolar de onde parou (no próximo envio)
+void ssd1306_scroll_resume(ssd1306_t *ssd) {
+    ssd->scroll.running = true;
+}
+
+// Pede o fim do scroll; o próximo envio o desliga e devolve a faixa ao conteúdo do framebuffer
+void ssd1306_scroll_stop(ssd1306_t *ssd) {
+    ssd->scroll.enabled = false;
+    ssd->scroll.running = false;
+}
+
+// Funções livres (API original): operam sobre o display padrão em i2c1, ssd1306_i2c_address
+
+// Display padrão, preparado na primeira utilização
+static ssd1306_t *ssd1306_default_instance() {
+    if (ssd1306_default.ram_buffer == NULL) {
+        ssd1306_init_bm(&ssd1306_default, ssd1306_width, ssd1306_height, false, ssd1306_i2c_address, i2c1);
+    }
+    return &ssd1306_default;
+}
+
 // Processo de escrita do i2c espera um byte de controle, seguido por dados
 void ssd1306_send_command(uint8_t command) {
-    uint8_t buffer[2] = {0x80, command};
-    i2c_write_blocking(i2c1, ssd1306_i2c_address, buffer, 2, false);
+    ssd1306_command(ssd1306_default_instance(), command);
 }
 
-// Envia uma lista de comandos ao hardware
+// Envia uma lista de comandos ao hardware, agrupada em fluxos de uma transação cada
 void ssd1306_send_command_list(uint8_t *ssd, int number) {
-    for (int i = 0; i < number; i++) {
-        ssd1306_send_command(ssd[i]);
+    ssd1306_command_stream_t stream;
+
+    while (number > 0) {
+        ssd1306_command_stream_begin(&stream);
+        while (number > 0 && stream.length < sizeof(stream.buffer)) {
+            ssd1306_command_stream_push(&stream, *ssd++);
+            number--;
+        }
+        ssd1306_command_stream_send(ssd1306_default_instance(), &stream);
     }
 }
 
-// Copia buffer de referência num novo buffer, a fim de adicionar o byte de controle desde o início
+// Envia dados brutos na posição atual da memória do display, em blocos com byte de controle
+// (a memória do display continua de onde o bloco anterior parou), sem alocação
 void ssd1306_send_buffer(uint8_t ssd[], int buffer_length) {
-    uint8_t *temp_buffer = malloc(buffer_length + 1);
+    ssd1306_t *display = ssd1306_default_instance();
+    uint8_t block[33];
 
-    temp_buffer[0] = 0x40;
-    memcpy(temp_buffer + 1, ssd, buffer_length);
-
-    i2c_write_blocking(i2c1, ssd1306_i2c_address, temp_buffer, buffer_length + 1, false);
-
-    free(temp_buffer);
+    ssd1306_flush_wait(display);
+    block[0] = ssd1306_control_data;
+    while (buffer_length > 0) {
+        int length = buffer_length < 32 ? buffer_length : 32;
+        memcpy(block + 1, ssd, length);
+        ssd1306_write(display, block, length + 1);
+        ssd += length;
+        buffer_length -= length;
+    }
 }
 
-// Cria a lista de comandos (com base nos endereços definidos em ssd1306_i2c.h) para a inicialização do display
+// Inicializa o display padrão
 void ssd1306_init() {
-    uint8_t commands[] = {
-        ssd1306_set_display, ssd1306_set_memory_mode, 0x00,
-        ssd1306_set_display_start_line, ssd1306_set_segment_remap | 0x01, 
-        ssd1306_set_mux_ratio, ssd1306_height - 1,
-        ssd1306_set_common_output_direction | 0x08, ssd1306_set_display_offset,
-        0x00, ssd1306_set_common_pin_configuration,
-    
-#if ((ssd1306_width == 128) && (ssd1306_height == 32))
-    0x02,
-#elif ((ssd1306_width == 128) && (ssd1306_height == 64))
-    0x12,
-#else
-    0x02,
-#endif
-        ssd1306_set_display_clock_divide_ratio, 0x80, ssd1306_set_precharge,
-        0xF1, ssd1306_set_vcomh_deselect_level, 0x30, ssd1306_set_contrast,
-        0xFF, ssd1306_set_entire_on, ssd1306_set_normal_display,
-        ssd1306_set_charge_pump, 0x14, ssd1306_set_scroll | 0x00,
-        ssd1306_set_display | 0x01,
-    };
-
-    ssd1306_send_command_list(commands, count_of(commands));
-}
-
-// Cria a lista de comandos para configurar o scrolling
-void ssd1306_scroll(bool set) {
-    uint8_t commands[] = {
-        ssd1306_set_horizontal_scroll | 0x00, 0x00, 0x00, 0x00, 0x03,
-        0x00, 0xFF, ssd1306_set_scroll | (set ? 0x01 : 0)
-    };
+    ssd1306_t *display = ssd1306_default_instance();
+    ssd1306_config(display);
+}
 
-    ssd1306_send_command_list(commands, count_of(commands));
+// Liga ou desliga o scroll para a direita das páginas 0..3 do display padrão
+void ssd1306_scroll(bool set) {
+    ssd1306_t *display = ssd1306_default_instance();
+    if (set) {
+        ssd1306_scroll_start(display, 0, 3, SSD1306_SCROLL_RIGHT, SSD1306_SCROLL_5_FRAMES);
+    } else {
+        ssd1306_scroll_stop(display);
+    }
+    ssd1306_flush(display);
 }
 
-// Atualiza uma parte do display com uma área de renderização
+// Atualiza uma parte do display padrão com uma área de renderização: copia a área para o
+// framebuffer e envia apenas os trechos que diferem da cópia sombra
 void render_on_display(uint8_t *ssd, struct render_area *area) {
-    uint8_t commands[] = {
-        ssd1306_set_column_address, area->start_column, area->end_column,
-        ssd1306_set_page_address, area->start_page, area->end_page
-    };
+    ssd1306_t *display = ssd1306_default_instance();
+    const int area_width = area->end_column - area->start_column + 1;
+
+    for (int page = area->start_page; page <= area->end_page; page++) {
+        memcpy(display->ram_buffer + 1 + page * ssd1306_width + area->start_column,
+            ssd + (page - area->start_page) * area_width, area_width);
+    }
 
-    ssd1306_send_command_list(commands, count_of(commands));
-    ssd1306_send_buffer(ssd, area->buffer_length);
+    ssd1306_dirty_t region;
+    ssd1306_dirty_clear(&region);
+    ssd1306_dirty_add(&region, area->start_column, area->end_column, area->start_page, area->end_page);
+
+    ssd1306_flush_wait(display);
+    ssd1306_diff_scroll(display, display->ram_buffer + 1, &region, ssd1306_send_span, ssd1306_send_commands);
 }
 
 // Determina o pixel a ser aceso (no display) de acordo com a coordenada fornecida
@@ -104,8 +1300,119 @@ void ssd1306_set_pixel(uint8_t *ssd, int x, int y, bool set) {
     ssd[byte_idx] = byte;
 }
 
-// Algoritmo de Bresenham básico
+// Palavra de 32 bits sobre o framebuffer de bytes (may_alias: o acesso por palavra não viola
+// as regras de aliasing do C)
+typedef uint32_t __attribute__((may_alias)) ssd1306_word_t;
+
+// Operação sobre os bits de "mask": byte = (byte & ~clear) ^ toggle. Acender é clear = toggle =
+// mask, apagar é clear = mask e inverter é toggle = mask, sem desvio por operação
+static inline void ssd1306_span_apply(uint8_t *row, int n, uint8_t clear, uint8_t toggle) {
+    // Bytes avulsos até o alinhamento de 4 (o framebuffer começa após o byte de controle)
+    while (n > 0 && ((uintptr_t)row & 3) != 0) {
+        *row = (*row & ~clear) ^ toggle;
+        row++;
+        n--;
+    }
+
+    // Palavras inteiras: a mesma máscara nos 4 bytes (4 colunas da mesma página)
+    const uint32_t clear_word = clear * 0x01010101u;
+    const uint32_t toggle_word = toggle * 0x01010101u;
+    ssd1306_word_t *word = (ssd1306_word_t *)row;
+    for (; n >= 4; n -= 4) {
+        *word = (*word & ~clear_word) ^ toggle_word;
+        word++;
+    }
+
+    row = (uint8_t *)word;
+    while (n-- > 0) {
+        *row = (*row & ~clear) ^ toggle;
+        row++;
+    }
+}
+
+// Aplica a operação ao retângulo (x, y, w, h), recortado à tela: por página, uma máscara com as
+// linhas cobertas e uma faixa de colunas processada por palavras
+static void ssd1306_rect_apply(uint8_t *ssd, int x, int y, int w, int h, bool clear, bool toggle) {
+    const int x_0 = x < 0 ? 0 : x;
+    const int x_1 = x + w > ssd1306_width ? ssd1306_width : x + w; // Exclusivo
+    const int y_0 = y < 0 ? 0 : y;
+    const int y_1 = y + h > ssd1306_height ? ssd1306_height : y + h;
+    if (x_0 >= x_1 || y_0 >= y_1) {
+        return;
+    }
+
+    const int first_page = y_0 >> 3;
+    const int last_page = (y_1 - 1) >> 3;
+    for (int page = first_page; page <= last_page; page++) {
+        const int top = page == first_page ? y_0 & 7 : 0;
+        const int bottom = page == last_page ? (y_1 - 1) & 7 : 7;
+        const uint8_t mask = (uint8_t)((0xFF << top) & (0xFF >> (7 - bottom)));
+        ssd1306_span_apply(&ssd[page * ssd1306_width + x_0], x_1 - x_0, clear ? mask : 0, toggle ? mask : 0);
+    }
+}
+
+// Preenche o framebuffer inteiro (aceso ou apagado)
+void ssd1306_fill(uint8_t *ssd, bool set) {
+    memset(ssd, set ? 0xFF : 0x00, ssd1306_buffer_length);
+}
+
+// Acende ou apaga o retângulo (x, y, w, h); pixels fora da tela são descartados
+void ssd1306_fill_rect(uint8_t *ssd, int x, int y, int w, int h, bool set) {
+    ssd1306_rect_apply(ssd, x, y, w, h, true, set);
+}
+
+// Inverte os pixels do retângulo (x, y, w, h)
+void ssd1306_invert_rect(uint8_t *ssd, int x, int y, int w, int h) {
+    ssd1306_rect_apply(ssd, x, y, w, h, false, true);
+}
+
+// Linha horizontal de w pixels a partir de (x, y): uma faixa de bytes com um único bit
+void ssd1306_draw_hline(uint8_t *ssd, int x, int y, int w, bool set) {
+    ssd1306_rect_apply(ssd, x, y, w, 1, true, set);
+}
+
+// Linha vertical de h pixels a partir de (x, y): um byte por página, com a máscara das linhas
+void ssd1306_draw_vline(uint8_t *ssd, int x, int y, int h, bool set) {
+    ssd1306_rect_apply(ssd, x, y, 1, h, true, set);
+}
+
+// Contorno do retângulo (x, y, w, h)
+void ssd1306_draw_rect(uint8_t *ssd, int x, int y, int w, int h, bool set) {
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+    ssd1306_draw_hline(ssd, x, y, w, set);
+    ssd1306_draw_hline(ssd, x, y + h - 1, w, set);
+    ssd1306_draw_vline(ssd, x, y + 1, h - 2, set);
+    ssd1306_draw_vline(ssd, x + w - 1, y + 1, h - 2, set);
+}
+
+// Barra de progresso em (x, y, w, h): contorno aceso e o interior preenchido na proporção
+// value / max (o restante do interior é apagado)
+void ssd1306_draw_progress(uint8_t *ssd, int x, int y, int w, int h, uint32_t value, uint32_t max) {
+    if (w < 3 || h < 3) {
+        return;
+    }
+    const int inner = w - 2;
+    const int filled = max == 0 ? 0 : (int)((uint64_t)(value > max ? max : value) * inner / max);
+
+    ssd1306_draw_rect(ssd, x, y, w, h, true);
+    ssd1306_fill_rect(ssd, x + 1, y + 1, filled, h - 2, true);
+    ssd1306_fill_rect(ssd, x + 1 + filled, y + 1, inner - filled, h - 2, false);
+}
+
+// Algoritmo de Bresenham, com atalhos para as linhas horizontais e verticais. Cada passo
+// altera o pixel com deslocamentos, sem divisão; pixels fora da tela são descartados
 void ssd1306_draw_line(uint8_t *ssd, int x_0, int y_0, int x_1, int y_1, bool set) {
+    if (y_0 == y_1) {
+        ssd1306_draw_hline(ssd, x_0 < x_1 ? x_0 : x_1, y_0, abs(x_1 - x_0) + 1, set);
+        return;
+    }
+    if (x_0 == x_1) {
+        ssd1306_draw_vline(ssd, x_0, y_0 < y_1 ? y_0 : y_1, abs(y_1 - y_0) + 1, set);
+        return;
+    }
+
     int dx = abs(x_1 - x_0); // Deslocamentos
     int dy = -abs(y_1 - y_0);
     int sx = x_0 < x_1 ? 1 : -1; // Direção de avanço
@@ -114,7 +1421,11 @@ void ssd1306_draw_line(uint8_t *ssd, int x_0, int y_0, int x_1, int y_1, bool se
     int error_2;
 
     while (true) {
-        ssd1306_set_pixel(ssd, x_0, y_0, set); // Acende pixel no ponto atual
+        if ((unsigned)x_0 < ssd1306_width && (unsigned)y_0 < ssd1306_height) {
+            uint8_t *byte = &ssd[(y_0 >> 3) * ssd1306_width + x_0];
+            const uint8_t bit = (uint8_t)(1u << (y_0 & 7));
+            *byte = set ? (*byte | bit) : (*byte & ~bit); // Acende pixel no ponto atual
+        }
         if (x_0 == x_1 && y_0 == y_1) {
             break; // Verifica se o ponto final foi alcançado
         }
@@ -132,114 +1443,167 @@ void ssd1306_draw_line(uint8_t *ssd, int x_0, int y_0, int x_1, int y_1, bool se
     }
 }
 
-// Adquire os pixels para um caractere (de acordo com ssd1306_font.h)
-inline int ssd1306_get_font(uint8_t character)
-{
-  if (character >= 'A' && character <= 'Z') {
-    return character - 'A' + 1;
-  }
-  else if (character >= '0' && character <= '9') {
-    return character - '0' + 27;
-  }
-  else
-    return 0;
+// Glifo de um caractere Latin-1 (de acordo com ssd1306_font.h): uma consulta direta à tabela
+static inline const uint8_t *ssd1306_get_font(uint8_t character) {
+    return ssd1306_font[character];
 }
 
-// Desenha um único caractere no display
+// Lê um caractere UTF-8 da string e avança o ponteiro, devolvendo o código Latin-1. Caracteres
+// fora do Latin-1 viram '?'; bytes acima de 0x7F que não formam UTF-8 são aceitos como Latin-1
+static uint8_t ssd1306_next_char(const char **string) {
+    const uint8_t *s = (const uint8_t *)*string;
+    if (s[0] < 0x80 || (s[1] & 0xC0) != 0x80) {
+        *string += 1;
+        return s[0];
+    }
+
+    int length = 2;
+    while (length < 4 && (s[length] & 0xC0) == 0x80) {
+        length++;
+    }
+    *string += length;
+    return length == 2 && (s[0] == 0xC2 || s[0] == 0xC3) ? (uint8_t)((s[0] & 0x1F) << 6 | (s[1] & 0x3F)) : '?';
+}
+
+// Desenha um único caractere (código Latin-1) com o canto superior esquerdo em (x, y). O y é
+// livre: fora do múltiplo de 8, cada coluna é dividida entre duas páginas. A célula inteira
+// (ssd1306_char_advance x ssd1306_line_height) é sobrescrita; o que sai da tela é descartado
 void ssd1306_draw_char(uint8_t *ssd, int16_t x, int16_t y, uint8_t character) {
-    if (x > ssd1306_width - 8 || y > ssd1306_height - 8) {
+    if (x <= -ssd1306_char_advance || x >= ssd1306_width || y <= -ssd1306_line_height || y >= ssd1306_height) {
         return;
     }
 
-    y = y / 8;
+    const uint8_t *glyph = ssd1306_get_font(character);
+    const int page = y >= 0 ? y / 8 : -1;
+    const int shift = y - page * 8;
+    uint8_t *top = page >= 0 ? &ssd[page * ssd1306_width] : NULL;
+    uint8_t *bottom = shift != 0 && page + 1 < ssd1306_n_pages ? &ssd[(page + 1) * ssd1306_width] : NULL;
+    const uint8_t top_mask = (uint8_t)(0xFF << shift);
+    const uint8_t bottom_mask = (uint8_t)(0xFF >> (8 - shift));
 
-    character = toupper(character);
-    int idx = ssd1306_get_font(character);
-    int fb_idx = y * 128 + x;
+    for (int i = 0; i < ssd1306_char_advance; i++) {
+        const int column = x + i;
+        if (column < 0 || column >= ssd1306_width) {
+            continue;
+        }
 
-    for (int i = 0; i < 8; i++) {
-        ssd[fb_idx++] = font[idx * 8 + i];
+        const uint8_t bits = i < ssd1306_glyph_width ? glyph[i] : 0; // Última coluna: espaçamento
+        if (top) {
+            top[column] = (top[column] & ~top_mask) | (uint8_t)(bits << shift);
+        }
+        if (bottom) {
+            bottom[column] = (bottom[column] & ~bottom_mask) | (uint8_t)(bits >> (8 - shift));
+        }
     }
 }
 
-// Desenha uma string, chamando a função de desenhar caractere várias vezes
-void ssd1306_draw_string(uint8_t *ssd, int16_t x, int16_t y, char *string) {
-    if (x > ssd1306_width - 8 || y > ssd1306_height - 8) {
-        return;
+// Largura em pixels da palavra que começa em string (até um espaço, quebra de linha ou o fim)
+static int ssd1306_word_width(const char *string) {
+    int width = 0;
+    while (*string && *string != ' ' && *string != '\n') {
+        ssd1306_next_char(&string);
+        width += ssd1306_char_advance;
     }
+    return width;
+}
+
+// Desenha uma string UTF-8 a partir de (x, y). '\n' volta à coluna x na linha seguinte e a
+// palavra que não cabe até a borda direita passa inteira para a próxima linha (uma palavra
+// maior que a linha é partida). Retorna o y da linha seguinte à última desenhada
+int ssd1306_draw_string(uint8_t *ssd, int16_t x, int16_t y, const char *string) {
+    const char *start = string;
+    int column = x, line = y;
+
+    while (*string && line < ssd1306_height) {
+        if (*string == '\n') {
+            string++;
+            column = x;
+            line += ssd1306_line_height;
+            continue;
+        }
 
-    while (*string) {
-        ssd1306_draw_char(ssd, x, y, *string++);
-        x += 8;
+        // A última coluna de cada célula é espaçamento: pode ficar fora da tela
+        const int spacing = ssd1306_char_advance - ssd1306_glyph_width;
+        const bool word_start = *string != ' ' && (string == start || string[-1] == ' ' || string[-1] == '\n');
+        const int width = word_start ? ssd1306_word_width(string) : ssd1306_char_advance;
+        if (column > x && column + width - spacing > ssd1306_width && *string != ' ') {
+            column = x;
+            line += ssd1306_line_height;
+        }
+
+        ssd1306_draw_char(ssd, column, line, ssd1306_next_char(&string));
+        column += ssd1306_char_advance;
     }
+    return line + ssd1306_line_height;
 }
 
-// Comando de configuração com base na estrutura ssd1306_t
-void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
-  ssd->port_buffer[1] = command;
-  i2c_write_blocking(
-	ssd->i2c_port, ssd->address, ssd->port_buffer, 2, false );
-}
-
-// Função de configuração do display para o caso do bitmap
-void ssd1306_config(ssd1306_t *ssd) {
-    ssd1306_command(ssd, ssd1306_set_display | 0x00);
-    ssd1306_command(ssd, ssd1306_set_memory_mode);
-    ssd1306_command(ssd, 0x01);
-    ssd1306_command(ssd, ssd1306_set_display_start_line | 0x00);
-    ssd1306_command(ssd, ssd1306_set_segment_remap | 0x01);
-    ssd1306_command(ssd, ssd1306_set_mux_ratio);
-    ssd1306_command(ssd, ssd1306_height - 1);
-    ssd1306_command(ssd, ssd1306_set_common_output_direction | 0x08);
-    ssd1306_command(ssd, ssd1306_set_display_offset);
-    ssd1306_command(ssd, 0x00);
-    ssd1306_command(ssd, ssd1306_set_common_pin_configuration);
-    ssd1306_command(ssd, 0x12);
-    ssd1306_command(ssd, ssd1306_set_display_clock_divide_ratio);
-    ssd1306_command(ssd, 0x80);
-    ssd1306_command(ssd, ssd1306_set_precharge);
-    ssd1306_command(ssd, 0xF1);
-    ssd1306_command(ssd, ssd1306_set_vcomh_deselect_level);
-    ssd1306_command(ssd, 0x30);
-    ssd1306_command(ssd, ssd1306_set_contrast);
-    ssd1306_command(ssd, 0xFF);
-    ssd1306_command(ssd, ssd1306_set_entire_on);
-    ssd1306_command(ssd, ssd1306_set_normal_display);
-    ssd1306_command(ssd, ssd1306_set_charge_pump);
-    ssd1306_command(ssd, 0x14);
-    ssd1306_command(ssd, ssd1306_set_display | 0x01);
-}
-
-// Inicializa o display para o caso de exibição de bitmap
-void ssd1306_init_bm(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
-    ssd->width = width;
-    ssd->height = height;
-    ssd->pages = height / 8U;
-    ssd->address = address;
-    ssd->i2c_port = i2c;
-    ssd->bufsize = ssd->pages * ssd->width + 1;
-    ssd->ram_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
-    ssd->ram_buffer[0] = 0x40;
-    ssd->port_buffer[0] = 0x80;
+// Desenha o bitmap (a ser fornecido em display_oled.c) no display: o bitmap já está na ordem
+// do framebuffer (página a página), então basta uma cópia e um envio
+void ssd1306_draw_bitmap(ssd1306_t *ssd, const uint8_t *bitmap) {
+    memcpy(ssd->ram_buffer + 1, bitmap, ssd->bufsize - 1);
+    ssd1306_send_data(ssd);
 }
 
-// Envia os dados ao display
-void ssd1306_send_data(ssd1306_t *ssd) {
-    ssd1306_command(ssd, ssd1306_set_column_address);
-    ssd1306_command(ssd, 0);
-    ssd1306_command(ssd, ssd->width - 1);
-    ssd1306_command(ssd, ssd1306_set_page_address);
-    ssd1306_command(ssd, 0);
-    ssd1306_command(ssd, ssd->pages - 1);
-    i2c_write_blocking(
-    ssd->i2c_port, ssd->address, ssd->ram_buffer, ssd->bufsize, false );
+// Posição no ram_buffer do byte da coluna x, página "page" (modo horizontal: página a página)
+static inline int ssd1306_bm_index(const ssd1306_t *ssd, int x, int page) {
+    return 1 + page * ssd1306_width + x;
 }
 
-// Desenha o bitmap (a ser fornecido em display_oled.c) no display
-void ssd1306_draw_bitmap(ssd1306_t *ssd, const uint8_t *bitmap) {
-    for (int i = 0; i < ssd->bufsize - 1; i++) {
-        ssd->ram_buffer[i + 1] = bitmap[i];
+// Substitui no ram_buffer os bits de "mask" do byte (x, page) pelos de "bits", se estiver na tela
+static inline void ssd1306_bm_merge(ssd1306_t *ssd, int x, int page, uint8_t bits, uint8_t mask) {
+    if (page < 0 || page >= ssd->pages || mask == 0) {
+        return;
+    }
+
+    uint8_t *byte = &ssd->ram_buffer[ssd1306_bm_index(ssd, x, page)];
+    *byte = (*byte & ~mask) | (bits & mask);
+}
+
+// Copia um bitmap de w x h pixels para o ram_buffer na posição (x, y), sem enviar ao display.
+// O bitmap está organizado em páginas (bitmap[página * w + coluna], bit 0 = linha de cima),
+// como a fonte; com y fora do múltiplo de 8 cada byte é dividido entre duas páginas.
+// Pixels fora da tela são descartados
+void ssd1306_blit(ssd1306_t *ssd, const uint8_t *bitmap, int x, int y, int w, int h) {
+    const int src_pages = (h + 7) / 8;
+
+    for (int src_page = 0; src_page < src_pages; src_page++) {
+        const int rows = h - src_page * 8;
+        const uint8_t mask = rows >= 8 ? 0xFF : (uint8_t)((1u << rows) - 1);
+
+        // Página de destino (divisão com arredondamento para baixo, aceita y negativo) e deslocamento
+        const int dst_y = y + src_page * 8;
+        const int dst_page = dst_y >= 0 ? dst_y / 8 : -((7 - dst_y) / 8);
+        const int shift = dst_y - dst_page * 8;
+
+        for (int column = 0; column < w; column++) {
+            const int dst_x = x + column;
+            if (dst_x < 0 || dst_x >= ssd->width) {
+                continue;
+            }
 
-        ssd1306_send_data(ssd);
+            const uint8_t bits = bitmap[src_page * w + column];
+            ssd1306_bm_merge(ssd, dst_x, dst_page, bits << shift, mask << shift);
+            if (shift != 0) {
+                ssd1306_bm_merge(ssd, dst_x, dst_page + 1, bits >> (8 - shift), mask >> (8 - shift));
+            }
+        }
+    }
+}
+
+// Envia ao display apenas o retângulo (x, y, w, h) do ram_buffer, arredondado para páginas
+// inteiras, pelo mesmo caminho de ssd1306_flush: só os bytes diferentes da sombra vão ao
+// display, junto com as regiões já marcadas, e o scroll por hardware é parado e retomado em
+// volta da escrita
+void ssd1306_send_region(ssd1306_t *ssd, int x, int y, int w, int h) {
+    if (w <= 0 || h <= 0 || x + w <= 0 || y + h <= 0 || x >= ssd->width || y >= ssd->height) {
+        return; // Fora da tela; sem marcas, ssd1306_flush enviaria o quadro inteiro
     }
+    ssd1306_mark_dirty(ssd, x, y, w, h);
+    ssd1306_flush(ssd);
+}
+
+// Copia o bitmap para o ram_buffer e envia só a região afetada
+void ssd1306_draw_bitmap_region(ssd1306_t *ssd, const uint8_t *bitmap, int x, int y, int w, int h) {
+    ssd1306_blit(ssd, bitmap, x, y, w, h);
+    ssd1306_send_region(ssd, x, y, w, h);
 }
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "hardware/spi.h"
 
 #ifndef ssd1306_inc_h
 #define ssd1306_inc_h
@@ -12,6 +13,31 @@
 
 #define ssd1306_i2c_clock 400 // Define o tempo do clock (pode ser aumentado)
 
+// Clock adaptativo do I2C (kHz): ssd1306_probe_clock sobe até o Fast-mode Plus e desce os
+// degraus até o display confirmar ssd1306_probe_writes transações seguidas; em operação,
+// ssd1306_error_limit falhas seguidas derrubam o clock um degrau
+#define ssd1306_i2c_clock_max 1000
+#define ssd1306_i2c_clock_min 100
+#define ssd1306_probe_writes 8
+#define ssd1306_error_limit 3
+
+// Liberação do barramento preso: pulsos de SCL (um byte e o ACK) e meio período de cada um
+#define ssd1306_bus_clear_pulses 9
+#define ssd1306_bus_clear_half_period_us 5
+
+// Pino ainda não informado (ssd1306_set_i2c_pins)
+#define ssd1306_no_pin 0xFF
+
+#define ssd1306_spi_clock 10000 // Clock pedido ao SPI em kHz (o SSD1306 aceita até 10 MHz)
+
+// Prazo de uma escrita no I2C: o dobro do tempo de barramento mais esta folga. Sem display
+// (NAK) ou com o barramento preso, a escrita falha no prazo em vez de travar o núcleo
+#define ssd1306_write_timeout_margin_us 1000
+
+// Profundidade da FIFO de transmissão do I2C: o DMA termina com até esse tanto de bytes ainda
+// por sair no barramento
+#define ssd1306_i2c_fifo_depth 16
+
 // Comandos de configuração (endereços)
 #define ssd1306_set_memory_mode _u(0x20)
 #define ssd1306_set_column_address _u(0x21)
@@ -39,11 +65,37 @@
 #define ssd1306_set_precharge _u(0xD9)
 #define ssd1306_set_common_pin_configuration _u(0xDA)
 #define ssd1306_set_vcomh_deselect_level _u(0xDB)
+#define ssd1306_nop _u(0xE3)
+
+// Texto: glifos 5x7 (ssd1306_font.h) em células de 6 x 8 pixels, 21 colunas por linha
+#define ssd1306_glyph_width 5
+#define ssd1306_char_advance 6
+#define ssd1306_line_height 8
 
 #define ssd1306_page_height _u(8)
 #define ssd1306_n_pages (ssd1306_height / ssd1306_page_height)
 #define ssd1306_buffer_length (ssd1306_n_pages * ssd1306_width)
 
+// Intervalo máximo de colunas iguais absorvido dentro de uma mesma área alterada;
+// abaixo disso reenviar os bytes iguais custa menos que um novo endereçamento
+// (fluxo de 7 bytes mais uma transação de dados: ~10 bytes no barramento)
+#define ssd1306_diff_merge_gap 10
+
+// Pior caso de palavras no fluxo do DMA: todos os dados, mais o fluxo de endereçamento
+// (7 palavras) e o byte de controle de cada faixa, faixas separadas por mais de
+// ssd1306_diff_merge_gap, e os fluxos que desligam e religam o scroll em volta
+#define ssd1306_dma_max_spans_per_page (ssd1306_width / (ssd1306_diff_merge_gap + 2) + 1)
+#define ssd1306_dma_max_words (ssd1306_buffer_length + ssd1306_n_pages * ssd1306_dma_max_spans_per_page * 8 + \
+                               2 * (ssd1306_command_stream_max + 1))
+
+// Bytes de controle: fluxo de comandos (Co = 0, D/C# = 0), comando avulso e dados
+#define ssd1306_control_command_stream _u(0x00)
+#define ssd1306_control_command _u(0x80)
+#define ssd1306_control_data _u(0x40)
+
+// Maior quantidade de comandos de um fluxo montado em tempo de execução
+#define ssd1306_command_stream_max 16
+
 #define ssd1306_write_mode _u(0xFE)
 #define ssd1306_read_mode _u(0xFF)
 
@@ -56,13 +108,177 @@ struct render_area {
     int buffer_length;
 };
 
+// Contadores da renderização por diferença (bytes de dados enviados x evitados)
+typedef struct {
+    uint32_t frames;
+    uint32_t areas_sent;
+    uint32_t data_bytes_sent;
+    uint32_t data_bytes_skipped;
+    uint32_t command_bytes_sent;
+} ssd1306_diff_stats_t;
+
+// Colunas de cada página a comparar com a sombra num envio (first > last: página fora do envio)
+typedef struct {
+    uint8_t first[ssd1306_n_pages];
+    uint8_t last[ssd1306_n_pages];
+} ssd1306_dirty_t;
+
+// Fluxo de comandos enviado numa única transação i2c
+typedef struct {
+    uint8_t buffer[ssd1306_command_stream_max + 1];
+    uint8_t length;
+} ssd1306_command_stream_t;
+
+// Uso do barramento: transações e bytes enviados após o endereço, e falhas
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t errors;      // Transações sem confirmação (NAK, perda de arbitragem)
+    uint32_t timeouts;    // Transações que estouraram o prazo (barramento preso)
+    uint32_t recoveries;  // Liberações do barramento seguidas de reinicialização do bloco
+    uint32_t clock_drops; // Degraus de clock perdidos por falhas seguidas
+} ssd1306_bus_stats_t;
+
+// Direção do scroll horizontal por hardware (o próprio comando de configuração)
+typedef enum {
+    SSD1306_SCROLL_RIGHT = 0x26,
+    SSD1306_SCROLL_LEFT = 0x27
+} ssd1306_scroll_direction_t;
+
+// Intervalo entre passos de uma coluna, em quadros do display (códigos do comando de scroll)
+typedef enum {
+    SSD1306_SCROLL_2_FRAMES = 7,
+    SSD1306_SCROLL_3_FRAMES = 4,
+    SSD1306_SCROLL_4_FRAMES = 5,
+    SSD1306_SCROLL_5_FRAMES = 0,
+    SSD1306_SCROLL_25_FRAMES = 6,
+    SSD1306_SCROLL_64_FRAMES = 1,
+    SSD1306_SCROLL_128_FRAMES = 2,
+    SSD1306_SCROLL_256_FRAMES = 3
+} ssd1306_scroll_interval_t;
+
+// Scroll horizontal de uma faixa de páginas: o controlador gira as 128 colunas da faixa sozinho.
+// As funções de scroll só registram o estado pedido; os comandos seguem no próximo envio, em
+// volta dos dados, porque com o scroll ativo a memória do display não pode ser escrita
 typedef struct {
+    bool enabled;      // Faixa configurada (pedido)
+    bool running;      // Rolando, e não pausada (pedido)
+    bool active;       // Rolando no display
+    bool reconfigure;  // Direção ou intervalo mudaram com o scroll ativo
+    bool shifted;      // Memória da faixa deslocada em relação à sombra
+    uint8_t start_page, end_page;
+    uint8_t direction; // ssd1306_scroll_direction_t
+    uint8_t interval;  // ssd1306_scroll_interval_t
+} ssd1306_scroll_t;
+
+// Resultado de ssd1306_flush_async
+typedef enum {
+    SSD1306_FLUSH_STARTED,   // DMA disparado com as diferenças do quadro
+    SSD1306_FLUSH_QUEUED,    // Transferência em curso; quadro mesclado ao pendente
+    SSD1306_FLUSH_UNCHANGED  // Nada diferente do que o display já mostra
+} ssd1306_flush_status_t;
+
+// Máximo de displays (um por aproximação do cruzamento) gerenciados pelo driver
+#define ssd1306_max_instances 4
+
+// Barramentos com contadores próprios: i2c0, i2c1, spi0, spi1 e o transporte simulado
+#define ssd1306_bus_spi0 2
+#define ssd1306_bus_mock 4
+#define ssd1306_max_buses 5
+
+typedef struct ssd1306 ssd1306_t;
+typedef void (*ssd1306_flush_callback_t)(ssd1306_t *ssd);
+
+// Transporte do display: como cada transação chega ao controlador. O driver monta tudo no
+// formato do I2C (byte de controle seguido do conteúdo; no fluxo do DMA, o bit de STOP encerra
+// cada transação) e o transporte traduz: o SPI troca o byte de controle pelo nível do D/C#
+typedef struct {
+    const char *name;
+
+    // Transação bloqueante: buffer[0] é o byte de controle; retorna false se o display não a
+    // recebeu (NAK ou prazo esgotado)
+    bool (*write)(ssd1306_t *ssd, const uint8_t *buffer, size_t length);
+
+    // DMA (dma_target NULL: sem DMA, o envio assíncrono vira bloqueante). dma_start dispara o
+    // fluxo em dma_words; ao fim de cada transferência, dma_next dispara o próximo trecho e
+    // retorna false quando o fluxo acabou
+    volatile void *(*dma_target)(ssd1306_t *ssd, uint *dreq);
+    void (*dma_start)(ssd1306_t *ssd);
+    bool (*dma_next)(ssd1306_t *ssd);
+
+    // Erro que interrompeu a transmissão (NAK do I2C), limpo por recover depois que o DMA é
+    // abortado, e bytes ainda saindo pelo barramento
+    bool (*error)(ssd1306_t *ssd);
+    void (*recover)(ssd1306_t *ssd);
+    bool (*active)(ssd1306_t *ssd);
+
+    // Tempo de barramento estimado para os contadores, no clock dado
+    uint32_t (*time_us)(const ssd1306_bus_stats_t *stats, uint32_t clock_khz);
+} ssd1306_transport_t;
+
+// Memória do display reconstruída pelo transporte simulado (sem hardware, para testes e
+// benchmarks): só o endereçamento horizontal usado pelo driver; o scroll não é modelado
+typedef struct {
+    uint8_t gddram[ssd1306_buffer_length];
+    uint8_t start_column, end_column, start_page, end_page;
+    uint8_t column, page;
+    uint8_t command[8];
+    uint8_t command_length, command_expected;
+    uint32_t transactions;
+    uint32_t command_bytes;
+    uint32_t data_bytes;
+} ssd1306_mock_t;
+
+// Handle único do driver: transporte, endereço, geometria e todo o armazenamento do display.
+// O framebuffer fica dentro da estrutura, com o byte de controle 0x40 já na posição 0, então
+// um envio completo é uma única escrita sem cópia e sem uso de heap. A largura máxima
+// (ssd1306_width) é sempre o passo entre páginas do framebuffer. A estrutura não pode ser
+// copiada depois de ssd1306_init_bm (ram_buffer aponta para o próprio framebuffer)
+struct ssd1306 {
   uint8_t width, height, pages, address;
   i2c_inst_t * i2c_port;
+
+  // Transporte, barramento (índice dos contadores e do dono do DMA) e clock do barramento
+  const ssd1306_transport_t *transport;
+  uint8_t bus;
+  uint32_t clock_khz;
+  uint8_t clock_step;       // Degrau do clock adaptativo do I2C
+  uint8_t sda_pin, scl_pin; // Para liberar o barramento I2C preso (ssd1306_set_i2c_pins)
+  uint8_t error_streak;     // Falhas seguidas no clock atual
+  spi_inst_t *spi_port;
+  uint8_t dc_pin, cs_pin;
+  ssd1306_mock_t *mock;
   bool external_vcc;
   uint8_t *ram_buffer;
   size_t bufsize;
   uint8_t port_buffer[2];
-} ssd1306_t;
+
+  uint8_t frame[ssd1306_buffer_length + 1];
+
+  // Renderização por diferença
+  uint8_t shadow[ssd1306_buffer_length];
+  bool shadow_valid;
+  ssd1306_diff_stats_t diff_stats;
+
+  // Regiões alteradas desde o último envio (ssd1306_mark_dirty); sem marcas, o envio compara
+  // o quadro inteiro
+  ssd1306_dirty_t dirty;
+  bool dirty_marked;
+
+  // Scroll por hardware (ssd1306_scroll_start)
+  ssd1306_scroll_t scroll;
+
+  // Envio assíncrono via DMA
+  int dma_channel;
+  volatile bool dma_busy;
+  int dma_length;
+  int dma_position; // Próxima transação do fluxo (transportes que enviam uma por transferência)
+  int dma_transactions;
+  uint16_t dma_words[ssd1306_dma_max_words];
+  uint8_t pending_frame[ssd1306_buffer_length];
+  ssd1306_dirty_t pending_dirty;
+  volatile bool pending;
+  ssd1306_flush_callback_t flush_callback;
+};
 
 #endif
\ No newline at end of file
@@ -0,0 +1,135 @@
+// Telas do display pré-renderizadas e validadas em tempo de compilação
+#include "telas.h"
+#include "ssd1306_font.h"
+
+// Sem inicializadores designados em C++17: os textos seguem a ordem de tela_t
+constexpr const char *telas_textos[TELA_N] = {
+    "Sinal:\nVermelho",
+    "Sinal:\nVerde",
+    "Sinal:\nAmarelo",
+    "Travessia\nCentro",
+    "Travessia\nBairro",
+    "Botão A\nCentro",
+    "Botão B\nBairro",
+};
+
+constexpr const char *telas_aviso = "Aguarde travessia";
+
+constexpr char prefixo_contagem[] = telas_prefixo_contagem;
+
+// A mesma fonte de ssd1306_font.h, montada como tabela constexpr
+struct fonte_t {
+    uint8_t glifos[256][ssd1306_glyph_width];
+    bool existe[256];
+};
+
+constexpr fonte_t montar_fonte() {
+    fonte_t f{};
+#define glifo(codigo, c0, c1, c2, c3, c4) \
+    f.glifos[codigo][0] = c0; f.glifos[codigo][1] = c1; f.glifos[codigo][2] = c2; \
+    f.glifos[codigo][3] = c3; f.glifos[codigo][4] = c4; f.existe[codigo] = true;
+    ssd1306_font_glyphs(glifo)
+#undef glifo
+    return f;
+}
+
+constexpr fonte_t fonte = montar_fonte();
+
+// Mesma decodificação UTF-8 -> Latin-1 de ssd1306_next_char
+constexpr uint8_t proximo_caractere(const char *&s) {
+    const uint8_t b0 = static_cast<uint8_t>(s[0]);
+    if (b0 < 0x80 || (static_cast<uint8_t>(s[1]) & 0xC0) != 0x80) {
+        s += 1;
+        return b0;
+    }
+
+    const uint8_t b1 = static_cast<uint8_t>(s[1]);
+    int tamanho = 2;
+    while (tamanho < 4 && (static_cast<uint8_t>(s[tamanho]) & 0xC0) == 0x80) {
+        tamanho++;
+    }
+    s += tamanho;
+    return tamanho == 2 && (b0 == 0xC2 || b0 == 0xC3) ? static_cast<uint8_t>((b0 & 0x1F) << 6 | (b1 & 0x3F)) : '?';
+}
+
+// Desenha o texto a partir do canto superior esquerdo, uma linha por página, com o mesmo
+// resultado de ssd1306_draw_string. Retorna false se o texto dependeria da quebra automática
+// (linha além da borda), passar de n_paginas linhas ou usar um caractere sem glifo
+constexpr bool renderizar(uint8_t (*paginas)[ssd1306_width], int n_paginas, const char *s) {
+    if (s == nullptr) {
+        return false;
+    }
+
+    int pagina = 0, coluna = 0;
+    while (*s) {
+        if (*s == '\n') {
+            s++;
+            pagina++;
+            coluna = 0;
+            continue;
+        }
+
+        const uint8_t c = proximo_caractere(s);
+        if (pagina >= n_paginas || coluna + ssd1306_glyph_width > ssd1306_width || !fonte.existe[c]) {
+            return false;
+        }
+        for (int i = 0; i < ssd1306_glyph_width; i++) {
+            paginas[pagina][coluna + i] = fonte.glifos[c][i];
+        }
+        coluna += ssd1306_char_advance;
+    }
+    return true;
+}
+
+// "Tempo: N", como o sprintf que montava a contagem a cada quadro
+struct texto_contagem_t {
+    char s[sizeof(prefixo_contagem) + 10];
+};
+
+constexpr texto_contagem_t texto_contagem(int n) {
+    texto_contagem_t t{};
+    int i = 0;
+    for (; prefixo_contagem[i]; i++) {
+        t.s[i] = prefixo_contagem[i];
+    }
+
+    char digitos[10] = {};
+    int n_digitos = 0;
+    do {
+        digitos[n_digitos++] = static_cast<char>('0' + n % 10);
+        n /= 10;
+    } while (n > 0);
+    while (n_digitos > 0) {
+        t.s[i++] = digitos[--n_digitos];
+    }
+    return t;
+}
+
+// Preenche todas as imagens; retorna false se alguma não puder ser pré-renderizada
+constexpr bool gerar(telas_imagens_t &imagens) {
+    bool ok = true;
+    for (int tela = 0; tela < TELA_N; tela++) {
+        ok = renderizar(imagens.texto[tela], telas_paginas_texto, telas_textos[tela]) && ok;
+    }
+    for (int n = 1; n <= telas_contagem_max; n++) {
+        ok = renderizar(&imagens.contagem[n], 1, texto_contagem(n).s) && ok;
+    }
+    return renderizar(&imagens.aviso, 1, telas_aviso) && ok;
+}
+
+constexpr telas_imagens_t gerar_imagens() {
+    telas_imagens_t imagens{};
+    gerar(imagens);
+    return imagens;
+}
+
+constexpr bool imagens_completas() {
+    telas_imagens_t imagens{};
+    return gerar(imagens);
+}
+
+constexpr telas_imagens_t telas_imagens = gerar_imagens();
+
+static_assert(imagens_completas(), "tela sem texto, com linhas demais, maior que a largura ou com caractere sem glifo");
+static_assert(telas_pagina_contagem < telas_pagina_aviso, "contagem na pagina do letreiro ou abaixo dela");
+static_assert(telas_contagem_max < 10, "contagem com mais de um digito (telas_largura_numero)");
@@ -0,0 +1,45 @@
+#include "pico/stdlib.h"
+#include "servico_display.h"
+#include "fases.h"
+
+#ifndef telas_inc_h
+#define telas_inc_h
+
+// Telas do display pré-renderizadas em tempo de compilação (telas.cpp): o texto de cada tela
+// ocupa as primeiras páginas do framebuffer e a contagem regressiva ("Tempo: N") a página
+// seguinte. Um quadro é montado só com cópias de páginas, sem formatação nem glifos.
+#define telas_paginas_texto 2                                    // Duas linhas de texto por tela
+#define telas_pagina_contagem telas_paginas_texto                // Página da contagem, logo abaixo
+#define telas_contagem_max (TEMPO_TRAVESSIA / INTERVALO_CONTAGEM) // Maior contagem de uma fase
+
+// Aviso mostrado como letreiro na última página enquanto há pedestre esperando; o scroll por
+// hardware gira só as 128 colunas da memória, então o texto precisa caber numa linha
+#define telas_pagina_aviso (ssd1306_n_pages - 1)
+
+// A contagem é o prefixo seguido de um único dígito (telas.cpp confere), na mesma página
+#define telas_prefixo_contagem "Tempo: "
+#define telas_coluna_numero ((sizeof(telas_prefixo_contagem) - 1) * ssd1306_char_advance)
+#define telas_largura_numero ssd1306_char_advance
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Imagens já na ordem do framebuffer (página a página); contagem[0] é a página em branco das
+// fases sem contagem
+typedef struct {
+    uint8_t texto[TELA_N][telas_paginas_texto][ssd1306_width];
+    uint8_t contagem[telas_contagem_max + 1][ssd1306_width];
+    uint8_t aviso[ssd1306_width];
+} telas_imagens_t;
+
+// Textos e imagens gerados e validados em tempo de compilação, em flash
+extern const char *const telas_textos[TELA_N];
+extern const char *const telas_aviso;
+extern const telas_imagens_t telas_imagens;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,36 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "ssd1306.h"
+#include "ui.h"
+
+// Guarda o novo valor e marca o widget para redesenho só se ele mudou
+void ui_definir(ui_widget_t *widget, int valor) {
+    if (valor != widget->valor) {
+        widget->valor = valor;
+        widget->sujo = true;
+    }
+}
+
+// Copia para o framebuffer a imagem de cada widget sujo e marca no driver só a sua caixa: o
+// próximo envio compara e transmite apenas essas colunas e páginas
+ui_quadro_t ui_desenhar(ssd1306_t *ssd, ui_widget_t *widgets, int n_widgets) {
+    ui_quadro_t quadro = { 0, 0 };
+
+    for (int i = 0; i < n_widgets; i++) {
+        ui_widget_t *w = &widgets[i];
+        if (!w->sujo) {
+            continue;
+        }
+
+        const uint8_t *imagem = w->imagem(w->valor);
+        for (int p = 0; p < w->paginas; p++) {
+            memcpy(ssd->ram_buffer + 1 + (w->pagina + p) * ssd1306_width + w->x, imagem + p * ssd1306_width, w->largura);
+        }
+        ssd1306_mark_dirty(ssd, w->x, w->pagina * ssd1306_page_height, w->largura, w->paginas * ssd1306_page_height);
+
+        w->sujo = false;
+        quadro.widgets++;
+        quadro.bytes_sujos += w->largura * w->paginas;
+    }
+    return quadro;
+}
@@ -0,0 +1,36 @@
+#include "pico/stdlib.h"
+#include "ssd1306_i2c.h"
+
+#ifndef ui_inc_h
+#define ui_inc_h
+
+// Camada retida sobre o framebuffer do SSD1306: cada widget (rótulo, contador, ícone) tem uma
+// caixa fixa em colunas e páginas, o último valor e uma marca de sujo. Um setter só marca o
+// widget quando o valor muda, e o desenho refaz e marca para envio apenas as caixas sujas.
+
+// Imagem do widget para um valor: bytes página a página, com passo de ssd1306_width entre
+// páginas, a partir da coluna onde começa a caixa
+typedef const uint8_t *(*ui_imagem_t)(int valor);
+
+typedef struct {
+    uint8_t x, pagina;      // Canto superior esquerdo da caixa (coluna, página)
+    uint8_t largura, paginas;
+    ui_imagem_t imagem;
+    int valor;              // Último valor definido
+    bool sujo;              // Caixa ainda não redesenhada com o valor atual
+} ui_widget_t;
+
+// Caixa em colunas e páginas, começando suja: o primeiro desenho mostra todos os widgets
+#define UI_WIDGET(x, pagina, largura, paginas, imagem, valor) \
+    { (x), (pagina), (largura), (paginas), (imagem), (valor), true }
+
+// Resumo de um desenho: widgets redesenhados e bytes do framebuffer marcados para envio
+typedef struct {
+    uint8_t widgets;
+    uint16_t bytes_sujos;
+} ui_quadro_t;
+
+void ui_definir(ui_widget_t *widget, int valor);
+ui_quadro_t ui_desenhar(ssd1306_t *ssd, ui_widget_t *widgets, int n_widgets);
+
+#endif
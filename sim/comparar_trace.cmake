@@ -0,0 +1,14 @@
+# Roda o simulador com ARGS e compara o trace gerado em SAIDA com o de referência ESPERADO
+execute_process(
+    COMMAND ${SIM} ${ARGS} --silencioso --trace ${SAIDA}
+    RESULT_VARIABLE resultado)
+if (NOT resultado EQUAL 0)
+    message(FATAL_ERROR "simulador terminou com código ${resultado}")
+endif()
+
+execute_process(
+    COMMAND ${CMAKE_COMMAND} -E compare_files ${SAIDA} ${ESPERADO}
+    RESULT_VARIABLE diferente)
+if (diferente)
+    message(FATAL_ERROR "trace diferente da referência: ${SAIDA} x ${ESPERADO}")
+endif()
@@ -0,0 +1,21 @@
+# Roda o simulador com ARGS, pede o despejo do rastro pela USB simulada e o decodifica com
+# tools/rastro.py; falha se o despejo não puder ser lido ou se faltar alguma das latências
+execute_process(
+    COMMAND ${SIM} ${ARGS}
+    OUTPUT_FILE ${SAIDA}
+    RESULT_VARIABLE resultado)
+if (NOT resultado EQUAL 0)
+    message(FATAL_ERROR "simulador terminou com código ${resultado}")
+endif()
+
+execute_process(
+    COMMAND ${PYTHON} ${DECODIFICADOR} ${SAIDA}
+    OUTPUT_VARIABLE relatorio
+    RESULT_VARIABLE resultado)
+message("${relatorio}")
+if (NOT resultado EQUAL 0)
+    message(FATAL_ERROR "decodificador terminou com código ${resultado}")
+endif()
+if (NOT relatorio MATCHES "Botao ate amarelo: [0-9]+ amostras" OR NOT relatorio MATCHES "Fase ate display: [0-9]+ amostras")
+    message(FATAL_ERROR "histogramas de latência ausentes no rastro")
+endif()
@@ -0,0 +1,24 @@
+// Substituto de "hardware/clocks.h": só guarda as frequências configuradas (o relógio virtual
+// do timer não depende delas, como o timer real, que conta pelo clk_ref)
+#ifndef sim_hardware_clocks_h
+#define sim_hardware_clocks_h
+
+#include "pico/stdlib.h"
+
+#define KHZ 1000
+#define MHZ 1000000
+
+enum clock_index {
+    clk_gpout0, clk_gpout1, clk_gpout2, clk_gpout3,
+    clk_ref, clk_sys, clk_peri, clk_usb, clk_adc, clk_rtc,
+    CLK_COUNT
+};
+
+#define CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX    _u(0x1)
+#define CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS     _u(0x0)
+#define CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB    _u(0x2)
+
+bool clock_configure(enum clock_index clk_index, uint32_t src, uint32_t auxsrc, uint32_t src_freq, uint32_t freq);
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+#endif
@@ -0,0 +1,55 @@
+// Substituto de "hardware/i2c.h": as escritas alimentam o modelo de SSD1306 do simulador e
+// avançam o relógio virtual pelo tempo de barramento
+#ifndef sim_hardware_i2c_h
+#define sim_hardware_i2c_h
+
+#include "pico/stdlib.h"
+
+typedef struct {
+    volatile uint32_t enable;
+    volatile uint32_t tar;
+    volatile uint32_t data_cmd;
+    volatile uint32_t status;
+    volatile uint32_t intr_mask;
+    volatile uint32_t raw_intr_stat;
+    volatile uint32_t clr_tx_abrt;
+    volatile uint32_t clr_stop_det;
+} i2c_hw_t;
+
+typedef struct i2c_inst {
+    i2c_hw_t *hw;
+    bool restart_on_next;
+} i2c_inst_t;
+
+extern i2c_inst_t i2c0_inst;
+extern i2c_inst_t i2c1_inst;
+#define i2c0 (&i2c0_inst)
+#define i2c1 (&i2c1_inst)
+
+#define I2C_IC_DATA_CMD_STOP_BITS _u(0x00000200)
+#define I2C_IC_STATUS_TFE_BITS _u(0x00000004)
+#define I2C_IC_STATUS_MST_ACTIVITY_BITS _u(0x00000020)
+#define I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS _u(0x00000040)
+#define I2C_IC_RAW_INTR_STAT_STOP_DET_BITS _u(0x00000200)
+#define I2C_IC_INTR_MASK_M_TX_ABRT_BITS _u(0x00000040)
+#define I2C_IC_INTR_MASK_M_STOP_DET_BITS _u(0x00000200)
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+void i2c_deinit(i2c_inst_t *i2c);
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us);
+
+static inline uint i2c_get_index(i2c_inst_t *i2c) {
+    return i2c == i2c1 ? 1 : 0;
+}
+
+static inline i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c) {
+    return i2c->hw;
+}
+
+static inline uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx) {
+    return 32 + 2 * i2c_get_index(i2c) + (is_tx ? 0 : 1);
+}
+
+#endif
@@ -0,0 +1,26 @@
+// Substituto de "hardware/irq.h" para o simulador de host
+#ifndef sim_hardware_irq_h
+#define sim_hardware_irq_h
+
+#include "pico/stdlib.h"
+
+typedef void (*irq_handler_t)(void);
+
+enum {
+    TIMER_IRQ_0 = 0,
+    PIO0_IRQ_0 = 7,
+    PIO1_IRQ_0 = 9,
+    DMA_IRQ_0 = 11,
+    DMA_IRQ_1 = 12,
+    I2C0_IRQ = 23,
+    I2C1_IRQ = 24,
+};
+
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+void irq_set_enabled(uint num, bool enabled);
+void irq_set_priority(uint num, uint8_t priority);
+
+#endif
@@ -0,0 +1,78 @@
+// Substituto de "hardware/pio.h": as máquinas de estados rodam num interpretador das instruções,
+// no ritmo de clk_sys / divisor, lendo e escrevendo os níveis dos GPIOs simulados
+#ifndef sim_hardware_pio_h
+#define sim_hardware_pio_h
+
+#include "pico/stdlib.h"
+#include "hardware/irq.h"
+#include "hardware/pio_instructions.h"
+
+#define NUM_PIOS 2
+#define NUM_PIO_STATE_MACHINES 4
+#define PIO_INSTRUCTION_COUNT 32
+
+// Só as FIFOs ficam visíveis, como destino e origem de DMA; o estado das máquinas fica no sim
+typedef struct pio_hw {
+    volatile uint32_t txf[NUM_PIO_STATE_MACHINES];
+    volatile uint32_t rxf[NUM_PIO_STATE_MACHINES];
+} pio_hw_t;
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t sim_pio_hw[NUM_PIOS];
+#define pio0 (&sim_pio_hw[0])
+#define pio1 (&sim_pio_hw[1])
+
+typedef struct {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+typedef struct {
+    float clkdiv;
+    uint in_base;
+    uint out_base;
+    uint out_count;
+    uint jmp_pin;
+    uint wrap_target;
+    uint wrap;
+} pio_sm_config;
+
+enum pio_interrupt_source {
+    pis_sm0_rx_fifo_not_empty = 0,
+    pis_sm1_rx_fifo_not_empty = 1,
+    pis_sm2_rx_fifo_not_empty = 2,
+    pis_sm3_rx_fifo_not_empty = 3,
+};
+
+uint pio_get_index(PIO pio);
+uint pio_get_irq_num(PIO pio, uint irqn);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+void pio_gpio_init(PIO pio, uint pin);
+
+bool pio_can_add_program(PIO pio, const pio_program_t *program);
+int pio_add_program(PIO pio, const pio_program_t *program);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_sm_unclaim(PIO pio, uint sm);
+
+pio_sm_config pio_get_default_sm_config(void);
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base);
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count);
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold);
+void sm_config_set_jmp_pin(pio_sm_config *c, uint pin);
+void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap);
+void sm_config_set_clkdiv(pio_sm_config *c, float div);
+
+int pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_set_clkdiv(PIO pio, uint sm, float div);
+void pio_sm_set_pindirs_with_mask(PIO pio, uint sm, uint32_t pin_dirs, uint32_t pin_mask);
+void pio_sm_restart(PIO pio, uint sm);
+void pio_sm_clear_fifos(PIO pio, uint sm);
+void pio_sm_exec(PIO pio, uint sm, uint instr);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+uint32_t pio_sm_get(PIO pio, uint sm);
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+void pio_set_irq0_source_enabled(PIO pio, enum pio_interrupt_source source, bool enabled);
+
+#endif
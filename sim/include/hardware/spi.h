@@ -0,0 +1,49 @@
+// Substituto de "hardware/spi.h": as escritas alimentam o modelo de SSD1306 do simulador (com o
+// D/C# lido do GPIO dado por --spi-dc) e avançam o relógio virtual pelo tempo de barramento
+#ifndef sim_hardware_spi_h
+#define sim_hardware_spi_h
+
+#include "pico/stdlib.h"
+
+typedef struct {
+    volatile uint32_t cr0;
+    volatile uint32_t cr1;
+    volatile uint32_t dr;
+    volatile uint32_t sr;
+} spi_hw_t;
+
+typedef struct spi_inst spi_inst_t;
+
+extern spi_hw_t sim_spi_hw[2];
+#define spi0 ((spi_inst_t *)&sim_spi_hw[0])
+#define spi1 ((spi_inst_t *)&sim_spi_hw[1])
+
+#define SPI_SSPSR_BSY_BITS _u(0x00000010)
+
+typedef enum { SPI_CPOL_0 = 0, SPI_CPOL_1 = 1 } spi_cpol_t;
+typedef enum { SPI_CPHA_0 = 0, SPI_CPHA_1 = 1 } spi_cpha_t;
+typedef enum { SPI_LSB_FIRST = 0, SPI_MSB_FIRST = 1 } spi_order_t;
+
+uint spi_init(spi_inst_t *spi, uint baudrate);
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate);
+uint spi_get_baudrate(const spi_inst_t *spi);
+void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+
+static inline uint spi_get_index(const spi_inst_t *spi) {
+    return spi == spi1 ? 1 : 0;
+}
+
+static inline spi_hw_t *spi_get_hw(spi_inst_t *spi) {
+    return (spi_hw_t *)spi;
+}
+
+static inline bool spi_is_busy(const spi_inst_t *spi) {
+    return ((const spi_hw_t *)spi)->sr & SPI_SSPSR_BSY_BITS;
+}
+
+static inline uint spi_get_dreq(spi_inst_t *spi, bool is_tx) {
+    return 16 + 2 * spi_get_index(spi) + (is_tx ? 0 : 1);
+}
+
+#endif
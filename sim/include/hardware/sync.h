@@ -0,0 +1,28 @@
+// Substituto de "hardware/sync.h" para o simulador de host
+#ifndef sim_hardware_sync_h
+#define sim_hardware_sync_h
+
+#include "pico/stdlib.h"
+
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+
+static inline void __dmb(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+// Dorme até haver interrupção pendente; com as interrupções mascaradas, retorna sem
+// despachá-la (ela roda no restore_interrupts, como no Cortex-M0+)
+static inline void __wfi(void) {
+    extern void sim_esperar_interrupcao(void);
+    sim_esperar_interrupcao();
+}
+
+static inline void __wfe(void) {
+    tight_loop_contents();
+}
+
+static inline void __sev(void) {
+}
+
+#endif
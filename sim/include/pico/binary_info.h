@@ -0,0 +1,4 @@
+// Substituto de "pico/binary_info.h" para o simulador de host
+#ifndef sim_pico_binary_info_h
+#define sim_pico_binary_info_h
+#endif
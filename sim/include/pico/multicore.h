@@ -0,0 +1,13 @@
+// Substituto de "pico/multicore.h": o core1 roda como corrotina sobre o mesmo relógio virtual
+#ifndef sim_pico_multicore_h
+#define sim_pico_multicore_h
+
+#include "pico/stdlib.h"
+
+void multicore_launch_core1(void (*entry)(void));
+void multicore_fifo_push_blocking(uint32_t data);
+uint32_t multicore_fifo_pop_blocking(void);
+bool multicore_fifo_rvalid(void);
+bool multicore_fifo_wready(void);
+
+#endif
@@ -0,0 +1,42 @@
+// Substituto de "pico/stdlib.h" para o simulador de host
+#ifndef sim_pico_stdlib_h
+#define sim_pico_stdlib_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <assert.h>
+
+typedef unsigned int uint;
+
+#define _u(x) x##u
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+#define MAX(a, b) ((a) < (b) ? (b) : (a))
+#define __not_in_flash_func(f) f
+#define __time_critical_func(f) f
+
+// Códigos de erro de "pico/error.h"
+#define PICO_OK 0
+#define PICO_ERROR_TIMEOUT (-1)
+#define PICO_ERROR_GENERIC (-2)
+
+#include "hardware/timer.h"
+#include "hardware/gpio.h"
+
+static inline void tight_loop_contents(void) {
+    extern void sim_ocioso(void);
+    sim_ocioso();
+}
+
+bool stdio_init_all(void);
+
+// USB CDC: a entrada vem do roteiro (--serial) e a saída binária vai para o stdout
+int getchar_timeout_us(uint32_t timeout_us);
+int putchar_raw(int c);
+void stdio_flush(void);
+void stdio_set_chars_available_callback(void (*fn)(void *), void *param);
+
+uint get_core_num(void);
+
+#endif
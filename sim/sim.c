@@ -0,0 +1,2336 @@
+// Simulador de host do firmware do semáforo: substitui o Pico SDK por um relógio virtual de
+// eventos discretos. Temporizadores, interrupções de GPIO, PIO, I2C, DMA e o core1 avançam sobre o
+// mesmo relógio, de forma determinística, e o resultado é registrado em um trace
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/clocks.h"
+#include "hardware/pio.h"
+#include "sim.h"
+
+#define SIM_MAX_EVENTOS 256
+#define SIM_MAX_GPIO 30
+#define SIM_MAX_DMA 12
+#define SIM_MAX_IRQ 32
+#define SIM_MAX_HANDLERS 4
+#define SIM_MAX_DISPLAYS 8
+#define SIM_MAX_TRACE (1 << 22)
+#define SIM_FIFO_PROFUNDIDADE 8
+#define SIM_I2C_FIFO 16
+#define SIM_PILHA_CORE1 (256 * 1024)
+#define SIM_REPIQUE_US 300
+#define SIM_MAX_ALARMES 16
+#define SIM_SERIAL_BUFFER 256
+
+// ---------------------------------------------------------------------------------------------
+// Relógio virtual e fila de eventos (heap mínimo por instante e ordem de agendamento)
+
+typedef enum {
+    SIM_EV_ALARME,
+    SIM_EV_ALARME_UNICO,
+    SIM_EV_ALARME_HW,
+    SIM_EV_PINO,
+    SIM_EV_PEDESTRE,
+    SIM_EV_DMA_FIM,
+    SIM_EV_I2C_FIFO,
+    SIM_EV_SERIAL,
+    SIM_EV_PIO,
+    SIM_EV_CORE1,
+} sim_ev_tipo_t;
+
+typedef struct {
+    uint64_t instante;
+    uint64_t ordem;
+    sim_ev_tipo_t tipo;
+    void *ptr;
+    int32_t id;
+    uint32_t valor;
+} sim_evento_t;
+
+static sim_evento_t sim_eventos[SIM_MAX_EVENTOS];
+static int sim_n_eventos = 0;
+static uint64_t sim_ordem = 0;
+static uint64_t sim_agora = 0;
+static uint64_t sim_fim = UINT64_MAX;
+static bool sim_finalizando = false;
+static uint32_t sim_custo_irq_us = 0; // Tempo virtual gasto por cada interrupção despachada
+
+static bool sim_antes(const sim_evento_t *a, const sim_evento_t *b) {
+    return a->instante != b->instante ? a->instante < b->instante : a->ordem < b->ordem;
+}
+
+static void sim_subir(int i) {
+    while (i > 0 && sim_antes(&sim_eventos[i], &sim_eventos[(i - 1) / 2])) {
+        sim_evento_t t = sim_eventos[i];
+        sim_eventos[i] = sim_eventos[(i - 1) / 2];
+        sim_eventos[(i - 1) / 2] = t;
+        i = (i - 1) / 2;
+    }
+}
+
+static void sim_agendar(uint64_t instante, sim_ev_tipo_t tipo, void *ptr, int32_t id, uint32_t valor) {
+    if (sim_n_eventos == SIM_MAX_EVENTOS) {
+        fprintf(stderr, "sim: fila de eventos cheia\n");
+        exit(2);
+    }
+
+    int i = sim_n_eventos++;
+    sim_eventos[i] = (sim_evento_t){instante, sim_ordem++, tipo, ptr, id, valor};
+    sim_subir(i);
+}
+
+static sim_evento_t sim_retirar(void) {
+    sim_evento_t topo = sim_eventos[0];
+    sim_eventos[0] = sim_eventos[--sim_n_eventos];
+
+    int i = 0;
+    for (;;) {
+        int menor = i, e = 2 * i + 1, d = 2 * i + 2;
+        if (e < sim_n_eventos && sim_antes(&sim_eventos[e], &sim_eventos[menor])) menor = e;
+        if (d < sim_n_eventos && sim_antes(&sim_eventos[d], &sim_eventos[menor])) menor = d;
+        if (menor == i) break;
+        sim_evento_t t = sim_eventos[i];
+        sim_eventos[i] = sim_eventos[menor];
+        sim_eventos[menor] = t;
+        i = menor;
+    }
+
+    return topo;
+}
+
+// Remove o evento pendente de um tipo e objeto, se houver: ele sobe ao topo e sai por cima
+static void sim_remover(sim_ev_tipo_t tipo, const void *ptr) {
+    for (int i = 0; i < sim_n_eventos; i++) {
+        if (sim_eventos[i].tipo == tipo && sim_eventos[i].ptr == ptr) {
+            sim_eventos[i].instante = 0;
+            sim_eventos[i].ordem = 0;
+            sim_subir(i);
+            sim_retirar();
+            return;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+// Trace: mudanças de saídas GPIO e, opcionalmente, o hash do conteúdo de cada display
+
+typedef struct {
+    uint64_t instante;
+    char tipo;
+    uint32_t id;
+    uint32_t valor;
+} sim_registro_t;
+
+static sim_registro_t *sim_trace = NULL;
+static size_t sim_n_trace = 0;
+static const char *sim_arquivo_trace = NULL;
+static bool sim_trace_display = false;
+static bool sim_tela_final = false;
+
+// Registros podem chegar atrasados (saídas da PIO, escritas quando a máquina sincroniza): o
+// trace continua ordenado pelo instante
+static void sim_registrar_em(uint64_t instante, char tipo, uint32_t id, uint32_t valor) {
+    if (sim_arquivo_trace == NULL || (tipo == 'd' && !sim_trace_display)) {
+        return;
+    }
+    if (sim_trace == NULL) {
+        sim_trace = malloc(SIM_MAX_TRACE * sizeof(sim_registro_t));
+    }
+    if (sim_n_trace < SIM_MAX_TRACE) {
+        size_t i = sim_n_trace++;
+        while (i > 0 && sim_trace[i - 1].instante > instante) {
+            sim_trace[i] = sim_trace[i - 1];
+            i--;
+        }
+        sim_trace[i] = (sim_registro_t){instante, tipo, id, valor};
+    }
+}
+
+static void sim_registrar(char tipo, uint32_t id, uint32_t valor) {
+    sim_registrar_em(sim_agora, tipo, id, valor);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Interrupções: um único nível (sem aninhamento), mascaradas por save_and_disable_interrupts
+
+static int sim_mascara = 0;
+static bool sim_em_irq = false;
+static irq_handler_t sim_handlers[SIM_MAX_IRQ][SIM_MAX_HANDLERS];
+static bool sim_irq_habilitada[SIM_MAX_IRQ];
+
+uint32_t save_and_disable_interrupts(void) {
+    return (uint32_t)sim_mascara++;
+}
+
+static void sim_avancar_ate(uint64_t alvo);
+static bool sim_no_core1;
+
+// Ao desmascarar no core0, as interrupções que ficaram pendentes rodam imediatamente
+void restore_interrupts(uint32_t status) {
+    sim_mascara = (int)status;
+    if (sim_mascara == 0 && !sim_em_irq && !sim_no_core1) {
+        sim_avancar_ate(sim_agora);
+    }
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    memset(sim_handlers[num], 0, sizeof(sim_handlers[num]));
+    sim_handlers[num][0] = handler;
+}
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) {
+    (void)order_priority;
+    for (int i = 0; i < SIM_MAX_HANDLERS; i++) {
+        if (sim_handlers[num][i] == NULL) {
+            sim_handlers[num][i] = handler;
+            return;
+        }
+    }
+    fprintf(stderr, "sim: tratadores demais na IRQ %u\n", num);
+    exit(2);
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    sim_irq_habilitada[num] = enabled;
+}
+
+void irq_set_priority(uint num, uint8_t priority) {
+    (void)num;
+    (void)priority;
+}
+
+static void sim_disparar_irq(uint num) {
+    if (!sim_irq_habilitada[num]) {
+        return;
+    }
+    for (int i = 0; i < SIM_MAX_HANDLERS && sim_handlers[num][i] != NULL; i++) {
+        sim_handlers[num][i]();
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+// Verificações de invariantes sobre as saídas
+
+typedef struct {
+    bool ativa;
+    uint pino_a, pino_b;
+    bool armada;
+    bool pendente;
+    uint32_t violacoes;
+} sim_sempre_aceso_t;
+
+static sim_sempre_aceso_t sim_aceso = {0};
+static uint32_t sim_max_alto_us[SIM_MAX_GPIO];
+static uint64_t sim_subida_us[SIM_MAX_GPIO];
+static uint64_t sim_maior_alto_us[SIM_MAX_GPIO];
+static uint32_t sim_violacoes_alto = 0;
+
+// ---------------------------------------------------------------------------------------------
+// GPIO
+
+static bool sim_saida[SIM_MAX_GPIO];
+static bool sim_nivel[SIM_MAX_GPIO];
+static bool sim_pull_up[SIM_MAX_GPIO];
+static uint32_t sim_irq_eventos[SIM_MAX_GPIO];
+static gpio_function_t sim_funcao[SIM_MAX_GPIO];
+static gpio_irq_callback_t sim_gpio_callback = NULL;
+
+#define SIM_ENVOLTORIA_US 5000
+
+typedef struct {
+    bool aberta;         // Envoltória registrada como alta no trace
+    bool alto;           // Nível atual do pino
+    uint64_t descida_us; // Última descida dentro da envoltória
+} sim_envoltoria_t;
+
+static sim_envoltoria_t sim_envoltorias[SIM_MAX_GPIO];
+static uint32_t sim_transicoes = 0;
+
+// Avaliada só quando o relógio vai avançar: trocas feitas no mesmo instante (apaga um LED e
+// acende o outro) não contam como as duas saídas apagadas
+static void sim_verificar_aceso(void) {
+    if (!sim_aceso.ativa || !sim_aceso.pendente) {
+        return;
+    }
+    sim_aceso.pendente = false;
+
+    bool algum = sim_nivel[sim_aceso.pino_a] || sim_nivel[sim_aceso.pino_b];
+    if (!sim_aceso.armada) {
+        sim_aceso.armada = algum;
+    } else if (!algum) {
+        if (sim_aceso.violacoes++ < 5) {
+            fprintf(stderr, "sim: %llu us: GPIO %u e %u apagados ao mesmo tempo\n",
+                    (unsigned long long)sim_agora, sim_aceso.pino_a, sim_aceso.pino_b);
+        }
+    }
+}
+
+static void sim_i2c_pulso_scl(uint gpio);
+static bool sim_i2c_sda_presa(uint gpio);
+
+void gpio_init(uint gpio) {
+    sim_saida[gpio] = false;
+    sim_nivel[gpio] = false;
+    sim_funcao[gpio] = GPIO_FUNC_SIO;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    if (out && !sim_saida[gpio]) {
+        sim_i2c_pulso_scl(gpio);
+    }
+    sim_saida[gpio] = out;
+}
+
+// Registra uma transição de saída no trace e confere o tempo máximo em nível alto
+static void sim_registrar_saida(uint gpio, bool value, uint64_t instante) {
+    sim_transicoes++;
+    sim_registrar_em(instante, 'g', gpio, value);
+
+    if (value) {
+        sim_subida_us[gpio] = instante;
+    } else {
+        uint64_t alto = instante - sim_subida_us[gpio];
+        if (alto > sim_maior_alto_us[gpio]) {
+            sim_maior_alto_us[gpio] = alto;
+        }
+        if (sim_max_alto_us[gpio] && alto > sim_max_alto_us[gpio] && sim_violacoes_alto++ < 5) {
+            fprintf(stderr, "sim: %llu us: GPIO %u ficou alto por %llu us\n",
+                    (unsigned long long)instante, gpio, (unsigned long long)alto);
+        }
+    }
+}
+
+void gpio_put(uint gpio, bool value) {
+    if (sim_funcao[gpio] == GPIO_FUNC_PIO0 || sim_funcao[gpio] == GPIO_FUNC_PIO1) {
+        return; // O pino é da PIO
+    }
+    if (!sim_saida[gpio] || sim_nivel[gpio] == value) {
+        sim_nivel[gpio] = sim_saida[gpio] ? value : sim_nivel[gpio];
+        return;
+    }
+
+    sim_nivel[gpio] = value;
+    sim_registrar_saida(gpio, value, sim_agora);
+    sim_aceso.pendente = true;
+}
+
+// Saída de uma máquina de estados da PIO, no instante do ciclo em que foi escrita. Um tom
+// vira uma única envoltória no trace: bordas separadas por menos de SIM_ENVOLTORIA_US se
+// fundem, e o fim da envoltória só é registrado quando o silêncio passa desse intervalo
+static void sim_fechar_envoltoria(uint gpio) {
+    sim_envoltoria_t *e = &sim_envoltorias[gpio];
+    if (e->aberta && !e->alto) {
+        e->aberta = false;
+        sim_registrar_saida(gpio, false, e->descida_us);
+    }
+}
+
+static void sim_saida_pio(uint gpio, bool nivel, uint64_t instante) {
+    sim_envoltoria_t *e = &sim_envoltorias[gpio];
+    sim_nivel[gpio] = nivel;
+    if (nivel == e->alto) {
+        return;
+    }
+    if (!nivel) {
+        e->alto = false;
+        e->descida_us = instante;
+        return;
+    }
+    if (e->aberta && instante - e->descida_us > SIM_ENVOLTORIA_US) {
+        sim_fechar_envoltoria(gpio);
+    }
+    e->alto = true;
+    if (!e->aberta) {
+        e->aberta = true;
+        sim_registrar_saida(gpio, true, instante);
+    }
+}
+
+bool gpio_get(uint gpio) {
+    return sim_nivel[gpio] && !sim_i2c_sda_presa(gpio);
+}
+
+void gpio_pull_up(uint gpio) {
+    sim_pull_up[gpio] = true;
+    if (!sim_saida[gpio]) {
+        sim_nivel[gpio] = true;
+    }
+}
+
+void gpio_pull_down(uint gpio) {
+    sim_pull_up[gpio] = false;
+    if (!sim_saida[gpio]) {
+        sim_nivel[gpio] = false;
+    }
+}
+
+static bool sim_pino_i2c[SIM_MAX_GPIO];
+
+void gpio_set_function(uint gpio, gpio_function_t fn) {
+    sim_funcao[gpio] = fn;
+    sim_pino_i2c[gpio] |= fn == GPIO_FUNC_I2C;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled) {
+    sim_irq_eventos[gpio] = enabled ? (sim_irq_eventos[gpio] | events) : (sim_irq_eventos[gpio] & ~events);
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback) {
+    gpio_set_irq_enabled(gpio, events, enabled);
+    sim_gpio_callback = callback;
+}
+
+static void sim_pio_sincronizar_todas(void);
+static void sim_pio_prever_todas(void);
+
+// Muda o nível de uma entrada e gera a interrupção de borda correspondente; as máquinas de
+// estados da PIO rodam até aqui com o nível antigo e refazem a previsão com o novo
+static bool sim_mudar_entrada(uint gpio, bool nivel) {
+    if (sim_nivel[gpio] == nivel) {
+        return false;
+    }
+
+    sim_pio_sincronizar_todas();
+    sim_nivel[gpio] = nivel;
+    sim_pio_prever_todas();
+    uint32_t borda = nivel ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if ((sim_irq_eventos[gpio] & borda) && sim_gpio_callback != NULL) {
+        sim_gpio_callback(gpio, borda);
+        return true;
+    }
+    return false;
+}
+
+// Agenda um aperto (nível baixo) com repiques no início e no fim
+static void sim_agendar_aperto(uint64_t instante, uint gpio, uint32_t duracao_ms, int repiques) {
+    uint64_t t = instante;
+    for (int i = 0; i < repiques; i++) {
+        sim_agendar(t, SIM_EV_PINO, NULL, (int32_t)gpio, 0);
+        sim_agendar(t + SIM_REPIQUE_US / 2, SIM_EV_PINO, NULL, (int32_t)gpio, 1);
+        t += SIM_REPIQUE_US;
+    }
+    sim_agendar(t, SIM_EV_PINO, NULL, (int32_t)gpio, 0);
+
+    uint64_t solta = instante + (uint64_t)duracao_ms * 1000;
+    for (int i = 0; i < repiques; i++) {
+        sim_agendar(solta, SIM_EV_PINO, NULL, (int32_t)gpio, 1);
+        sim_agendar(solta + SIM_REPIQUE_US / 2, SIM_EV_PINO, NULL, (int32_t)gpio, 0);
+        solta += SIM_REPIQUE_US;
+    }
+    sim_agendar(solta, SIM_EV_PINO, NULL, (int32_t)gpio, 1);
+}
+
+void sim_agendar_botao(uint64_t instante_us, uint gpio, uint32_t duracao_ms, int repiques) {
+    sim_agendar_aperto(instante_us, gpio, duracao_ms, repiques);
+}
+
+// Pedestres periódicos: um aperto por período, em instante pseudoaleatório dentro dele
+typedef struct {
+    uint gpio;
+    uint32_t periodo_ms;
+    uint32_t semente;
+} sim_pedestre_t;
+
+static sim_pedestre_t sim_pedestres[4];
+static int sim_n_pedestres = 0;
+
+static uint32_t sim_aleatorio(uint32_t *semente) {
+    *semente = *semente * 1664525u + 1013904223u;
+    return *semente >> 8;
+}
+
+static void sim_proximo_pedestre(sim_pedestre_t *p, uint64_t inicio_periodo) {
+    uint64_t periodo_us = (uint64_t)p->periodo_ms * 1000;
+    uint64_t instante = inicio_periodo + sim_aleatorio(&p->semente) % periodo_us;
+    sim_agendar(instante, SIM_EV_PEDESTRE, p, 0, (uint32_t)(inicio_periodo / periodo_us));
+}
+
+void sim_pedestres_periodicos(uint gpio, uint32_t periodo_ms, uint32_t semente) {
+    sim_pedestre_t *p = &sim_pedestres[sim_n_pedestres++];
+    *p = (sim_pedestre_t){gpio, periodo_ms, semente};
+    sim_proximo_pedestre(p, 0);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Temporizadores repetitivos com a semântica do SDK (atraso negativo: de início a início)
+
+static alarm_id_t sim_proximo_alarme = 1;
+
+uint64_t time_us_64(void) {
+    return sim_agora;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)sim_agora;
+}
+
+absolute_time_t get_absolute_time(void) {
+    return sim_agora;
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out) {
+    uint64_t atraso = (uint64_t)(delay_us < 0 ? -delay_us : delay_us);
+    out->delay_us = delay_us;
+    out->callback = callback;
+    out->user_data = user_data;
+    out->alarm_id = sim_proximo_alarme++;
+    sim_agendar(sim_agora + atraso, SIM_EV_ALARME, out, out->alarm_id, 0);
+    return true;
+}
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out) {
+    return add_repeating_timer_us((int64_t)delay_ms * 1000, callback, user_data, out);
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer) {
+    bool ativo = timer->alarm_id != 0;
+    timer->alarm_id = 0;
+    return ativo;
+}
+
+static bool sim_alarme(const sim_evento_t *ev) {
+    repeating_timer_t *rt = ev->ptr;
+    if (rt->alarm_id != ev->id) {
+        return false; // cancelado ou rearmado com outro id
+    }
+
+    if (!rt->callback(rt)) {
+        if (rt->alarm_id == ev->id) {
+            rt->alarm_id = 0;
+        }
+        return true;
+    }
+    if (rt->alarm_id != ev->id) {
+        return true;
+    }
+
+    uint64_t base = rt->delay_us < 0 ? ev->instante : sim_agora;
+    uint64_t atraso = (uint64_t)(rt->delay_us < 0 ? -rt->delay_us : rt->delay_us);
+    sim_agendar(base + atraso, SIM_EV_ALARME, rt, rt->alarm_id, 0);
+    return true;
+}
+
+// Alarmes do pool padrão: o retorno do callback segue o SDK (<0: reagenda a partir do instante
+// previsto, >0: a partir do fim do callback, 0: encerra)
+typedef struct {
+    alarm_id_t id;
+    alarm_callback_t callback;
+    void *user_data;
+} sim_alarme_t;
+
+static sim_alarme_t sim_alarmes[SIM_MAX_ALARMES];
+
+alarm_id_t add_alarm_at(absolute_time_t time, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    if (time <= sim_agora && !fire_if_past) {
+        return 0;
+    }
+
+    for (int i = 0; i < SIM_MAX_ALARMES; i++) {
+        if (sim_alarmes[i].id == 0) {
+            sim_alarmes[i] = (sim_alarme_t){sim_proximo_alarme++, callback, user_data};
+            sim_agendar(time > sim_agora ? time : sim_agora, SIM_EV_ALARME_UNICO, &sim_alarmes[i], sim_alarmes[i].id, 0);
+            return sim_alarmes[i].id;
+        }
+    }
+    return -1; // Pool cheio, como PICO_ERROR_GENERIC
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_at(sim_agora + us, callback, user_data, fire_if_past);
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_in_us((uint64_t)ms * 1000, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    for (int i = 0; i < SIM_MAX_ALARMES; i++) {
+        if (alarm_id > 0 && sim_alarmes[i].id == alarm_id) {
+            sim_alarmes[i].id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool sim_alarme_unico(const sim_evento_t *ev) {
+    sim_alarme_t *a = ev->ptr;
+    if (a->id != ev->id) {
+        return false;
+    }
+
+    int64_t retorno = a->callback(a->id, a->user_data);
+    if (a->id != ev->id) {
+        return true;
+    }
+    if (retorno == 0) {
+        a->id = 0;
+        return true;
+    }
+
+    uint64_t base = retorno < 0 ? ev->instante : sim_agora;
+    sim_agendar(base + (uint64_t)(retorno < 0 ? -retorno : retorno), SIM_EV_ALARME_UNICO, a, a->id, 0);
+    return true;
+}
+
+// Alarmes de hardware (4 no RP2040; o 3 é do pool padrão): um alvo por vez, e o alvo já
+// passado é informado como perdido, como no SDK
+typedef struct {
+    bool reservado;
+    hardware_alarm_callback_t callback;
+    int32_t geracao;
+} sim_alarme_hw_t;
+
+static sim_alarme_hw_t sim_alarmes_hw[4] = {[3] = {.reservado = true}};
+
+void hardware_alarm_claim(uint alarm_num) {
+    sim_alarmes_hw[alarm_num].reservado = true;
+}
+
+int hardware_alarm_claim_unused(bool required) {
+    for (uint i = 0; i < 4; i++) {
+        if (!sim_alarmes_hw[i].reservado) {
+            sim_alarmes_hw[i].reservado = true;
+            return (int)i;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "sim: sem alarmes de hardware livres\n");
+        exit(2);
+    }
+    return -1;
+}
+
+void hardware_alarm_set_callback(uint alarm_num, hardware_alarm_callback_t callback) {
+    sim_alarmes_hw[alarm_num].callback = callback;
+}
+
+bool hardware_alarm_set_target(uint alarm_num, absolute_time_t t) {
+    sim_alarme_hw_t *a = &sim_alarmes_hw[alarm_num];
+    a->geracao++;
+    if (t <= sim_agora) {
+        return true;
+    }
+    sim_agendar(t, SIM_EV_ALARME_HW, a, a->geracao, alarm_num);
+    return false;
+}
+
+void hardware_alarm_cancel(uint alarm_num) {
+    sim_alarmes_hw[alarm_num].geracao++;
+}
+
+void hardware_alarm_force_irq(uint alarm_num) {
+    sim_alarme_hw_t *a = &sim_alarmes_hw[alarm_num];
+    sim_agendar(sim_agora, SIM_EV_ALARME_HW, a, a->geracao, alarm_num);
+}
+
+static bool sim_alarme_hw(const sim_evento_t *ev) {
+    sim_alarme_hw_t *a = ev->ptr;
+    if (a->geracao != ev->id || a->callback == NULL) {
+        return false;
+    }
+    a->callback(ev->valor);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Modelo do SSD1306: bytes de controle, comandos com parâmetros e GDDRAM endereçada
+
+typedef struct {
+    bool usado;
+    uint bus;
+    uint8_t endereco;
+    uint8_t gddram[8][128];
+    uint8_t modo;
+    uint8_t col_ini, col_fim, pag_ini, pag_fim;
+    uint8_t col, pag;
+    uint8_t comando[8];
+    int n_comando;
+    int esperados;
+    bool ligado;
+    bool rolagem;
+    uint32_t rolagens;          // Ativações do scroll (0x2F)
+    uint32_t escritas_rolando;  // Dados ou configuração de scroll com o scroll ativo (proibido)
+    uint32_t hash;
+    uint32_t quadros;
+} sim_display_t;
+
+static sim_display_t sim_displays[SIM_MAX_DISPLAYS];
+
+static sim_display_t *sim_display(uint bus, uint8_t endereco) {
+    for (int i = 0; i < SIM_MAX_DISPLAYS; i++) {
+        if (sim_displays[i].usado && sim_displays[i].bus == bus && sim_displays[i].endereco == endereco) {
+            return &sim_displays[i];
+        }
+    }
+    for (int i = 0; i < SIM_MAX_DISPLAYS; i++) {
+        if (!sim_displays[i].usado) {
+            sim_display_t *d = &sim_displays[i];
+            memset(d, 0, sizeof(*d));
+            d->usado = true;
+            d->bus = bus;
+            d->endereco = endereco;
+            d->modo = 2;
+            d->col_fim = 127;
+            d->pag_fim = 7;
+            return d;
+        }
+    }
+    fprintf(stderr, "sim: displays demais\n");
+    exit(2);
+}
+
+// Quantidade de parâmetros que seguem cada comando
+static int sim_parametros(uint8_t c) {
+    switch (c) {
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+            return 1;
+        case 0x21: case 0x22: case 0xA3:
+            return 2;
+        case 0x29: case 0x2A:
+            return 5;
+        case 0x26: case 0x27:
+            return 6;
+        default:
+            return 0;
+    }
+}
+
+// O datasheet proíbe acessar a GDDRAM e reconfigurar o scroll enquanto ele está ativo
+static void sim_violacao_rolagem(sim_display_t *d, const char *acao) {
+    if (d->escritas_rolando++ < 5) {
+        fprintf(stderr, "sim: %llu us: display %u/0x%02x: %s com o scroll ativo\n",
+                (unsigned long long)sim_agora, d->bus, d->endereco, acao);
+    }
+}
+
+static void sim_executar_comando(sim_display_t *d) {
+    uint8_t *c = d->comando;
+    switch (c[0]) {
+        case 0x26: case 0x27: case 0x29: case 0x2A:
+            if (d->rolagem) sim_violacao_rolagem(d, "configuração de scroll");
+            break;
+        case 0x20: d->modo = c[1] & 3; break;
+        case 0x21: d->col_ini = d->col = c[1] & 127; d->col_fim = c[2] & 127; break;
+        case 0x22: d->pag_ini = d->pag = c[1] & 7; d->pag_fim = c[2] & 7; break;
+        case 0x2E: d->rolagem = false; break;
+        case 0x2F: d->rolagem = true; d->rolagens++; break;
+        case 0xAE: d->ligado = false; break;
+        case 0xAF: d->ligado = true; break;
+        default:
+            if (c[0] >= 0xB0 && c[0] <= 0xB7) {
+                d->pag = c[0] & 7;
+            } else if (c[0] <= 0x0F) {
+                d->col = (d->col & 0xF0) | c[0];
+            } else if (c[0] >= 0x10 && c[0] <= 0x1F) {
+                d->col = (uint8_t)((d->col & 0x0F) | ((c[0] & 0x0F) << 4));
+            }
+            break;
+    }
+}
+
+static void sim_byte_comando(sim_display_t *d, uint8_t b) {
+    if (d->n_comando == 0) {
+        d->esperados = sim_parametros(b);
+    }
+    d->comando[d->n_comando++] = b;
+    if (d->n_comando > d->esperados) {
+        sim_executar_comando(d);
+        d->n_comando = 0;
+    }
+}
+
+static void sim_byte_dado(sim_display_t *d, uint8_t b) {
+    if (d->rolagem) {
+        sim_violacao_rolagem(d, "escrita na GDDRAM");
+    }
+    d->gddram[d->pag & 7][d->col & 127] = b;
+
+    if (d->modo == 0) {
+        if (d->col++ >= d->col_fim) {
+            d->col = d->col_ini;
+            d->pag = d->pag >= d->pag_fim ? d->pag_ini : d->pag + 1;
+        }
+    } else if (d->modo == 1) {
+        if (d->pag++ >= d->pag_fim) {
+            d->pag = d->pag_ini;
+            d->col = d->col >= d->col_fim ? d->col_ini : d->col + 1;
+        }
+    } else {
+        d->col = (d->col + 1) & 127;
+    }
+}
+
+static uint32_t sim_hash(const sim_display_t *d) {
+    uint32_t h = 2166136261u;
+    const uint8_t *p = &d->gddram[0][0];
+    for (size_t i = 0; i < sizeof(d->gddram); i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+// Interpreta uma transação I2C completa (do START ao STOP) endereçada a um display
+static void sim_transacao(uint bus, uint8_t endereco, const uint8_t *bytes, size_t n) {
+    sim_display_t *d = sim_display(bus, endereco);
+    size_t i = 0;
+    bool dados = false;
+
+    while (i < n) {
+        uint8_t controle = bytes[i++];
+        bool continuo = !(controle & 0x80);
+        dados = controle & 0x40;
+
+        size_t fim = continuo ? n : (i + 1 < n ? i + 1 : n);
+        for (; i < fim; i++) {
+            if (dados) {
+                sim_byte_dado(d, bytes[i]);
+            } else {
+                sim_byte_comando(d, bytes[i]);
+            }
+        }
+    }
+
+    if (dados) {
+        uint32_t h = sim_hash(d);
+        if (h != d->hash) {
+            d->hash = h;
+            d->quadros++;
+            sim_registrar('d', (bus << 8) | endereco, h);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+// I2C: escritas bloqueantes avançam o relógio pelo tempo de barramento
+
+static i2c_hw_t sim_i2c_hw[2] = {{.status = I2C_IC_STATUS_TFE_BITS}, {.status = I2C_IC_STATUS_TFE_BITS}};
+i2c_inst_t i2c0_inst = {&sim_i2c_hw[0], false};
+i2c_inst_t i2c1_inst = {&sim_i2c_hw[1], false};
+static uint sim_baudrate[2] = {100000, 100000};
+
+// Duração de uma transação: START, endereço + ACK, 9 bits por byte e STOP
+static uint64_t sim_tempo_barramento(uint bus, size_t transacoes, size_t bytes) {
+    uint64_t bits = transacoes * 11 + bytes * 9;
+    return (bits * 1000000 + sim_baudrate[bus] - 1) / sim_baudrate[bus];
+}
+
+// FIFO de transmissão: o DMA termina quando a última palavra entra nela, e as SIM_I2C_FIFO
+// finais ainda levam seu tempo de barramento para sair. Guarda as palavras desde o início da
+// transação em que a FIFO começa; "corte" separa as que já saíram das que ainda estão nela
+typedef struct {
+    bool cheia;
+    uint8_t tar;
+    uint16_t palavras[2048];
+    size_t n, corte;
+    uint64_t fim;
+} sim_i2c_fifo_t;
+
+static sim_i2c_fifo_t sim_i2c_fifo[2];
+static uint32_t sim_i2c_descartados[2]; // Bytes que nunca saíram da FIFO (bloco desligado antes)
+
+static bool sim_i2c_preso(void);
+static uint64_t sim_i2c_preso_desde;
+
+// Entrega ao modelo do display as transações de um trecho de palavras do data_cmd, separadas
+// pelo bit de STOP (a última, sem STOP, vai como chegou)
+static void sim_i2c_entregar(uint bus, uint8_t tar, const uint16_t *palavras, size_t quantidade) {
+    static uint8_t bytes[2048];
+    size_t n = 0;
+    for (size_t i = 0; i < quantidade; i++) {
+        if (n < sizeof(bytes)) {
+            bytes[n++] = (uint8_t)palavras[i];
+        }
+        if (palavras[i] & I2C_IC_DATA_CMD_STOP_BITS) {
+            sim_transacao(bus, tar, bytes, n);
+            n = 0;
+        }
+    }
+    if (n > 0) {
+        sim_transacao(bus, tar, bytes, n);
+    }
+}
+
+// A FIFO esvaziou no tempo dela: entrega o restante, o bloco fica ocioso e registra o STOP
+static void sim_i2c_esvaziar(uint bus) {
+    sim_i2c_fifo_t *f = &sim_i2c_fifo[bus];
+    if (f->cheia && sim_agora >= f->fim && !sim_i2c_preso()) {
+        f->cheia = false;
+        sim_i2c_entregar(bus, f->tar, f->palavras, f->n);
+        sim_i2c_hw[bus].status = I2C_IC_STATUS_TFE_BITS;
+        sim_i2c_hw[bus].raw_intr_stat |= I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+    }
+}
+
+// O bloco foi desligado (troca de endereço, de clock ou escrita do SDK): o que ainda estava na
+// FIFO é descartado, e a transação em curso chega ao display cortada. Com o barramento preso o
+// descarte é a própria recuperação, e não conta
+static void sim_i2c_descartar(uint bus) {
+    sim_i2c_fifo_t *f = &sim_i2c_fifo[bus];
+    sim_i2c_esvaziar(bus);
+    if (!f->cheia) {
+        return;
+    }
+    f->cheia = false;
+    sim_i2c_entregar(bus, f->tar, f->palavras, f->corte);
+    if (sim_agora < sim_i2c_preso_desde) {
+        sim_i2c_descartados[bus] += (uint32_t)(f->n - f->corte);
+    }
+    sim_i2c_hw[bus].status = I2C_IC_STATUS_TFE_BITS;
+}
+
+// Fim da FIFO no instante previsto; a interrupção de STOP dispara se estiver desmascarada (a
+// leitura de clr_stop_det não tem efeito no modelo: o evento dispara uma vez por fluxo)
+static bool sim_i2c_fifo_evento(const sim_evento_t *ev) {
+    uint bus = (uint)ev->valor;
+    sim_i2c_esvaziar(bus);
+    if (sim_i2c_hw[bus].raw_intr_stat & sim_i2c_hw[bus].intr_mask & I2C_IC_RAW_INTR_STAT_STOP_DET_BITS) {
+        sim_disparar_irq(I2C0_IRQ + bus);
+        return true;
+    }
+    return false;
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+    i2c->hw->enable = 1;
+    return i2c_set_baudrate(i2c, baudrate);
+}
+
+// A leitura de clr_tx_abrt não tem efeito no modelo: o aborto é limpo ao reconfigurar o bloco
+void i2c_deinit(i2c_inst_t *i2c) {
+    sim_i2c_descartar(i2c_get_index(i2c));
+    i2c->hw->enable = 0;
+    i2c->hw->raw_intr_stat = 0;
+    i2c->hw->status = I2C_IC_STATUS_TFE_BITS;
+}
+
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate) {
+    sim_i2c_descartar(i2c_get_index(i2c));
+    sim_baudrate[i2c_get_index(i2c)] = baudrate;
+    i2c->hw->raw_intr_stat = 0;
+    return baudrate;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    (void)nostop;
+    uint bus = i2c_get_index(i2c);
+    sim_i2c_descartar(bus); // O SDK desliga o bloco para trocar o endereço
+    sim_transacao(bus, addr, src, len);
+    sim_avancar_ate(sim_agora + sim_tempo_barramento(bus, 1, len));
+    return (int)len;
+}
+
+// Falhas do barramento I2C no cenário:
+// - display ausente até um instante (--display-ausente): o endereço leva NAK
+// - fiação que não sustenta mais que um clock a partir de um instante (--i2c-max-khz): acima
+//   dele as transações terminam em NAK e o DMA, em aborto
+// - SDA preso em nível baixo por um escravo a partir de um instante (--i2c-preso): nenhuma
+//   transação termina até a liberação por ssd1306_bus_clear_pulses pulsos de SCL
+#define SIM_PULSOS_LIBERACAO 9
+
+static uint64_t sim_i2c_ausente_ate = 0;
+static uint32_t sim_i2c_max_hz = 0;
+static uint64_t sim_i2c_limite_desde = 0;
+static uint64_t sim_i2c_preso_desde = UINT64_MAX;
+static uint64_t sim_i2c_liberado_em = 0;
+static uint32_t sim_i2c_pulsos = 0;
+
+void sim_display_ausente(uint64_t ate_us) {
+    sim_i2c_ausente_ate = ate_us;
+}
+
+void sim_limitar_i2c(uint32_t max_khz, uint64_t desde_us) {
+    sim_i2c_max_hz = max_khz * 1000;
+    sim_i2c_limite_desde = desde_us;
+}
+
+void sim_prender_i2c(uint64_t desde_us) {
+    sim_i2c_preso_desde = desde_us;
+}
+
+static bool sim_i2c_preso(void) {
+    return sim_agora >= sim_i2c_preso_desde && sim_i2c_liberado_em == 0;
+}
+
+static bool sim_i2c_acima_do_limite(uint bus) {
+    return sim_i2c_max_hz && sim_agora >= sim_i2c_limite_desde && sim_baudrate[bus] > sim_i2c_max_hz;
+}
+
+// Pinos pares do bloco (GPIO % 4 == 0 ou 2) são SDA; os ímpares, SCL
+static bool sim_i2c_sda_presa(uint gpio) {
+    return sim_pino_i2c[gpio] && gpio % 2 == 0 && sim_i2c_preso();
+}
+
+// Cada vez que o SCL é puxado para baixo por GPIO (dreno aberto), o escravo preso avança um bit
+static void sim_i2c_pulso_scl(uint gpio) {
+    if (sim_pino_i2c[gpio] && gpio % 2 == 1 && sim_funcao[gpio] == GPIO_FUNC_SIO && sim_i2c_preso() &&
+        ++sim_i2c_pulsos == SIM_PULSOS_LIBERACAO) {
+        sim_i2c_liberado_em = sim_agora;
+    }
+}
+
+// Como no SDK: NAK encerra a transação com erro genérico depois de START, endereço e STOP; com
+// o SDA preso, a escrita só termina no prazo
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us) {
+    uint bus = i2c_get_index(i2c);
+    sim_i2c_descartar(bus);
+    if (sim_i2c_preso()) {
+        sim_avancar_ate(sim_agora + timeout_us);
+        return PICO_ERROR_TIMEOUT;
+    }
+    if (sim_agora < sim_i2c_ausente_ate || sim_i2c_acima_do_limite(bus)) {
+        sim_avancar_ate(sim_agora + sim_tempo_barramento(bus, 1, 0));
+        return PICO_ERROR_GENERIC;
+    }
+    return i2c_write_blocking(i2c, addr, src, len, nostop);
+}
+
+// ---------------------------------------------------------------------------------------------
+// SPI: cada escrita é uma transação do display no barramento 2 + índice, "endereçada" pelo pino
+// D/C# (--spi-dc); o nível do pino no início da escrita decide entre comandos e dados
+
+spi_hw_t sim_spi_hw[2];
+static uint sim_spi_baudrate[2] = {1000000, 1000000};
+static int sim_spi_dc[2] = {-1, -1};
+
+void sim_definir_spi_dc(uint spi, uint gpio) {
+    sim_spi_dc[spi & 1] = (int)gpio;
+}
+
+// 8 bits por byte, sem intervalo entre bytes (a FIFO mantém o SPI ocupado)
+static uint64_t sim_tempo_spi(uint spi, size_t bytes) {
+    return ((uint64_t)bytes * 8 * 1000000 + sim_spi_baudrate[spi] - 1) / sim_spi_baudrate[spi];
+}
+
+// Entrega os bytes ao modelo do display com o byte de controle do I2C equivalente ao D/C#
+static void sim_spi_transacao(uint spi, const uint8_t *bytes, size_t n) {
+    if (sim_spi_dc[spi] < 0 || n == 0) {
+        return;
+    }
+
+    static uint8_t transacao[2049];
+    size_t total = n < sizeof(transacao) - 1 ? n : sizeof(transacao) - 1;
+    transacao[0] = sim_nivel[sim_spi_dc[spi]] ? 0x40 : 0x00;
+    memcpy(transacao + 1, bytes, total);
+    sim_transacao(2 + spi, (uint8_t)sim_spi_dc[spi], transacao, total + 1);
+}
+
+uint spi_init(spi_inst_t *spi, uint baudrate) {
+    spi_get_hw(spi)->sr = 0;
+    return spi_set_baudrate(spi, baudrate);
+}
+
+// Mesmos divisores do SDK: prescale par e postdiv sobre o clk_peri, arredondando para baixo
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate) {
+    uint freq_in = clock_get_hz(clk_peri);
+    uint prescale, postdiv;
+    for (prescale = 2; prescale <= 254; prescale += 2) {
+        if (freq_in < (prescale + 2) * 256 * (uint64_t)baudrate) {
+            break;
+        }
+    }
+    for (postdiv = 256; postdiv > 1; --postdiv) {
+        if (freq_in / (prescale * (postdiv - 1)) > baudrate) {
+            break;
+        }
+    }
+    sim_spi_baudrate[spi_get_index(spi)] = freq_in / (prescale * postdiv);
+    return sim_spi_baudrate[spi_get_index(spi)];
+}
+
+uint spi_get_baudrate(const spi_inst_t *spi) {
+    return sim_spi_baudrate[spi_get_index(spi)];
+}
+
+void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order) {
+    (void)spi;
+    (void)data_bits;
+    (void)cpol;
+    (void)cpha;
+    (void)order;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    uint indice = spi_get_index(spi);
+    sim_spi_transacao(indice, src, len);
+    sim_avancar_ate(sim_agora + sim_tempo_spi(indice, len));
+    return (int)len;
+}
+
+// ---------------------------------------------------------------------------------------------
+// DMA: transferências de palavras de 16 bits para o data_cmd do I2C ou para o DR do SPI
+
+typedef struct {
+    bool reservado;
+    volatile void *destino;
+    bool ocupado;
+    bool irq0_habilitada;
+    bool irq0_status;
+    uint32_t geracao;
+} sim_dma_t;
+
+static sim_dma_t sim_dma[SIM_MAX_DMA];
+
+int dma_claim_unused_channel(bool required) {
+    for (int i = 0; i < SIM_MAX_DMA; i++) {
+        if (!sim_dma[i].reservado) {
+            sim_dma[i].reservado = true;
+            return i;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "sim: sem canais de DMA livres\n");
+        exit(2);
+    }
+    return -1;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    (void)channel;
+    return (dma_channel_config){0};
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    c->ctrl = (c->ctrl & ~3u) | size;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    (void)c;
+    (void)incr;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    (void)c;
+    (void)incr;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    (void)c;
+    (void)dreq;
+}
+
+// Anel de leitura (ou escrita) de 2^size_bits bytes, nos mesmos bits do CTRL do RP2040
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) {
+    c->ctrl = (c->ctrl & ~0x7c0u) | (size_bits & 0xfu) << 6 | (write ? 1u : 0u) << 10;
+}
+
+static bool sim_pio_ligar_dma(uint canal, uint32_t ctrl, volatile void *destino, const volatile void *origem,
+                              uint32_t quantidade);
+static void sim_pio_desligar_dma(uint canal);
+
+// Destino no TX FIFO de uma máquina de estados: a máquina passa a ler do buffer, no ritmo do DREQ;
+// os demais destinos são o I2C
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger) {
+    if (trigger && sim_pio_ligar_dma(channel, config->ctrl, write_addr, read_addr, transfer_count)) {
+        return;
+    }
+    sim_dma[channel].destino = write_addr;
+    if (trigger) {
+        dma_channel_transfer_from_buffer_now(channel, read_addr, transfer_count);
+    }
+}
+
+// Transferência para o DR do SPI: os bytes baixos das palavras, como o SPI de 8 bits os envia
+static void sim_dma_spi(sim_dma_t *ch, uint spi, const volatile void *read_addr, uint32_t transfer_count) {
+    const volatile uint16_t *palavras = read_addr;
+    static uint8_t bytes[2048];
+    size_t n = transfer_count < sizeof(bytes) ? transfer_count : sizeof(bytes);
+    for (size_t i = 0; i < n; i++) {
+        bytes[i] = (uint8_t)palavras[i];
+    }
+    sim_spi_transacao(spi, bytes, n);
+
+    ch->ocupado = true;
+    ch->geracao++;
+    sim_spi_hw[spi].sr = SPI_SSPSR_BSY_BITS;
+    sim_agendar(sim_agora + sim_tempo_spi(spi, transfer_count), SIM_EV_DMA_FIM, ch, (int32_t)ch->geracao, 2 + spi);
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count) {
+    sim_dma_t *ch = &sim_dma[channel];
+    for (uint spi = 0; spi < 2; spi++) {
+        if (ch->destino == &sim_spi_hw[spi].dr) {
+            sim_dma_spi(ch, spi, read_addr, transfer_count);
+            return;
+        }
+    }
+    uint bus = ch->destino == &sim_i2c_hw[1].data_cmd ? 1 : 0;
+    i2c_hw_t *hw = &sim_i2c_hw[bus];
+    const volatile uint16_t *palavras = read_addr;
+
+    sim_i2c_descartar(bus); // O driver desliga o bloco para trocar o endereço
+    ch->ocupado = true;
+    ch->geracao++;
+    hw->raw_intr_stat = 0;
+    hw->status = I2C_IC_STATUS_MST_ACTIVITY_BITS;
+    if (sim_i2c_preso()) {
+        return; // A FIFO não esvazia: o DMA para sem fim
+    }
+    if (sim_i2c_acima_do_limite(bus)) {
+        // NAK logo no início: a FIFO é descartada, e o DMA termina escrevendo no vazio
+        hw->raw_intr_stat = I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+        sim_agendar(sim_agora + sim_tempo_barramento(bus, 1, 0), SIM_EV_DMA_FIM, ch, (int32_t)ch->geracao, bus);
+        return;
+    }
+
+    // As transações que terminam antes das últimas SIM_I2C_FIFO palavras saem já; as demais
+    // ficam na FIFO, que só esvazia depois do fim do DMA
+    sim_i2c_fifo_t *f = &sim_i2c_fifo[bus];
+    const uint32_t cauda = transfer_count - (transfer_count < SIM_I2C_FIFO ? transfer_count : SIM_I2C_FIFO);
+    size_t inicio = 0, transacoes = 0, transacoes_cauda = 0;
+    for (uint32_t i = 0; i < transfer_count; i++) {
+        if (palavras[i] & I2C_IC_DATA_CMD_STOP_BITS || i == transfer_count - 1) {
+            transacoes++;
+            transacoes_cauda += i >= cauda;
+            if (i < cauda) {
+                inicio = i + 1;
+            }
+        }
+    }
+
+    f->cheia = transfer_count > 0;
+    f->tar = (uint8_t)hw->tar;
+    f->n = 0;
+    for (uint32_t i = (uint32_t)inicio; i < transfer_count && f->n < count_of(f->palavras); i++) {
+        f->palavras[f->n++] = palavras[i];
+    }
+    f->corte = cauda - inicio;
+    static uint16_t enviadas[4096];
+    size_t n_enviadas = 0;
+    for (size_t i = 0; i < inicio && n_enviadas < count_of(enviadas); i++) {
+        enviadas[n_enviadas++] = palavras[i];
+    }
+    sim_i2c_entregar(bus, f->tar, enviadas, n_enviadas);
+
+    const uint64_t total = sim_tempo_barramento(bus, transacoes, transfer_count);
+    const uint64_t na_fifo = sim_tempo_barramento(bus, transacoes_cauda, transfer_count - cauda);
+    f->fim = sim_agora + total;
+    sim_agendar(f->fim - na_fifo, SIM_EV_DMA_FIM, ch, (int32_t)ch->geracao, bus);
+    sim_agendar(f->fim, SIM_EV_I2C_FIFO, NULL, 0, bus);
+}
+
+bool dma_channel_is_busy(uint channel) {
+    return sim_dma[channel].ocupado;
+}
+
+void dma_channel_abort(uint channel) {
+    sim_pio_desligar_dma(channel);
+    sim_dma[channel].ocupado = false;
+    sim_dma[channel].geracao++;
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+    sim_dma[channel].irq0_habilitada = enabled;
+}
+
+bool dma_channel_get_irq0_status(uint channel) {
+    return sim_dma[channel].irq0_status;
+}
+
+void dma_channel_acknowledge_irq0(uint channel) {
+    sim_dma[channel].irq0_status = false;
+}
+
+static bool sim_dma_fim(const sim_evento_t *ev) {
+    sim_dma_t *ch = ev->ptr;
+    if (!ch->ocupado || ch->geracao != (uint32_t)ev->id || (ev->valor < 2 && sim_i2c_preso())) {
+        return false; // Cancelado, ou o SDA prendeu no meio do fluxo
+    }
+
+    ch->ocupado = false;
+    if (ev->valor >= 2) {
+        sim_spi_hw[ev->valor - 2].sr = 0;
+    } else if (!sim_i2c_fifo[ev->valor].cheia) {
+        sim_i2c_hw[ev->valor].status = I2C_IC_STATUS_TFE_BITS; // NAK: a FIFO já foi descartada
+    }
+    if (ch->irq0_habilitada) {
+        ch->irq0_status = true;
+        sim_disparar_irq(DMA_IRQ_0);
+        return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Laço de eventos: despacha o que vence até o instante alvo, como interrupções do core0
+
+static void sim_encerrar(void);
+static bool sim_serial(const sim_evento_t *ev);
+static bool sim_pio_evento(const sim_evento_t *ev);
+
+// Retorna se alguma interrupção do firmware de fato rodou
+static bool sim_despachar(const sim_evento_t *ev) {
+    switch (ev->tipo) {
+        case SIM_EV_ALARME:
+            return sim_alarme(ev);
+        case SIM_EV_ALARME_UNICO:
+            return sim_alarme_unico(ev);
+        case SIM_EV_ALARME_HW:
+            return sim_alarme_hw(ev);
+        case SIM_EV_PINO:
+            return sim_mudar_entrada((uint)ev->id, ev->valor);
+        case SIM_EV_PEDESTRE: {
+            sim_pedestre_t *p = ev->ptr;
+            sim_agendar_aperto(ev->instante, p->gpio, 150, 2);
+            sim_proximo_pedestre(p, (uint64_t)(ev->valor + 1) * p->periodo_ms * 1000);
+            return false;
+        }
+        case SIM_EV_DMA_FIM:
+            return sim_dma_fim(ev);
+        case SIM_EV_I2C_FIFO:
+            return sim_i2c_fifo_evento(ev);
+        case SIM_EV_SERIAL:
+            return sim_serial(ev);
+        case SIM_EV_PIO:
+            return sim_pio_evento(ev);
+        case SIM_EV_CORE1:
+            return false; // Só marca o fim do sono do core1 (sim_ocioso o retoma)
+    }
+    return false;
+}
+
+static void sim_avancar_ate(uint64_t alvo) {
+    while (sim_mascara == 0 && !sim_em_irq && sim_n_eventos > 0 && sim_eventos[0].instante <= alvo) {
+        if (sim_eventos[0].instante >= sim_fim) {
+            break;
+        }
+        sim_evento_t ev = sim_retirar();
+        if (ev.instante > sim_agora) {
+            sim_verificar_aceso();
+            sim_agora = ev.instante;
+        }
+
+        sim_em_irq = true;
+        if (sim_despachar(&ev)) {
+            sim_agora += sim_custo_irq_us;
+        }
+        sim_em_irq = false;
+    }
+
+    if (alvo > sim_agora) {
+        sim_verificar_aceso();
+        sim_agora = alvo < sim_fim ? alvo : sim_fim;
+    }
+    for (uint bus = 0; bus < 2; bus++) {
+        sim_i2c_esvaziar(bus); // Dentro de uma interrupção o evento da FIFO não é despachado
+    }
+    if (sim_agora >= sim_fim) {
+        sim_encerrar();
+    }
+}
+
+static void sim_core1_dormir(uint64_t alvo);
+
+void sleep_us(uint64_t us) {
+    if (sim_no_core1) {
+        sim_core1_dormir(sim_agora + us);
+        return;
+    }
+    sim_avancar_ate(sim_agora + us);
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000);
+}
+
+void busy_wait_us(uint64_t us) {
+    sim_avancar_ate(sim_agora + us);
+}
+
+bool stdio_init_all(void) {
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------
+// USB CDC: o texto do roteiro chega de uma vez e avisa o firmware pelo callback do stdio
+
+static char sim_serial_buffer[SIM_SERIAL_BUFFER];
+static size_t sim_serial_inicio = 0, sim_serial_fim = 0;
+static void (*sim_serial_callback)(void *) = NULL;
+static void *sim_serial_param = NULL;
+
+void sim_agendar_serial(uint64_t instante_us, const char *texto) {
+    sim_agendar(instante_us, SIM_EV_SERIAL, (void *)texto, 0, 0);
+}
+
+static bool sim_serial(const sim_evento_t *ev) {
+    for (const char *c = ev->ptr; *c != '\0' && sim_serial_fim < SIM_SERIAL_BUFFER; c++) {
+        sim_serial_buffer[sim_serial_fim++] = *c;
+    }
+    if (sim_serial_callback == NULL) {
+        return false;
+    }
+    sim_serial_callback(sim_serial_param);
+    return true;
+}
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    if (sim_serial_inicio == sim_serial_fim) {
+        sim_serial_inicio = sim_serial_fim = 0;
+        return PICO_ERROR_TIMEOUT;
+    }
+    return (unsigned char)sim_serial_buffer[sim_serial_inicio++];
+}
+
+int putchar_raw(int c) {
+    return putchar(c);
+}
+
+void stdio_flush(void) {
+    fflush(stdout);
+}
+
+void stdio_set_chars_available_callback(void (*fn)(void *), void *param) {
+    sim_serial_callback = fn;
+    sim_serial_param = param;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Core1 como corrotina: roda quando o core0 fica ocioso ou bloqueia, e devolve o controle
+// quando ele próprio fica ocioso ou bloqueia na FIFO
+
+typedef enum {
+    SIM_CORE1_PARADO,
+    SIM_CORE1_PRONTO,
+    SIM_CORE1_BLOQUEADO,
+    SIM_CORE1_OCIOSO,
+    SIM_CORE1_TERMINADO,
+} sim_core1_estado_t;
+
+static ucontext_t sim_ctx_core0, sim_ctx_core1;
+static void (*sim_core1_entrada)(void) = NULL;
+static sim_core1_estado_t sim_core1 = SIM_CORE1_PARADO;
+static bool sim_no_core1 = false;
+
+typedef struct {
+    uint32_t dados[SIM_FIFO_PROFUNDIDADE];
+    int inicio, quantidade;
+} sim_fifo_t;
+
+static sim_fifo_t sim_fifo_para_core1, sim_fifo_para_core0;
+
+static void sim_core1_trampolim(void) {
+    sim_core1_entrada();
+    sim_core1 = SIM_CORE1_TERMINADO;
+    swapcontext(&sim_ctx_core1, &sim_ctx_core0);
+}
+
+static void sim_rodar_core1(void) {
+    sim_no_core1 = true;
+    sim_core1 = SIM_CORE1_PRONTO;
+    swapcontext(&sim_ctx_core0, &sim_ctx_core1);
+    sim_no_core1 = false;
+}
+
+static void sim_ceder_core0(sim_core1_estado_t estado) {
+    sim_core1 = estado;
+    swapcontext(&sim_ctx_core1, &sim_ctx_core0);
+}
+
+// O sono do core1 cede a vez ao core0 até um evento de despertar: sem isso, uma espera longa
+// do core1 avançaria o relógio com o laço do core0 parado
+static void sim_core1_dormir(uint64_t alvo) {
+    sim_agendar(alvo, SIM_EV_CORE1, NULL, 0, 0);
+    while (sim_agora < alvo) {
+        sim_ceder_core0(SIM_CORE1_OCIOSO);
+    }
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+    static uint8_t *pilha = NULL;
+    if (pilha == NULL) {
+        pilha = malloc(SIM_PILHA_CORE1);
+    }
+
+    sim_core1_entrada = entry;
+    getcontext(&sim_ctx_core1);
+    sim_ctx_core1.uc_stack.ss_sp = pilha;
+    sim_ctx_core1.uc_stack.ss_size = SIM_PILHA_CORE1;
+    sim_ctx_core1.uc_link = NULL;
+    makecontext(&sim_ctx_core1, sim_core1_trampolim, 0);
+    sim_rodar_core1();
+}
+
+// ---------------------------------------------------------------------------------------------
+// Clocks: as frequências só são guardadas; o relógio virtual não depende delas, mas as
+// máquinas de estados da PIO andam no ritmo do clk_sys
+
+static uint32_t sim_clocks_hz[CLK_COUNT] = {[clk_ref] = 12 * MHZ, [clk_sys] = 125 * MHZ,
+                                           [clk_peri] = 125 * MHZ, [clk_usb] = 48 * MHZ};
+
+bool clock_configure(enum clock_index clk_index, uint32_t src, uint32_t auxsrc, uint32_t src_freq, uint32_t freq) {
+    if (freq > src_freq) {
+        return false;
+    }
+    sim_pio_sincronizar_todas();
+    sim_clocks_hz[clk_index] = freq;
+    sim_pio_prever_todas();
+    return true;
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    return sim_clocks_hz[clk_index];
+}
+
+// ---------------------------------------------------------------------------------------------
+// PIO: interpretador das instruções de cada máquina de estados. A máquina só roda até o instante
+// atual; uma cópia dela roda à frente, com as entradas como estão, para agendar o próximo PUSH
+// no ciclo exato em que ele acontece. Mudanças de entrada e de clock sincronizam e refazem a
+// previsão (cada máquina tem no máximo um evento pendente). A interrupção de RX FIFO não vazio
+// é por nível, como no hardware. Máquinas sem interrupção habilitada não agendam nada: suas
+// saídas são escritas, no instante de cada ciclo, quando elas sincronizam.
+
+#define SIM_PIO_FIFO 4
+#define SIM_PIO_PREVISAO_PS 100000000000ull // 100 ms à frente por previsão
+#define SIM_PIO_PS_POR_US 1000000ull
+
+typedef struct sim_pio sim_pio_t;
+
+typedef struct {
+    sim_pio_t *pio;
+    uint indice;
+    bool usada, habilitada;
+    uint8_t pc, wrap_inicio, wrap_fim;
+    uint32_t x, y, isr, osr;
+    uint32_t tx[SIM_PIO_FIFO], rx[SIM_PIO_FIFO];
+    uint8_t n_tx, n_rx;
+    uint in_base, out_base, out_count, jmp_pino;
+    float divisor;
+    uint64_t proximo_ps; // Instante do próximo ciclo
+    // DMA que alimenta o TX FIFO; a posição fica na máquina, para a cópia de previsão não
+    // avançar o canal de verdade
+    bool dma_ligado;
+    uint dma_canal;
+    const volatile uint32_t *dma_base;
+    uint32_t dma_anel; // Palavras no anel de leitura (0 = sem anel)
+    uint32_t dma_posicao;
+    uint32_t dma_restantes;
+} sim_pio_sm_t;
+
+struct sim_pio {
+    uint indice;
+    uint16_t memoria[PIO_INSTRUCTION_COUNT];
+    uint32_t ocupadas; // Bit por posição da memória de instruções
+    uint32_t fontes_irq0;
+    uint32_t pindirs;  // Pinos com saída habilitada pela PIO
+    sim_pio_sm_t sm[NUM_PIO_STATE_MACHINES];
+};
+
+pio_hw_t sim_pio_hw[NUM_PIOS];
+static sim_pio_t sim_pios[NUM_PIOS] = {{.indice = 0}, {.indice = 1}};
+
+static sim_pio_t *sim_pio_de(PIO pio) {
+    return &sim_pios[pio - sim_pio_hw];
+}
+
+static uint sim_pio_irq(const sim_pio_t *p) {
+    return PIO0_IRQ_0 + 2 * p->indice;
+}
+
+typedef enum {
+    SIM_PIO_SEGUIU,
+    SIM_PIO_TRAVOU,      // WAIT não satisfeito ou FIFO bloqueante: só uma entrada a libera
+    SIM_PIO_PUSH_ADIADO, // A cópia de previsão chegou a um PUSH
+} sim_pio_passo_t;
+
+static void sim_pio_nao_suportada(uint16_t instrucao) {
+    fprintf(stderr, "sim: instrução PIO 0x%04x não suportada\n", instrucao);
+    exit(2);
+}
+
+static bool sim_pio_pino(uint gpio) {
+    return gpio < SIM_MAX_GPIO && sim_nivel[gpio];
+}
+
+static uint8_t sim_pio_seguinte(const sim_pio_sm_t *sm) {
+    return sm->pc == sm->wrap_fim ? sm->wrap_inicio : (uint8_t)((sm->pc + 1) % PIO_INSTRUCTION_COUNT);
+}
+
+static uint32_t sim_pio_fonte(const sim_pio_sm_t *sm, uint fonte, uint16_t instrucao) {
+    switch (fonte) {
+        case pio_pins: {
+            uint32_t valor = 0;
+            for (uint i = 0; i < 32; i++) {
+                valor |= (uint32_t)sim_pio_pino((sm->in_base + i) % 32) << i;
+            }
+            return valor;
+        }
+        case pio_x:
+            return sm->x;
+        case pio_y:
+            return sm->y;
+        case pio_null:
+            return 0;
+        case pio_isr:
+            return sm->isr;
+        case pio_osr:
+            return sm->osr;
+    }
+    sim_pio_nao_suportada(instrucao);
+    return 0;
+}
+
+static uint32_t sim_pio_inverter_bits(uint32_t v) {
+    uint32_t r = 0;
+    for (int i = 0; i < 32; i++) {
+        r |= ((v >> i) & 1u) << (31 - i);
+    }
+    return r;
+}
+
+// Escreve nos pinos de saída da máquina: só mudam os pinos entregues a esta PIO (pio_gpio_init)
+// com direção de saída. A cópia de previsão não escreve.
+static void sim_pio_escrever_pinos(const sim_pio_sm_t *sm, uint32_t valor, bool efeitos) {
+    if (!efeitos) {
+        return;
+    }
+    gpio_function_t funcao = sm->pio->indice ? GPIO_FUNC_PIO1 : GPIO_FUNC_PIO0;
+    uint64_t instante = sm->proximo_ps / SIM_PIO_PS_POR_US;
+    for (uint i = 0; i < sm->out_count; i++) {
+        uint gpio = (sm->out_base + i) % 32;
+        if (gpio < SIM_MAX_GPIO && sim_funcao[gpio] == funcao && (sm->pio->pindirs >> gpio & 1u)) {
+            sim_saida_pio(gpio, valor >> i & 1u, instante);
+        }
+    }
+}
+
+// Com o DMA ligado, o TX FIFO nunca fica vazio enquanto houver transferências: equivale a
+// entregar a próxima palavra do buffer quando a máquina a pede
+static void sim_pio_puxar_dma(sim_pio_sm_t *sm) {
+    if (!sm->dma_ligado || sm->dma_restantes == 0) {
+        return;
+    }
+    sm->tx[sm->n_tx++] = sm->dma_base[sm->dma_posicao];
+    sm->dma_posicao = sm->dma_anel ? (sm->dma_posicao + 1) % sm->dma_anel : sm->dma_posicao + 1;
+    sm->dma_restantes--;
+}
+
+// Executa uma instrução; sem efeitos (cópia de previsão), para antes de um PUSH
+static sim_pio_passo_t sim_pio_executar(sim_pio_sm_t *sm, uint16_t instrucao, uint8_t proximo, bool efeitos) {
+    uint operando = instrucao >> 5 & 7u, indice = instrucao & 0x1fu;
+
+    switch (instrucao & 0xe000) {
+        case pio_instr_bits_jmp: {
+            bool salta = false;
+            switch (operando) {
+                case 0: salta = true; break;
+                case 1: salta = sm->x == 0; break;
+                case 2: salta = sm->x-- != 0; break;
+                case 3: salta = sm->y == 0; break;
+                case 4: salta = sm->y-- != 0; break;
+                case 5: salta = sm->x != sm->y; break;
+                case 6: salta = sim_pio_pino(sm->jmp_pino); break;
+                default: sim_pio_nao_suportada(instrucao);
+            }
+            if (salta) {
+                proximo = (uint8_t)indice;
+            }
+            break;
+        }
+        case pio_instr_bits_wait: {
+            bool polaridade = operando & 4u, nivel = false;
+            if ((operando & 3u) == 0) {
+                nivel = sim_pio_pino(indice);
+            } else if ((operando & 3u) == 1) {
+                nivel = sim_pio_pino((sm->in_base + indice) % 32);
+            } else {
+                sim_pio_nao_suportada(instrucao);
+            }
+            if (nivel != polaridade) {
+                return SIM_PIO_TRAVOU;
+            }
+            break;
+        }
+        case pio_instr_bits_in: {
+            uint bits = indice ? indice : 32;
+            uint32_t valor = sim_pio_fonte(sm, operando, instrucao);
+            sm->isr = bits == 32 ? valor : (sm->isr >> bits) | (valor << (32 - bits)); // Desloca à direita
+            break;
+        }
+        case pio_instr_bits_out: {
+            uint bits = indice ? indice : 32;
+            uint32_t valor = bits == 32 ? sm->osr : sm->osr & ((1u << bits) - 1);
+            sm->osr = bits == 32 ? 0 : sm->osr >> bits; // Desloca à direita
+            switch (operando) {
+                case pio_pins: sim_pio_escrever_pinos(sm, valor, efeitos); break;
+                case pio_x: sm->x = valor; break;
+                case pio_y: sm->y = valor; break;
+                case pio_null: break;
+                case pio_pc: proximo = (uint8_t)(valor & 0x1fu); break;
+                case pio_isr: sm->isr = valor; break;
+                default: sim_pio_nao_suportada(instrucao);
+            }
+            break;
+        }
+        case pio_instr_bits_push: {
+            bool bloqueia = operando & 1u;
+            if (instrucao & 0x80) { // PULL
+                if (sm->n_tx == 0) {
+                    sim_pio_puxar_dma(sm);
+                }
+                if (sm->n_tx == 0) {
+                    if (bloqueia) {
+                        return SIM_PIO_TRAVOU;
+                    }
+                    sm->osr = sm->x;
+                } else {
+                    sm->osr = sm->tx[0];
+                    memmove(sm->tx, sm->tx + 1, --sm->n_tx * sizeof(sm->tx[0]));
+                }
+                break;
+            }
+            if (!efeitos) {
+                return SIM_PIO_PUSH_ADIADO;
+            }
+            if (sm->n_rx == SIM_PIO_FIFO) {
+                if (bloqueia) {
+                    return SIM_PIO_TRAVOU;
+                }
+            } else {
+                sm->rx[sm->n_rx++] = sm->isr;
+            }
+            sm->isr = 0;
+            break;
+        }
+        case pio_instr_bits_mov: {
+            uint32_t valor = sim_pio_fonte(sm, instrucao & 7u, instrucao);
+            if ((instrucao >> 3 & 3u) == 1) {
+                valor = ~valor;
+            } else if ((instrucao >> 3 & 3u) == 2) {
+                valor = sim_pio_inverter_bits(valor);
+            }
+            switch (operando) {
+                case pio_pins: sim_pio_escrever_pinos(sm, valor, efeitos); break;
+                case pio_x: sm->x = valor; break;
+                case pio_y: sm->y = valor; break;
+                case pio_pc: proximo = (uint8_t)(valor & 0x1fu); break;
+                case pio_isr: sm->isr = valor; break;
+                case pio_osr: sm->osr = valor; break;
+                default: sim_pio_nao_suportada(instrucao);
+            }
+            break;
+        }
+        case pio_instr_bits_set:
+            if (operando == pio_x) {
+                sm->x = indice;
+            } else if (operando == pio_y) {
+                sm->y = indice;
+            } else {
+                sim_pio_nao_suportada(instrucao);
+            }
+            break;
+        default:
+            sim_pio_nao_suportada(instrucao);
+    }
+
+    sm->pc = proximo;
+    return SIM_PIO_SEGUIU;
+}
+
+static uint64_t sim_pio_ciclo_ps(const sim_pio_sm_t *sm) {
+    return (uint64_t)((double)sm->divisor * 1e12 / sim_clocks_hz[clk_sys]);
+}
+
+// "jmp x-- ." (ou y--) sem atraso é um laço de espera: avança todas as voltas que cabem até o
+// limite de uma vez, em vez de ciclo a ciclo
+static bool sim_pio_pular_laco(sim_pio_sm_t *sm, uint16_t instrucao, uint64_t limite_ps, uint64_t ciclo) {
+    uint condicao = instrucao >> 5 & 7u;
+    if ((instrucao & 0xff00) != pio_instr_bits_jmp || (instrucao & 0x1fu) != sm->pc ||
+        (condicao != 2 && condicao != 4)) {
+        return false;
+    }
+
+    uint32_t *contador = condicao == 2 ? &sm->x : &sm->y;
+    uint64_t voltas = (limite_ps - sm->proximo_ps) / ciclo + 1;
+    if ((uint64_t)*contador + 1 <= voltas) {
+        sm->proximo_ps += ((uint64_t)*contador + 1) * ciclo; // Sai do laço com o contador em ~0
+        *contador = UINT32_MAX;
+        sm->pc = sim_pio_seguinte(sm);
+    } else {
+        *contador -= (uint32_t)voltas;
+        sm->proximo_ps += voltas * ciclo;
+    }
+    return true;
+}
+
+// Executa os ciclos da máquina até o instante limite (inclusive)
+static sim_pio_passo_t sim_pio_rodar(sim_pio_sm_t *sm, uint64_t limite_ps, bool efeitos) {
+    uint64_t ciclo = sim_pio_ciclo_ps(sm);
+    while (sm->proximo_ps <= limite_ps) {
+        uint16_t instrucao = sm->pio->memoria[sm->pc];
+        if (sim_pio_pular_laco(sm, instrucao, limite_ps, ciclo)) {
+            continue;
+        }
+        uint atraso = instrucao >> 8 & 0x1fu;
+        sim_pio_passo_t passo = sim_pio_executar(sm, instrucao, sim_pio_seguinte(sm), efeitos);
+        if (passo == SIM_PIO_PUSH_ADIADO) {
+            return passo;
+        }
+        if (passo == SIM_PIO_TRAVOU) {
+            // Nada muda até uma entrada mudar: pula para o primeiro ciclo depois do limite
+            sm->proximo_ps += ((limite_ps - sm->proximo_ps) / ciclo + 1) * ciclo;
+            return passo;
+        }
+        sm->proximo_ps += ciclo * (1 + atraso);
+    }
+    return SIM_PIO_SEGUIU;
+}
+
+static bool sim_pio_irq_pendente(const sim_pio_sm_t *sm) {
+    return sm->n_rx > 0 && (sm->pio->fontes_irq0 & (1u << sm->indice)) && sim_irq_habilitada[sim_pio_irq(sm->pio)];
+}
+
+static void sim_pio_sincronizar(sim_pio_sm_t *sm) {
+    if (sm->habilitada) {
+        sim_pio_rodar(sm, sim_agora * SIM_PIO_PS_POR_US, true);
+    }
+}
+
+// Agenda o próximo ponto de interesse da máquina: a interrupção pendente, o próximo PUSH ou,
+// se ela não travar nem empurrar dentro da janela, uma nova previsão no fim dela
+static void sim_pio_prever(sim_pio_sm_t *sm) {
+    sim_remover(SIM_EV_PIO, sm);
+    if (sim_pio_irq_pendente(sm)) {
+        sim_agendar(sim_agora, SIM_EV_PIO, sm, 0, 0);
+        return;
+    }
+    if (!sm->habilitada || !(sm->pio->fontes_irq0 & (1u << sm->indice))) {
+        return;
+    }
+
+    sim_pio_sm_t copia = *sm;
+    uint64_t limite_ps = sim_agora * SIM_PIO_PS_POR_US + SIM_PIO_PREVISAO_PS;
+    sim_pio_passo_t passo = sim_pio_rodar(&copia, limite_ps, false);
+    if (passo == SIM_PIO_PUSH_ADIADO) {
+        uint64_t instante = (copia.proximo_ps + SIM_PIO_PS_POR_US - 1) / SIM_PIO_PS_POR_US;
+        sim_agendar(instante, SIM_EV_PIO, sm, 0, 0);
+    } else if (passo == SIM_PIO_SEGUIU) {
+        sim_agendar(limite_ps / SIM_PIO_PS_POR_US, SIM_EV_PIO, sm, 0, 0);
+    }
+}
+
+static void sim_pio_sincronizar_todas(void) {
+    for (int p = 0; p < NUM_PIOS; p++) {
+        for (int i = 0; i < NUM_PIO_STATE_MACHINES; i++) {
+            sim_pio_sincronizar(&sim_pios[p].sm[i]);
+        }
+    }
+}
+
+static void sim_pio_prever_todas(void) {
+    for (int p = 0; p < NUM_PIOS; p++) {
+        for (int i = 0; i < NUM_PIO_STATE_MACHINES; i++) {
+            if (sim_pios[p].sm[i].habilitada) {
+                sim_pio_prever(&sim_pios[p].sm[i]);
+            }
+        }
+    }
+}
+
+static bool sim_pio_evento(const sim_evento_t *ev) {
+    sim_pio_sm_t *sm = ev->ptr;
+    sim_pio_sincronizar(sm);
+    bool rodou = sim_pio_irq_pendente(sm);
+    if (rodou) {
+        sim_disparar_irq(sim_pio_irq(sm->pio));
+    }
+    sim_pio_prever(sm);
+    return rodou;
+}
+
+// DMA com destino no TX FIFO de uma máquina; só leituras de 32 bits, com ou sem anel
+static bool sim_pio_ligar_dma(uint canal, uint32_t ctrl, volatile void *destino, const volatile void *origem,
+                              uint32_t quantidade) {
+    for (int p = 0; p < NUM_PIOS; p++) {
+        for (int i = 0; i < NUM_PIO_STATE_MACHINES; i++) {
+            if (destino != &sim_pio_hw[p].txf[i]) {
+                continue;
+            }
+            uint anel_bits = ctrl >> 6 & 0xfu;
+            if ((ctrl & 3u) != DMA_SIZE_32 || (anel_bits && (ctrl >> 10 & 1u))) {
+                fprintf(stderr, "sim: DMA para a PIO só com leituras de 32 bits\n");
+                exit(2);
+            }
+
+            sim_pio_sm_t *m = &sim_pios[p].sm[i];
+            sim_pio_sincronizar(m);
+            uintptr_t inicio = (uintptr_t)origem;
+            uintptr_t base = anel_bits ? inicio & ~(((uintptr_t)1 << anel_bits) - 1) : inicio;
+            m->dma_ligado = true;
+            m->dma_canal = canal;
+            m->dma_base = (const volatile uint32_t *)base;
+            m->dma_anel = anel_bits ? (1u << anel_bits) / 4 : 0;
+            m->dma_posicao = (uint32_t)(inicio - base) / 4;
+            m->dma_restantes = quantidade;
+            sim_pio_prever(m);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void sim_pio_desligar_dma(uint canal) {
+    for (int p = 0; p < NUM_PIOS; p++) {
+        for (int i = 0; i < NUM_PIO_STATE_MACHINES; i++) {
+            sim_pio_sm_t *m = &sim_pios[p].sm[i];
+            if (m->dma_ligado && m->dma_canal == canal) {
+                sim_pio_sincronizar(m);
+                m->dma_ligado = false;
+                sim_pio_prever(m);
+            }
+        }
+    }
+}
+
+uint pio_get_index(PIO pio) {
+    return sim_pio_de(pio)->indice;
+}
+
+uint pio_get_irq_num(PIO pio, uint irqn) {
+    return sim_pio_irq(sim_pio_de(pio)) + irqn;
+}
+
+// Mesma numeração de DREQ_PIO0_TX0.. do RP2040
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    return sim_pio_de(pio)->indice * 8 + (is_tx ? 0 : 4) + sm;
+}
+
+void pio_gpio_init(PIO pio, uint pin) {
+    gpio_set_function(pin, sim_pio_de(pio)->indice ? GPIO_FUNC_PIO1 : GPIO_FUNC_PIO0);
+}
+
+static int sim_pio_posicao_livre(const sim_pio_t *p, const pio_program_t *program) {
+    uint32_t mascara = program->length == 32 ? ~0u : (1u << program->length) - 1;
+    for (int offset = PIO_INSTRUCTION_COUNT - program->length; offset >= 0; offset--) {
+        if (!(p->ocupadas & (mascara << offset)) && (program->origin < 0 || program->origin == offset)) {
+            return offset;
+        }
+    }
+    return -1;
+}
+
+bool pio_can_add_program(PIO pio, const pio_program_t *program) {
+    return sim_pio_posicao_livre(sim_pio_de(pio), program) >= 0;
+}
+
+// Como no SDK, os JMPs são relocados para a posição onde o programa foi carregado
+int pio_add_program(PIO pio, const pio_program_t *program) {
+    sim_pio_t *p = sim_pio_de(pio);
+    int offset = sim_pio_posicao_livre(p, program);
+    if (offset < 0) {
+        return PICO_ERROR_GENERIC;
+    }
+    for (uint i = 0; i < program->length; i++) {
+        uint16_t instrucao = program->instructions[i];
+        p->memoria[offset + i] = (instrucao & 0xe000) == pio_instr_bits_jmp ? instrucao + offset : instrucao;
+        p->ocupadas |= 1u << (offset + i);
+    }
+    return offset;
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    sim_pio_t *p = sim_pio_de(pio);
+    for (int i = 0; i < NUM_PIO_STATE_MACHINES; i++) {
+        if (!p->sm[i].usada) {
+            p->sm[i].usada = true;
+            return i;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "sim: nenhuma máquina de estados livre na PIO %u\n", p->indice);
+        exit(2);
+    }
+    return -1;
+}
+
+void pio_sm_unclaim(PIO pio, uint sm) {
+    sim_pio_de(pio)->sm[sm].usada = false;
+}
+
+pio_sm_config pio_get_default_sm_config(void) {
+    return (pio_sm_config){.clkdiv = 1.0f, .wrap_target = 0, .wrap = PIO_INSTRUCTION_COUNT - 1};
+}
+
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base) {
+    c->in_base = in_base;
+}
+
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count) {
+    c->out_base = out_base;
+    c->out_count = out_count;
+}
+
+// O interpretador só desloca à direita e não tem autopull
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold) {
+    (void)c;
+    (void)pull_threshold;
+    if (!shift_right || autopull) {
+        fprintf(stderr, "sim: OUT só à direita e sem autopull\n");
+        exit(2);
+    }
+}
+
+void sm_config_set_jmp_pin(pio_sm_config *c, uint pin) {
+    c->jmp_pin = pin;
+}
+
+void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap) {
+    c->wrap_target = wrap_target;
+    c->wrap = wrap;
+}
+
+void sm_config_set_clkdiv(pio_sm_config *c, float div) {
+    c->clkdiv = div;
+}
+
+int pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config) {
+    sim_pio_t *p = sim_pio_de(pio);
+    sim_pio_sm_t *m = &p->sm[sm];
+    sim_remover(SIM_EV_PIO, m);
+    *m = (sim_pio_sm_t){
+        .pio = p, .indice = sm, .usada = m->usada, .pc = (uint8_t)initial_pc,
+        .wrap_inicio = (uint8_t)config->wrap_target, .wrap_fim = (uint8_t)config->wrap,
+        .in_base = config->in_base, .out_base = config->out_base, .out_count = config->out_count,
+        .jmp_pino = config->jmp_pin, .divisor = config->clkdiv,
+    };
+    return PICO_OK;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
+    sim_pio_sm_t *m = &sim_pio_de(pio)->sm[sm];
+    sim_pio_sincronizar(m);
+    if (enabled && !m->habilitada) {
+        m->proximo_ps = sim_agora * SIM_PIO_PS_POR_US;
+    }
+    m->habilitada = enabled;
+    sim_pio_prever(m);
+}
+
+void pio_sm_set_clkdiv(PIO pio, uint sm, float div) {
+    sim_pio_sm_t *m = &sim_pio_de(pio)->sm[sm];
+    sim_pio_sincronizar(m);
+    m->divisor = div;
+    sim_pio_prever(m);
+}
+
+void pio_sm_set_pindirs_with_mask(PIO pio, uint sm, uint32_t pin_dirs, uint32_t pin_mask) {
+    (void)sm;
+    sim_pio_t *p = sim_pio_de(pio);
+    p->pindirs = (p->pindirs & ~pin_mask) | (pin_dirs & pin_mask);
+}
+
+// Sem contadores de deslocamento nem atraso modelados, reiniciar só sincroniza a máquina
+void pio_sm_restart(PIO pio, uint sm) {
+    sim_pio_sincronizar(&sim_pio_de(pio)->sm[sm]);
+}
+
+void pio_sm_clear_fifos(PIO pio, uint sm) {
+    sim_pio_sm_t *m = &sim_pio_de(pio)->sm[sm];
+    sim_pio_sincronizar(m);
+    m->n_tx = m->n_rx = 0;
+    sim_pio_prever(m);
+}
+
+// Instrução executada agora, fora da memória de programa: só um salto muda o PC
+void pio_sm_exec(PIO pio, uint sm, uint instr) {
+    sim_pio_sm_t *m = &sim_pio_de(pio)->sm[sm];
+    sim_pio_sincronizar(m);
+    uint64_t proximo_ps = m->proximo_ps;
+    m->proximo_ps = sim_agora * SIM_PIO_PS_POR_US;
+    if (sim_pio_executar(m, (uint16_t)instr, m->pc, true) != SIM_PIO_SEGUIU) {
+        sim_pio_nao_suportada((uint16_t)instr);
+    }
+    m->proximo_ps = proximo_ps;
+    sim_pio_prever(m);
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) {
+    sim_pio_sm_t *m = &sim_pio_de(pio)->sm[sm];
+    sim_pio_sincronizar(m);
+    while (m->n_tx == SIM_PIO_FIFO) {
+        sim_ocioso();
+        sim_pio_sincronizar(m);
+    }
+    m->tx[m->n_tx++] = data;
+    sim_pio_prever(m);
+}
+
+uint32_t pio_sm_get(PIO pio, uint sm) {
+    sim_pio_sm_t *m = &sim_pio_de(pio)->sm[sm];
+    if (m->n_rx == 0) {
+        return 0;
+    }
+    uint32_t dado = m->rx[0];
+    memmove(m->rx, m->rx + 1, --m->n_rx * sizeof(m->rx[0]));
+    return dado;
+}
+
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) {
+    return sim_pio_de(pio)->sm[sm].n_rx == 0;
+}
+
+void pio_set_irq0_source_enabled(PIO pio, enum pio_interrupt_source source, bool enabled) {
+    sim_pio_t *p = sim_pio_de(pio);
+    p->fontes_irq0 = enabled ? p->fontes_irq0 | (1u << source) : p->fontes_irq0 & ~(1u << source);
+    sim_pio_prever(&p->sm[source]);
+}
+
+uint get_core_num(void) {
+    return sim_no_core1 ? 1 : 0;
+}
+
+static sim_fifo_t *sim_fifo_saida(void) {
+    return sim_no_core1 ? &sim_fifo_para_core0 : &sim_fifo_para_core1;
+}
+
+static sim_fifo_t *sim_fifo_entrada(void) {
+    return sim_no_core1 ? &sim_fifo_para_core1 : &sim_fifo_para_core0;
+}
+
+bool multicore_fifo_rvalid(void) {
+    return sim_fifo_entrada()->quantidade > 0;
+}
+
+bool multicore_fifo_wready(void) {
+    return sim_fifo_saida()->quantidade < SIM_FIFO_PROFUNDIDADE;
+}
+
+void multicore_fifo_push_blocking(uint32_t data) {
+    while (!multicore_fifo_wready()) {
+        sim_ocioso();
+    }
+
+    sim_fifo_t *f = sim_fifo_saida();
+    f->dados[(f->inicio + f->quantidade++) % SIM_FIFO_PROFUNDIDADE] = data;
+    if (!sim_no_core1 && sim_core1 == SIM_CORE1_BLOQUEADO) {
+        sim_core1 = SIM_CORE1_PRONTO;
+    }
+}
+
+uint32_t multicore_fifo_pop_blocking(void) {
+    while (!multicore_fifo_rvalid()) {
+        if (sim_no_core1) {
+            sim_ceder_core0(SIM_CORE1_BLOQUEADO);
+        } else {
+            sim_ocioso();
+        }
+    }
+
+    sim_fifo_t *f = sim_fifo_entrada();
+    uint32_t dado = f->dados[f->inicio];
+    f->inicio = (f->inicio + 1) % SIM_FIFO_PROFUNDIDADE;
+    f->quantidade--;
+    return dado;
+}
+
+// Ociosidade: o core1 devolve o controle; o core0 dá a vez ao core1 se ele tiver trabalho e,
+// senão, avança o relógio até o próximo evento
+void sim_ocioso(void) {
+    if (sim_no_core1) {
+        sim_ceder_core0(SIM_CORE1_OCIOSO);
+        return;
+    }
+
+    if (sim_core1 == SIM_CORE1_PRONTO) {
+        sim_rodar_core1();
+        return;
+    }
+
+    uint64_t alvo = sim_n_eventos > 0 ? sim_eventos[0].instante : sim_fim;
+    if (alvo <= sim_agora) {
+        alvo = sim_agora + 1; // eventos vencidos, mas mascarados: o tempo ainda corre
+    }
+    sim_avancar_ate(alvo);
+
+    if (sim_core1 == SIM_CORE1_OCIOSO) {
+        sim_rodar_core1();
+    }
+}
+
+// WFI: com interrupção já vencida retorna na hora (despachando-a se não estiver mascarada);
+// senão, fica ocioso até a próxima
+void sim_esperar_interrupcao(void) {
+    if (!sim_no_core1 && sim_n_eventos > 0 && sim_eventos[0].instante <= sim_agora) {
+        if (sim_mascara == 0) {
+            sim_avancar_ate(sim_agora);
+        }
+        return;
+    }
+    sim_ocioso();
+}
+
+// ---------------------------------------------------------------------------------------------
+// Configuração do cenário e encerramento
+
+void sim_definir_duracao(uint64_t fim_us) {
+    sim_fim = fim_us;
+}
+
+void sim_gravar_trace(const char *arquivo, bool incluir_display) {
+    sim_arquivo_trace = arquivo;
+    sim_trace_display = incluir_display;
+}
+
+void sim_exigir_aceso(uint gpio_a, uint gpio_b) {
+    sim_aceso = (sim_sempre_aceso_t){true, gpio_a, gpio_b, false, false, 0};
+}
+
+void sim_limitar_alto(uint gpio, uint32_t max_ms) {
+    sim_max_alto_us[gpio] = max_ms * 1000;
+}
+
+void sim_custo_irq(uint32_t custo_us) {
+    sim_custo_irq_us = custo_us;
+}
+
+void sim_mostrar_tela(bool mostrar) {
+    sim_tela_final = mostrar;
+}
+
+static bool sim_displays_iguais = false;
+
+void sim_exigir_displays_iguais(void) {
+    sim_displays_iguais = true;
+}
+
+bool sim_ler_display(uint bus, uint8_t endereco, uint8_t *gddram) {
+    for (int i = 0; i < SIM_MAX_DISPLAYS; i++) {
+        const sim_display_t *d = &sim_displays[i];
+        if (d->usado && d->bus == bus && d->endereco == endereco) {
+            memcpy(gddram, d->gddram, sizeof(d->gddram));
+            return true;
+        }
+    }
+    return false;
+}
+
+// Compara a GDDRAM final de todos os displays com a do primeiro; retorna quantos diferem
+static uint32_t sim_conferir_displays(void) {
+    const sim_display_t *primeiro = NULL;
+    uint32_t n = 0, diferentes = 0;
+    for (int i = 0; i < SIM_MAX_DISPLAYS; i++) {
+        const sim_display_t *d = &sim_displays[i];
+        if (!d->usado) {
+            continue;
+        }
+        n++;
+        if (primeiro == NULL) {
+            primeiro = d;
+        } else if (memcmp(d->gddram, primeiro->gddram, sizeof(d->gddram)) != 0) {
+            fprintf(stderr, "sim: display %u/0x%02x terminou diferente de %u/0x%02x\n",
+                    d->bus, d->endereco, primeiro->bus, primeiro->endereco);
+            diferentes++;
+        }
+    }
+    fprintf(stderr, "sim: %u displays, %u com conteudo final diferente\n", n, diferentes);
+    return diferentes;
+}
+
+static void sim_imprimir_tela(const sim_display_t *d) {
+    fprintf(stderr, "display %u/0x%02x (%u quadros):\n", d->bus, d->endereco, d->quadros);
+    for (int y = 0; y < 64; y++) {
+        char linha[129];
+        for (int x = 0; x < 128; x++) {
+            linha[x] = (d->gddram[y / 8][x] >> (y % 8)) & 1 ? '#' : '.';
+        }
+        linha[128] = '\0';
+        fprintf(stderr, "%s\n", linha);
+    }
+}
+
+int sim_finalizar(void) {
+    sim_pio_sincronizar_todas(); // Saídas da PIO até o fim do cenário
+    for (uint g = 0; g < SIM_MAX_GPIO; g++) {
+        sim_fechar_envoltoria(g);
+    }
+
+    if (sim_arquivo_trace != NULL) {
+        FILE *f = fopen(sim_arquivo_trace, "w");
+        if (f == NULL) {
+            perror(sim_arquivo_trace);
+            return 2;
+        }
+        fprintf(f, "tempo_us,tipo,id,valor\n");
+        for (size_t i = 0; i < sim_n_trace; i++) {
+            const sim_registro_t *r = &sim_trace[i];
+            if (r->tipo == 'g') {
+                fprintf(f, "%llu,gpio,%u,%u\n", (unsigned long long)r->instante, r->id, r->valor);
+            } else {
+                fprintf(f, "%llu,display,%u,%08x\n", (unsigned long long)r->instante, r->id, r->valor);
+            }
+        }
+        fclose(f);
+    }
+
+    for (int i = 0; i < SIM_MAX_DISPLAYS; i++) {
+        if (sim_displays[i].usado && sim_tela_final) {
+            sim_imprimir_tela(&sim_displays[i]);
+        }
+    }
+
+    fprintf(stderr, "sim: %.3f s simulados, %u transições de GPIO", sim_agora / 1e6, sim_transicoes);
+    for (uint g = 0; g < SIM_MAX_GPIO; g++) {
+        if (sim_max_alto_us[g]) {
+            fprintf(stderr, ", GPIO %u alto no máximo %llu us", g, (unsigned long long)sim_maior_alto_us[g]);
+        }
+    }
+    fprintf(stderr, "\n");
+
+    uint32_t violacoes = sim_aceso.violacoes + sim_violacoes_alto;
+    for (int i = 0; i < SIM_MAX_DISPLAYS; i++) {
+        const sim_display_t *d = &sim_displays[i];
+        if (d->usado && (d->rolagens > 0 || d->escritas_rolando > 0)) {
+            fprintf(stderr, "sim: display %u/0x%02x: %u quadros, %u ativacoes de scroll, %u escritas com scroll ativo\n",
+                    d->bus, d->endereco, d->quadros, d->rolagens, d->escritas_rolando);
+            violacoes += d->escritas_rolando;
+        }
+    }
+    for (uint bus = 0; bus < 2; bus++) {
+        if (sim_i2c_descartados[bus]) {
+            fprintf(stderr, "sim: I2C %u: %u bytes descartados da FIFO antes de sair no barramento\n",
+                    bus, sim_i2c_descartados[bus]);
+            violacoes += sim_i2c_descartados[bus];
+        }
+    }
+    if (sim_displays_iguais) {
+        violacoes += sim_conferir_displays();
+    }
+    if (sim_i2c_preso_desde != UINT64_MAX && sim_agora >= sim_i2c_preso_desde) {
+        if (sim_i2c_liberado_em) {
+            fprintf(stderr, "sim: I2C preso em %llu us, liberado em %llu us apos %u pulsos de SCL\n",
+                    (unsigned long long)sim_i2c_preso_desde, (unsigned long long)sim_i2c_liberado_em, sim_i2c_pulsos);
+        } else {
+            fprintf(stderr, "sim: I2C preso em %llu us e nunca liberado\n", (unsigned long long)sim_i2c_preso_desde);
+            violacoes++;
+        }
+    }
+    if (sim_aceso.ativa && !sim_aceso.armada) {
+        fprintf(stderr, "sim: GPIO %u e %u nunca acenderam\n", sim_aceso.pino_a, sim_aceso.pino_b);
+        violacoes++;
+    }
+    if (violacoes > 0) {
+        fprintf(stderr, "sim: %u violações de invariantes\n", violacoes);
+        return 1;
+    }
+    return 0;
+}
+
+// O firmware nunca retorna de main: o fim do cenário encerra o processo daqui
+static void sim_encerrar(void) {
+    if (sim_finalizando) {
+        return;
+    }
+    sim_finalizando = true;
+    fflush(stdout);
+    exit(sim_finalizar());
+}
@@ -0,0 +1,38 @@
+// Simulador de host: relógio virtual por eventos discretos, roteiro de botões e registro
+// (trace) de GPIO e do conteúdo dos displays, para rodar o firmware sem hardware
+#ifndef sim_h
+#define sim_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef unsigned int uint;
+
+// Configuração do cenário (chamadas por sim_main antes de iniciar o firmware)
+void sim_definir_duracao(uint64_t fim_us);
+void sim_agendar_botao(uint64_t instante_us, uint gpio, uint32_t duracao_ms, int repiques);
+void sim_pedestres_periodicos(uint gpio, uint32_t periodo_ms, uint32_t semente);
+void sim_gravar_trace(const char *arquivo, bool incluir_display);
+void sim_exigir_aceso(uint gpio_a, uint gpio_b);
+void sim_limitar_alto(uint gpio, uint32_t max_ms);
+void sim_custo_irq(uint32_t custo_us);
+void sim_mostrar_tela(bool mostrar);
+void sim_agendar_serial(uint64_t instante_us, const char *texto);
+void sim_definir_spi_dc(uint spi, uint gpio);
+void sim_exigir_displays_iguais(void);
+void sim_display_ausente(uint64_t ate_us);
+void sim_limitar_i2c(uint32_t max_khz, uint64_t desde_us);
+void sim_prender_i2c(uint64_t desde_us);
+
+// Encerra a simulação: grava o trace, imprime o resumo e retorna o código de saída
+int sim_finalizar(void);
+
+// Copia a GDDRAM de um display do modelo (página a página, como o framebuffer do driver), para
+// benchmarks conferirem o que chegou; retorna false se o display nunca recebeu nada
+bool sim_ler_display(uint bus, uint8_t endereco, uint8_t *gddram);
+
+// Chamada pelo firmware (tight_loop_contents, __wfi) quando está ocioso
+void sim_ocioso(void);
+void sim_esperar_interrupcao(void);
+
+#endif
@@ -0,0 +1,113 @@
+// Ponto de entrada do simulador: lê o cenário da linha de comando e roda o firmware
+//
+//   semaforo_sim --tempo 86400 --botao 5@15000 --botao 6@40000:3 --pedestre 5:45000
+//                --trace saida.csv --sempre-aceso 13,11 --max-alto 21:250 --serial 60000:R --silencioso
+//                --spi-dc 0:20 --displays-iguais --display-ausente 3000 --i2c-max-khz 500@20000
+//                --i2c-preso 30000
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+int firmware_main(void);
+
+static void uso(const char *programa) {
+    fprintf(stderr,
+            "uso: %s [opções]\n"
+            "  --tempo S                  duração simulada em segundos (padrão 60)\n"
+            "  --botao G@MS[:R[:D]]       aperta o GPIO G no instante MS (ms), com R repiques, por D ms\n"
+            "  --pedestre G:PERIODO_MS    um aperto aleatório do GPIO G a cada período\n"
+            "  --semente N                semente dos apertos aleatórios\n"
+            "  --trace ARQ                grava as mudanças de GPIO em CSV\n"
+            "  --trace-display            inclui no trace o hash de cada quadro dos displays\n"
+            "  --sempre-aceso A,B         falha se os GPIO A e B apagarem ao mesmo tempo\n"
+            "  --max-alto G:MS            falha se o GPIO G ficar alto por mais de MS ms\n"
+            "  --custo-irq US             tempo virtual gasto em cada interrupção\n"
+            "  --serial MS:TEXTO          envia TEXTO pela USB no instante MS (ms)\n"
+            "  --tela                     imprime o conteúdo final dos displays\n"
+            "  --spi-dc S:G               display no SPI S com o D/C# no GPIO G\n"
+            "  --displays-iguais          falha se os displays terminarem com conteúdos diferentes\n"
+            "  --display-ausente MS       nenhum display responde no I2C até o instante MS (ms)\n"
+            "  --i2c-max-khz K[@MS]       a partir de MS (ms), o I2C acima de K kHz termina em NAK\n"
+            "  --i2c-preso MS             SDA preso no instante MS (ms) até 9 pulsos de SCL por GPIO\n"
+            "  --silencioso               descarta a saída do firmware\n",
+            programa);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    double segundos = 60;
+    uint32_t semente = 1;
+    const char *trace = NULL;
+    bool trace_display = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *opcao = argv[i];
+        const char *valor = i + 1 < argc ? argv[i + 1] : NULL;
+        unsigned g, a, b;
+        unsigned long ms;
+        int repiques = 0;
+        unsigned duracao = 150;
+
+        if (!strcmp(opcao, "--tempo") && valor) {
+            segundos = atof(valor);
+            i++;
+        } else if (!strcmp(opcao, "--botao") && valor && sscanf(valor, "%u@%lu:%d:%u", &g, &ms, &repiques, &duracao) >= 2) {
+            sim_agendar_botao((uint64_t)ms * 1000, g, duracao, repiques);
+            i++;
+        } else if (!strcmp(opcao, "--pedestre") && valor && sscanf(valor, "%u:%lu", &g, &ms) == 2) {
+            sim_pedestres_periodicos(g, (uint32_t)ms, semente++);
+            i++;
+        } else if (!strcmp(opcao, "--semente") && valor) {
+            semente = (uint32_t)strtoul(valor, NULL, 0);
+            i++;
+        } else if (!strcmp(opcao, "--trace") && valor) {
+            trace = valor;
+            i++;
+        } else if (!strcmp(opcao, "--trace-display")) {
+            trace_display = true;
+        } else if (!strcmp(opcao, "--sempre-aceso") && valor && sscanf(valor, "%u,%u", &a, &b) == 2) {
+            sim_exigir_aceso(a, b);
+            i++;
+        } else if (!strcmp(opcao, "--max-alto") && valor && sscanf(valor, "%u:%lu", &g, &ms) == 2) {
+            sim_limitar_alto(g, (uint32_t)ms);
+            i++;
+        } else if (!strcmp(opcao, "--custo-irq") && valor) {
+            sim_custo_irq((uint32_t)strtoul(valor, NULL, 0));
+            i++;
+        } else if (!strcmp(opcao, "--serial") && valor && sscanf(valor, "%lu:", &ms) == 1 && strchr(valor, ':')) {
+            sim_agendar_serial((uint64_t)ms * 1000, strchr(valor, ':') + 1);
+            i++;
+        } else if (!strcmp(opcao, "--spi-dc") && valor && sscanf(valor, "%u:%u", &a, &g) == 2) {
+            sim_definir_spi_dc(a, g);
+            i++;
+        } else if (!strcmp(opcao, "--display-ausente") && valor) {
+            sim_display_ausente((uint64_t)strtoul(valor, NULL, 0) * 1000);
+            i++;
+        } else if (!strcmp(opcao, "--i2c-max-khz") && valor && sscanf(valor, "%u", &g) == 1) {
+            ms = 0;
+            sscanf(valor, "%u@%lu", &g, &ms);
+            sim_limitar_i2c(g, (uint64_t)ms * 1000);
+            i++;
+        } else if (!strcmp(opcao, "--i2c-preso") && valor) {
+            sim_prender_i2c((uint64_t)strtoul(valor, NULL, 0) * 1000);
+            i++;
+        } else if (!strcmp(opcao, "--displays-iguais")) {
+            sim_exigir_displays_iguais();
+        } else if (!strcmp(opcao, "--tela")) {
+            sim_mostrar_tela(true);
+        } else if (!strcmp(opcao, "--silencioso")) {
+            if (freopen("/dev/null", "w", stdout) == NULL) {
+                perror("/dev/null");
+            }
+        } else {
+            uso(argv[0]);
+        }
+    }
+
+    sim_definir_duracao((uint64_t)(segundos * 1e6));
+    sim_gravar_trace(trace, trace_display);
+
+    firmware_main();
+    return sim_finalizar();
+}
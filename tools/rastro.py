@@ -0,0 +1,204 @@
+#!/usr/bin/env python3
+"""Decodifica o rastro binário do firmware (inc/rastro.c) e imprime histogramas de latência.
+
+O despejo é pedido enviando 'R' pelo monitor serial (firmware compilado com SEMAFORO_RASTRO=ON)
+e pode vir misturado com o texto do printf; o decodificador procura o cabeçalho "RSTR".
+
+    python3 tools/rastro.py captura.bin
+    python3 tools/rastro.py --porta /dev/ttyACM0        # pede o despejo (requer pyserial)
+    python3 tools/rastro.py captura.bin --csv eventos.csv
+"""
+import argparse
+import struct
+import sys
+import time
+
+# Mesma numeração de rastro_evento_t (inc/rastro.h)
+IRQ_ENTRADA, IRQ_SAIDA, FASE, BUZZER_LIGA, BUZZER_DESLIGA, DISPLAY_PEDIDO, FLUSH_INICIO, FLUSH_FIM = range(1, 9)
+NOMES_EVENTOS = {
+    IRQ_ENTRADA: "irq_entrada", IRQ_SAIDA: "irq_saida", FASE: "fase", BUZZER_LIGA: "buzzer_liga",
+    BUZZER_DESLIGA: "buzzer_desliga", DISPLAY_PEDIDO: "display_pedido", FLUSH_INICIO: "flush_inicio",
+    FLUSH_FIM: "flush_fim",
+}
+FONTES = {1: "gpio", 2: "alarme", 3: "pio"}
+FONTES_BOTAO = (1, 3)
+
+# Mesma ordem de fase_id_t (inc/fases.h) e de ssd1306_flush_status_t (inc/ssd1306_i2c.h)
+FASES = ["Vermelho", "Verde", "Amarelo", "Amarelo (Centro)", "Amarelo (Bairro)",
+         "Travessia Centro", "Travessia Bairro"]
+FASES_AMARELO_PEDESTRE = (3, 4)
+FLUSH_INICIADO, FLUSH_ENFILEIRADO, FLUSH_SEM_MUDANCA = range(3)
+
+CABECALHO = b"RSTR"
+VERSAO = 1
+
+
+def decodificar(dados):
+    """Retorna a lista de registros (instante_us, nucleo, evento, dados) em ordem de tempo."""
+    inicio = dados.rfind(CABECALHO)  # O despejo mais recente da captura
+    if inicio < 0:
+        sys.exit("rastro: cabeçalho RSTR não encontrado")
+
+    versao, tamanho, nucleos = struct.unpack_from("<BBB", dados, inicio + 4)
+    if versao != VERSAO or tamanho != 16:
+        sys.exit(f"rastro: versão {versao} / registro de {tamanho} bytes não suportados")
+
+    posicao = inicio + 8
+    registros = []
+    for nucleo in range(nucleos):
+        gravados, quantidade = struct.unpack_from("<II", dados, posicao)
+        posicao += 8
+        if gravados > quantidade:
+            print(f"nucleo {nucleo}: {gravados - quantidade} registros antigos sobrescritos")
+        for _ in range(quantidade):
+            instante, valor, evento = struct.unpack_from("<QIB3x", dados, posicao)
+            posicao += tamanho
+            registros.append((instante, nucleo, evento, valor))
+
+    registros.sort(key=lambda r: r[0])
+    return registros
+
+
+def botao_ate_amarelo(registros):
+    """Do primeiro aperto ainda não atendido até a entrada no amarelo que antecede a travessia."""
+    amostras, aperto = [], None
+    for instante, _, evento, valor in registros:
+        if evento == IRQ_ENTRADA and valor >> 8 in FONTES_BOTAO and aperto is None:
+            aperto = instante
+        elif evento == FASE and valor & 0xFF in FASES_AMARELO_PEDESTRE and aperto is not None:
+            amostras.append(instante - aperto)
+            aperto = None
+    return amostras
+
+
+def fase_ate_display(registros, cruzamento=0):
+    """Da troca de fase até o display terminar de receber o quadro correspondente (DMA)."""
+    amostras = []
+    for i, (instante, _, evento, valor) in enumerate(registros):
+        if evento != FASE or valor >> 8 != cruzamento:
+            continue
+        fim = fim_do_quadro(registros, i + 1)
+        if fim is not None:
+            amostras.append(fim - instante)
+    return amostras
+
+
+def fim_do_quadro(registros, i):
+    """Instante em que o próximo quadro começado a partir do registro i chega ao display."""
+    while i < len(registros) and registros[i][2] != FLUSH_INICIO:
+        i += 1
+    if i == len(registros):
+        return None
+
+    status = registros[i][3] & 0xFF
+    if status == FLUSH_SEM_MUDANCA:
+        return registros[i][0]
+
+    # Enfileirado: espera o fim da transferência em curso e o do quadro pendente
+    faltam = 2 if status == FLUSH_ENFILEIRADO else 1
+    ultimo = None
+    for instante, _, evento, _ in registros[i + 1:]:
+        if evento == FLUSH_INICIO and ultimo is not None:
+            break
+        if evento == FLUSH_FIM:
+            ultimo = instante
+            faltam -= 1
+            if faltam == 0:
+                break
+    return ultimo
+
+
+def bytes_sujos(registros):
+    """Bytes do framebuffer marcados para envio em cada quadro desenhado (widgets alterados)."""
+    return [valor >> 8 for _, _, evento, valor in registros if evento == FLUSH_INICIO and valor >> 8]
+
+
+def duracao_irq(registros):
+    """Duração de cada interrupção por fonte, pareando entrada e saída no mesmo núcleo."""
+    por_fonte, abertas = {}, {}
+    for instante, nucleo, evento, valor in registros:
+        chave = (nucleo, valor)
+        if evento == IRQ_ENTRADA:
+            abertas[chave] = instante
+        elif evento == IRQ_SAIDA and chave in abertas:
+            fonte = FONTES.get(valor >> 8, str(valor >> 8))
+            por_fonte.setdefault(fonte, []).append(instante - abertas.pop(chave))
+    return por_fonte
+
+
+def histograma(titulo, amostras, unidade="us"):
+    """Histograma em faixas de potência de 2."""
+    print(f"\n{titulo}: ", end="")
+    if not amostras:
+        print("sem amostras")
+        return
+
+    ordenadas = sorted(amostras)
+    n = len(ordenadas)
+    print(f"{n} amostras, min {ordenadas[0]} {unidade}, mediana {ordenadas[n // 2]} {unidade}, "
+          f"p99 {ordenadas[min(n - 1, n * 99 // 100)]} {unidade}, max {ordenadas[-1]} {unidade}")
+
+    faixas = {}
+    for a in amostras:
+        faixas[a.bit_length()] = faixas.get(a.bit_length(), 0) + 1
+    maior = max(faixas.values())
+    for bits in range(min(faixas), max(faixas) + 1):
+        baixo, alto = (1 << bits - 1 if bits else 0), 1 << bits
+        quantidade = faixas.get(bits, 0)
+        barra = "#" * max(1 if quantidade else 0, quantidade * 50 // maior)
+        print(f"  {baixo:>9} - {alto - 1:>9} {unidade:<5} {quantidade:>7} {barra}")
+
+
+def capturar(porta, espera_s):
+    import serial  # pyserial, só necessário para capturar direto da placa
+
+    with serial.Serial(porta, timeout=espera_s) as s:
+        s.reset_input_buffer()
+        s.write(b"R")
+        dados = bytearray()
+        limite = time.monotonic() + espera_s
+        while time.monotonic() < limite:
+            pedaco = s.read(4096)
+            if not pedaco and CABECALHO in dados:
+                break
+            dados += pedaco
+        return bytes(dados)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("arquivo", nargs="?", help="captura da saída serial com o despejo")
+    parser.add_argument("--porta", help="porta serial da placa (envia 'R' e captura o despejo)")
+    parser.add_argument("--espera", type=float, default=3.0, help="segundos aguardando o despejo")
+    parser.add_argument("--csv", help="grava os registros decodificados em CSV")
+    parser.add_argument("--cruzamento", type=int, default=0, help="cruzamento com display (padrão 0)")
+    args = parser.parse_args()
+
+    if args.porta:
+        dados = capturar(args.porta, args.espera)
+    elif args.arquivo:
+        with open(args.arquivo, "rb") as f:
+            dados = f.read()
+    else:
+        parser.error("informe o arquivo ou --porta")
+
+    registros = decodificar(dados)
+    if not registros:
+        sys.exit("rastro: despejo vazio")
+    print(f"{len(registros)} registros, {(registros[-1][0] - registros[0][0]) / 1e6:.3f} s")
+
+    if args.csv:
+        with open(args.csv, "w") as f:
+            f.write("tempo_us,nucleo,evento,dados\n")
+            for instante, nucleo, evento, valor in registros:
+                f.write(f"{instante},{nucleo},{NOMES_EVENTOS.get(evento, evento)},{valor}\n")
+
+    histograma("Botao ate amarelo", botao_ate_amarelo(registros))
+    histograma("Fase ate display", fase_ate_display(registros, args.cruzamento))
+    histograma("Bytes sujos por quadro", bytes_sujos(registros), "bytes")
+    for fonte, amostras in sorted(duracao_irq(registros).items()):
+        histograma(f"Duracao da interrupcao ({fonte})", amostras)
+
+
+if __name__ == "__main__":
+    main()